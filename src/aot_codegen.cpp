@@ -0,0 +1,403 @@
+/*
+
+aot_codegen.cpp
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Implementation of ExpressionSet
+parsing and CppGenerator, which writes the
+optimized postfix program of each expression
+as one C++ statement per instruction.
+
+*/
+#include <cctype>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <sstream>
+#include <utility>
+
+#include "aot_codegen.h"
+#include "aot_runtime.h"
+#include "exp_solver.h"
+
+namespace exp_solver
+{
+static std::string Trim(const std::string &text) {
+    auto first = text.find_first_not_of(" \t\r");
+    if (first == std::string::npos) return std::string();
+    auto last = text.find_last_not_of(" \t\r");
+    return text.substr(first, last - first + 1);
+}
+
+// Keywords and alternative tokens of C++20, none can name a function or namespace
+static const char *const reserved_words[] = {
+    "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break",
+    "case", "catch", "char", "char8_t", "char16_t", "char32_t", "class", "compl", "concept",
+    "const", "consteval", "constexpr", "constinit", "const_cast", "continue", "co_await",
+    "co_return", "co_yield", "decltype", "default", "delete", "do", "double", "dynamic_cast",
+    "else", "enum", "explicit", "export", "extern", "false", "float", "for", "friend", "goto", "if",
+    "inline", "int", "long", "mutable", "namespace", "new", "noexcept", "not", "not_eq", "nullptr",
+    "operator", "or", "or_eq", "private", "protected", "public", "register", "reinterpret_cast",
+    "requires", "return", "short", "signed", "sizeof", "static", "static_assert", "static_cast",
+    "struct", "switch", "template", "this", "thread_local", "throw", "true", "try", "typedef",
+    "typeid", "typename", "union", "unsigned", "using", "virtual", "void", "volatile", "wchar_t",
+    "while", "xor", "xor_eq"
+};
+
+// Whether name can be declared in generated source, reserved words and names reserved
+// for the implementation are not
+static bool IsIdentifier(const std::string &name) {
+    if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0]))) return false;
+    for (char c : name) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') return false;
+    }
+    if (name.find("__") != std::string::npos ||
+        (name[0] == '_' && name.size() > 1 && std::isupper(static_cast<unsigned char>(name[1])))) {
+        return false;
+    }
+    for (const char *word : reserved_words) {
+        if (name == word) return false;
+    }
+    return true;
+}
+
+template <typename Names, typename Key>
+static bool Contains(const Names &names, const std::string &name, Key key) {
+    for (const auto &entry : names) {
+        if (key(entry) == name) return true;
+    }
+    return false;
+}
+
+bool ParseExpressionSet(const std::string &text, ExpressionSet &set, std::string &error) {
+    static const std::string declaration = "variables:";
+    set = ExpressionSet();
+    auto variable = [](const std::string &name) -> const std::string & { return name; };
+    auto function = [](const NamedExpression &named) -> const std::string & { return named.name; };
+
+    std::istringstream lines(text);
+    std::string        line;
+    size_t             number   = 0;
+    bool               declared = false;
+    auto               fail     = [&](const std::string &reason) {
+        error = "line " + std::to_string(number) + ": " + reason;
+        return false;
+    };
+    while (std::getline(lines, line)) {
+        number++;
+        auto comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+        line = Trim(line);
+        if (line.empty()) continue;
+
+        if (line.compare(0, declaration.size(), declaration) == 0) {
+            if (declared) return fail("variables are declared twice");
+            declared = true;
+            std::istringstream names(line.substr(declaration.size()));
+            std::string        name;
+            while (names >> name) {
+                if (!IsIdentifier(name)) return fail("\"" + name + "\" is not an identifier");
+                if (Contains(set.variables, name, variable)) {
+                    return fail("variable \"" + name + "\" is declared twice");
+                }
+                set.variables.push_back(name);
+            }
+            continue;
+        }
+
+        auto equal = line.find('=');
+        if (equal == std::string::npos) return fail("expected \"name = expression\"");
+        NamedExpression named{ Trim(line.substr(0, equal)), Trim(line.substr(equal + 1)) };
+        if (!IsIdentifier(named.name)) return fail("\"" + named.name + "\" is not an identifier");
+        if (named.expression.empty()) return fail("expression of \"" + named.name + "\" is empty");
+        if (Contains(set.expressions, named.name, function)) {
+            return fail("expression \"" + named.name + "\" is defined twice");
+        }
+        set.expressions.push_back(std::move(named));
+    }
+    if (set.expressions.empty()) {
+        error = "no expression in set";
+        return false;
+    }
+    return true;
+}
+
+uint64_t HashExpressionSet(const ExpressionSet &set) {
+    uint64_t hash = 14695981039346656037ull;
+    // '\0' ends each text so "ab","c" differs from "a","bc"
+    auto mix = [&hash](const std::string &text) {
+        for (size_t i = 0; i <= text.size(); i++) {
+            hash ^= i < text.size() ? static_cast<unsigned char>(text[i]) : 0;
+            hash *= 1099511628211ull;
+        }
+    };
+    mix(std::to_string(aot_format_version));
+    mix(std::to_string(set.variables.size()));
+    for (const auto &name : set.variables) mix(name);
+    for (const auto &named : set.expressions) {
+        mix(named.name);
+        mix(named.expression);
+    }
+    return hash;
+}
+
+bool CompileExpressionSet(const ExpressionSet &set, NumericMode mode, Backend backend,
+                          std::vector<CompiledExpression> &programs, std::string &error) {
+    ExpSolver solver(mode);
+    solver.SetBackend(backend);
+    // declared in order, so handle of i-th variable is i
+    for (const auto &name : set.variables) solver.UpdateVariable(name, Value(0));
+    programs.clear();
+    programs.reserve(set.expressions.size());
+    for (const auto &named : set.expressions) {
+        programs.push_back(solver.Compile(named.expression));
+        if (!programs.back().IsValid()) {
+            error = named.name + ": " + solver.GetErrorMessages();
+            return false;
+        }
+    }
+    return true;
+}
+
+// C++ of predefined function of name, empty if unknown
+static const char *FunctionOf(const std::string &name) {
+    static const std::pair<const char *, const char *> functions[] = {
+        { "sin", "std::sin" },     { "cos", "std::cos" },     { "tan", "std::tan" },
+        { "exp", "std::exp" },     { "sqrt", "std::sqrt" },   { "floor", "std::floor" },
+        { "ceil", "std::ceil" },   { "round", "std::round" }, { "ln", "std::log" },
+        { "log", "std::log10" },   { "abs", "std::fabs" },
+    };
+    for (const auto &function : functions) {
+        if (name == function.first) return function.second;
+    }
+    return "";
+}
+
+// Name of checked operator in double_ops and of its OpCode
+static const char *OperatorOf(OpCode code) {
+    switch (code) {
+        case OpCode::Pow: return "Pow";
+        case OpCode::Mul: return "Mul";
+        case OpCode::Div: return "Div";
+        case OpCode::FloorDiv: return "FloorDiv";
+        case OpCode::Mod: return "Mod";
+        case OpCode::Add: return "Add";
+        case OpCode::Sub: return "Sub";
+        case OpCode::Shl: return "Shl";
+        case OpCode::Shr: return "Shr";
+        case OpCode::And: return "And";
+        case OpCode::Xor: return "Xor";
+        case OpCode::Or: return "Or";
+        default: return "";
+    }
+}
+
+// Double literal that reads back to the same value
+static std::string DoubleLiteral(double value) {
+    if (std::isnan(value)) return "std::numeric_limits<double>::quiet_NaN()";
+    if (std::isinf(value)) {
+        return value < 0 ? "(-std::numeric_limits<double>::infinity())"
+                         : "std::numeric_limits<double>::infinity()";
+    }
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.17g", value);
+    std::string literal(text);
+    if (literal.find_first_of(".e") == std::string::npos) literal += ".0";
+    return std::signbit(value) ? "(" + literal + ")" : literal;
+}
+
+static std::string IntegerLiteral(int64_t value) {
+    if (value == std::numeric_limits<int64_t>::min()) return "(-9223372036854775807 - 1)";
+    return std::to_string(value);
+}
+
+CppGenerator::CppGenerator(Signature signature, std::string space) :
+    signature(signature), space(std::move(space)) {}
+
+std::string CppGenerator::Literal(const Value &literal) const {
+    if (signature == Signature::Double) return DoubleLiteral(literal.GetValueDouble());
+    if (literal.IsDecimal()) {
+        return "exp_solver::Value(" + DoubleLiteral(literal.GetValueDouble()) + ")";
+    }
+    auto fraction = literal.GetFracValue();
+    return "exp_solver::Value(exp_solver::Fraction(" + IntegerLiteral(fraction.up) + ", " +
+           IntegerLiteral(fraction.down) + "))";
+}
+
+bool CppGenerator::Generate(const ExpressionSet &set, std::ostream &out) {
+    error.clear();
+    if (!IsIdentifier(space)) {
+        error = "\"" + space + "\" is not a namespace name";
+        return false;
+    }
+    auto                            isDouble = signature == Signature::Double;
+    std::vector<CompiledExpression> programs;
+    if (!CompileExpressionSet(set, isDouble ? NumericMode::Double : NumericMode::Rational,
+                              Backend::Stack, programs, error)) {
+        return false;
+    }
+
+    // written to out only once every function is generated
+    std::ostringstream source;
+    source << "// Generated by exp_codegen from an expression set, do not edit\n//\n"
+           << "// variables, values[i] is value of i-th one:";
+    for (const auto &name : set.variables) source << ' ' << name;
+    source << "\n#include <cmath>\n#include <limits>\n#include \"aot_runtime.h\"\n";
+    if (!isDouble) source << "#include \"numeric_policy.h\"\n";
+    source << "\nnamespace " << space << "\n{\n";
+    for (size_t i = 0; i < programs.size(); i++) {
+        if (i != 0) source << '\n';
+        if (!EmitFunction(set.expressions[i], programs[i], source)) return false;
+    }
+    source << "} // namespace " << space << '\n';
+
+    // table of AotLibrary, functions over Value are only built into binaries
+    if (isDouble) {
+        char hash[24];
+        std::snprintf(hash, sizeof(hash), "0x%016" PRIx64 "ull", HashExpressionSet(set));
+        source << "\nnamespace\n{\nconst exp_solver::AotEntry entries[] = {\n";
+        for (const auto &named : set.expressions) {
+            source << "    { \"" << named.name << "\", " << space << "::" << named.name << " },\n";
+        }
+        source << "};\n\nconst exp_solver::AotTable table = { " << aot_format_version << ", "
+               << hash << ", " << set.expressions.size() << ", entries };\n} // namespace\n\n"
+               << "EXP_AOT_EXPORT const exp_solver::AotTable *" << aot_table_symbol << "() {\n"
+               << "    return &table;\n}\n";
+    }
+    out << source.str();
+    if (!out) {
+        error = "failed to write source";
+        return false;
+    }
+    return true;
+}
+
+bool CppGenerator::EmitFunction(const NamedExpression &named, const CompiledExpression &program,
+                                std::ostream &out) {
+    auto        isDouble = signature == Signature::Double;
+    std::string type     = isDouble ? "double" : "exp_solver::Value";
+    std::string policy   = "exp_solver::NumericPolicy<exp_solver::Value>::";
+
+    // operands of instructions, left operand is on top
+    std::vector<std::string> stack, temps(program.tempCount);
+    std::ostringstream       body;
+    size_t                   results = 0;
+    // whether body reads error, status and values
+    bool usesError = false, usesStatus = !isDouble, usesValues = false;
+    auto                     pop     = [&stack]() {
+        auto operand = std::move(stack.back());
+        stack.pop_back();
+        return operand;
+    };
+    auto assign = [&](const std::string &expression) {
+        auto result = "t" + std::to_string(results++);
+        body << "    const " << type << ' ' << result << " = " << expression << ";\n";
+        stack.push_back(result);
+    };
+    auto check = [&](const char *code) {
+        usesError  = true;
+        usesStatus = true;
+        body << "    if (error != exp_solver::ValueError::None) {\n"
+             << "        return exp_solver::aot::Fail<" << type << ">(status, exp_solver::ErrorCode::"
+             << code << ", error);\n    }\n";
+    };
+
+    for (const auto &instruction : program.code) {
+        auto code = instruction.code;
+        switch (code) {
+            case OpCode::PushValue: stack.push_back(Literal(program.literals[instruction.arg])); break;
+            case OpCode::PushVar:
+                usesValues = true;
+                stack.push_back("values[" + std::to_string(instruction.arg) + "]");
+                break;
+            case OpCode::Store: temps[instruction.arg] = stack.back(); break;
+            case OpCode::Load: stack.push_back(temps[instruction.arg]); break;
+            case OpCode::CallSqrt:
+            case OpCode::Call: {
+                const auto &name     = program.functions[instruction.arg].name;
+                std::string function = FunctionOf(name);
+                if (function.empty()) {
+                    error = named.name + ": function \"" + name + "\" has no C++ equivalent";
+                    return false;
+                }
+                auto operand = pop();
+                if (code == OpCode::CallSqrt) {
+                    usesStatus = true;
+                    body << "    if ("
+                         << (isDouble ? operand + " < 0" : policy + "IsNegative(" + operand + ")")
+                         << ") {\n        return exp_solver::aot::Fail<" << type
+                         << ">(status, exp_solver::ErrorCode::NegativeSqrt);\n    }\n";
+                }
+                if (isDouble) {
+                    assign(function + "(" + operand + ")");
+                } else {
+                    assign(policy + "Call([](double v) { return " + function + "(v); }, " +
+                           operand + ", error)");
+                    check("ValueFailure");
+                }
+                break;
+            }
+            case OpCode::Invert:
+                if (isDouble) {
+                    assign("exp_solver::double_ops::Invert(" + pop() + ", error)");
+                    check("CalculationAborted");
+                } else {
+                    assign("~" + pop());
+                }
+                break;
+            case OpCode::Neg: assign("-" + pop()); break;
+            case OpCode::Add:
+            case OpCode::Sub:
+            case OpCode::Mul:
+                if (isDouble) {
+                    auto symbol = code == OpCode::Add ? " + " : code == OpCode::Sub ? " - " : " * ";
+                    auto left   = pop();
+                    auto right  = pop();
+                    assign(left + symbol + right);
+                    break;
+                }
+                // fall through
+            default: {
+                std::string op = OperatorOf(code);
+                if (op.empty()) {
+                    error = named.name + ": unknown instruction";
+                    return false;
+                }
+                auto left  = pop();
+                auto right = pop();
+                if (isDouble) {
+                    assign("exp_solver::double_ops::" + op + "(" + left + ", " + right + ", error)");
+                    check("CalculationAborted");
+                } else {
+                    assign("exp_solver::ApplyOperator(exp_solver::OpCode::" + op + ", " + left +
+                           ", " + right + ")");
+                }
+                break;
+            }
+        }
+    }
+    if (stack.size() != 1) {
+        error = named.name + ": unbalanced program";
+        return false;
+    }
+
+    // Value carries its error, checked once like TypedEvaluator<Value>::Finish
+    if (!isDouble) {
+        body << "    const exp_solver::ValueError failure = " << policy << "ErrorOf(" << stack[0]
+             << ");\n    if (failure != exp_solver::ValueError::None) {\n"
+             << "        return exp_solver::aot::Fail<" << type
+             << ">(status, exp_solver::ErrorCode::CalculationAborted, failure);\n    }\n";
+    }
+    out << "// " << named.name << " = " << named.expression << '\n'
+        << "inline " << type << ' ' << named.name << "(const " << type
+        << " *values, exp_solver::AotStatus &status) {\n";
+    if (!usesValues) out << "    static_cast<void>(values);\n";
+    if (!usesStatus) out << "    static_cast<void>(status);\n";
+    if (usesError) out << "    exp_solver::ValueError error = exp_solver::ValueError::None;\n";
+    out << body.str() << "    return " << stack[0] << ";\n}\n";
+    return true;
+}
+} // namespace exp_solver
@@ -0,0 +1,101 @@
+/*
+
+aot_codegen.h
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Header file for ExpressionSet, a
+file of named expressions over shared variables,
+and CppGenerator, which writes a set as C++
+source with one inline function per expression,
+to be built into a binary or a shared object.
+
+*/
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "compiled_exp.h"
+
+namespace exp_solver
+{
+struct NamedExpression {
+    std::string name;
+    std::string expression;
+};
+
+// Expressions sharing variables, a variable is i-th value of every function of the set
+struct ExpressionSet {
+    std::vector<std::string>     variables;
+    std::vector<NamedExpression> expressions;
+};
+
+/**
+ * @brief parse text of an expression set, one entry per line, '#' starts a comment
+ * @example
+ *      # rules of pricing
+ *      variables: spot strike rate
+ *      payoff = abs(spot - strike)
+ *      discount = exp(-rate)
+ * @param error reason and line of fail
+ * @return false for fail, names must be C++ identifiers that are not keywords, unique
+ *         and declared once
+ */
+bool ParseExpressionSet(const std::string &text, ExpressionSet &set, std::string &error);
+
+// Hash of variables, names and expressions of set, with the version of generated code
+uint64_t HashExpressionSet(const ExpressionSet &set);
+
+/**
+ * @brief compile every expression of set in mode, variables of set are slots 0 to n - 1
+ * @param error name and reason of the first expression fails
+ * @return false for fail
+ */
+bool CompileExpressionSet(const ExpressionSet &set, NumericMode mode, Backend backend,
+                          std::vector<CompiledExpression> &programs, std::string &error);
+
+/**
+ * @brief writer of C++ source of an expression set, each expression becomes
+ *        inline double name(const double *values, exp_solver::AotStatus &status)
+ *        or the same over exp_solver::Value, status is set for fail
+ * @note functions in double give the same results and errors as TypedEvaluator<double>
+ *       of the program compiled in NumericMode::Double, and need only the headers of
+ *       this library. Their source also exports the AotTable AotLibrary loads, so it
+ *       is built as a shared object or into one binary per set. Functions over Value
+ *       give the same as ExpSolver::Evaluate, link libexp_solver and export nothing,
+ *       so their source can be included as a header
+ */
+class CppGenerator {
+public:
+    enum class Signature : uint8_t { Double, Value };
+
+    /**
+     * @param signature  number type of generated functions
+     * @param space      namespace of generated functions
+     */
+    explicit CppGenerator(Signature signature = Signature::Double,
+                          std::string space   = "exp_aot");
+
+    /**
+     * @brief write C++ source of set to out
+     * @return false for fail, use GetError() get fail reason
+     */
+    bool Generate(const ExpressionSet &set, std::ostream &out);
+
+    const std::string &GetError() const { return error; }
+
+private:
+    // Write body of function computing program to out
+    bool EmitFunction(const NamedExpression &named, const CompiledExpression &program,
+                      std::ostream &out);
+
+    // C++ expression of literal
+    std::string Literal(const Value &literal) const;
+
+    Signature   signature;
+    std::string space;
+    std::string error;
+};
+} // namespace exp_solver
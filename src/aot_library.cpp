@@ -0,0 +1,126 @@
+/*
+
+aot_library.cpp
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Implementation of AotLibrary.
+
+*/
+#include "aot_library.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#    include <dlfcn.h>
+#    define EXP_AOT_DLOPEN 1
+#else
+#    define EXP_AOT_DLOPEN 0
+#endif // dlopen
+
+namespace exp_solver
+{
+AotLibrary::AotLibrary(const ExpressionSet &set, const std::string &path) :
+    variableCount(set.variables.size()) {
+    for (const auto &named : set.expressions) names.push_back(named.name);
+    // programs are compiled even for a native library, so a set that no longer
+    // compiles is reported the same way whether the library is there or not
+    if (!CompileExpressionSet(set, NumericMode::Double, Backend::Auto, programs, loadError)) {
+        programs.clear();
+        return;
+    }
+    Load(path, HashExpressionSet(set));
+    if (IsNative()) {
+        programs.clear();
+        return;
+    }
+    // evaluators refer to programs, which don't move any more
+    evaluators.reserve(programs.size());
+    for (const auto &program : programs) evaluators.emplace_back(program);
+}
+
+AotLibrary::~AotLibrary() {
+#if EXP_AOT_DLOPEN
+    if (handle != nullptr) dlclose(handle);
+#endif
+}
+
+void AotLibrary::Load(const std::string &path, uint64_t hash) {
+#if EXP_AOT_DLOPEN
+    state  = AotState::Missing;
+    handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle == nullptr) {
+        auto reason = dlerror();
+        loadError   = reason != nullptr ? reason : "can't load " + path;
+        return;
+    }
+    using TableEntry = const AotTable *(*)();
+    auto entry       = reinterpret_cast<TableEntry>(dlsym(handle, aot_table_symbol));
+    auto table       = entry != nullptr ? entry() : nullptr;
+    if (table == nullptr) {
+        loadError = path + " has no table of expressions";
+    } else if (table->version != aot_format_version || table->hash != hash ||
+               table->count != names.size()) {
+        state     = AotState::Stale;
+        loadError = path + " is generated from another expression set";
+    } else {
+        for (size_t i = 0; i < table->count; i++) {
+            if (names[i] != table->entries[i].name) {
+                state     = AotState::Stale;
+                loadError = path + " is generated from another expression set";
+                functions.clear();
+                break;
+            }
+            functions.push_back(table->entries[i].function);
+        }
+        if (state != AotState::Stale) state = AotState::Native;
+    }
+    if (state != AotState::Native) {
+        dlclose(handle);
+        handle = nullptr;
+    }
+#else
+    static_cast<void>(hash);
+    state     = AotState::Missing;
+    loadError = "can't load " + path + ", shared objects are not supported on this platform";
+#endif
+}
+
+int AotLibrary::Find(const std::string &name) const {
+    for (size_t i = 0; i < names.size(); i++) {
+        if (names[i] == name) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+bool AotLibrary::Evaluate(int index, const std::vector<double> &values, double &result) {
+    errors.Clear();
+    if (state == AotState::Invalid) {
+        errors.Add(ErrorCode::InvalidExpression);
+        return false;
+    }
+    if (index < 0 || static_cast<size_t>(index) >= names.size()) {
+        errors.Add(ErrorCode::InvalidHandle, index);
+        return false;
+    }
+    if (values.size() < variableCount) {
+        errors.Add(ErrorCode::ContextMissesVariables);
+        return false;
+    }
+    if (IsNative()) {
+        AotStatus status;
+        auto      value = functions[index](values.data(), status);
+        if (status.failed) {
+            errors.Add(status.code, -1, 0, status.error);
+            return false;
+        }
+        result = value;
+        return true;
+    }
+    auto &evaluator = evaluators[index];
+    if (evaluator.Evaluate(values, result)) return true;
+    for (const auto &record : evaluator.GetErrors()) {
+        errors.Add(record.code, record.offset, record.length, record.valueError);
+    }
+    return false;
+}
+} // namespace exp_solver
@@ -0,0 +1,111 @@
+/*
+
+aot_library.h
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Header file for AotLibrary, the
+functions of an expression set loaded from a
+shared object built from exp_codegen output,
+or its programs run by the interpreter when the
+shared object is missing or stale.
+
+*/
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "aot_codegen.h"
+#include "aot_runtime.h"
+#include "exp_error.h"
+#include "typed_eval.h"
+
+namespace exp_solver
+{
+// Where functions of AotLibrary run
+enum class AotState : uint8_t {
+    // functions of shared object
+    Native,
+    // shared object can't be loaded or has no table, interpreted
+    Missing,
+    // shared object is built from another set or generator version, interpreted
+    Stale,
+    // set fails to compile, nothing runs
+    Invalid
+};
+
+/**
+ * @brief expression set evaluated in double by its ahead of time compiled functions
+ * @note the library is used only if the hash of its table matches the set, so an
+ *       edited rule never runs old code. Results and errors are the same as
+ *       TypedEvaluator<double> either way. Loading needs dlopen, other platforms
+ *       always interpret
+ * @example
+ *      ExpressionSet set;
+ *      ParseExpressionSet(text, set, error);
+ *      AotLibrary rules(set, "librules.so");
+ *      double payoff;
+ *      rules.Evaluate(rules.Find("payoff"), { 110, 100 }, payoff);
+ */
+class AotLibrary {
+public:
+    /**
+     * @param set  expressions the shared object is generated from
+     * @param path path of shared object given to dlopen
+     */
+    AotLibrary(const ExpressionSet &set, const std::string &path);
+    ~AotLibrary();
+
+    // owns handle of shared object
+    AotLibrary(const AotLibrary &)            = delete;
+    AotLibrary &operator=(const AotLibrary &) = delete;
+
+    AotState GetState() const { return state; }
+
+    // Whether functions run native code
+    bool IsNative() const { return state == AotState::Native; }
+
+    // Why shared object is not used, empty if it is
+    const std::string &GetLoadError() const { return loadError; }
+
+    // Count of expressions of set
+    size_t GetCount() const { return names.size(); }
+
+    // Count of values Evaluate needs, values[i] is value of i-th variable of set
+    size_t GetVariableCount() const { return variableCount; }
+
+    // Index of expression of name, -1 if not in set
+    int Find(const std::string &name) const;
+
+    /**
+     * @brief evaluate expression with values of variables
+     * @param index  index of expression, see Find
+     * @param values values[i] is value of i-th variable of set
+     * @param result result of output, not changed for fail
+     * @return false for fail, use GetErrorMessages() get fail reason
+     */
+    bool Evaluate(int index, const std::vector<double> &values, double &result);
+
+    // Text of errors of the latest call
+    std::string GetErrorMessages() const { return errors.Render(std::string()); }
+
+    const std::vector<ErrorRecord> &GetErrors() const { return errors.GetRecords(); }
+
+private:
+    // Use functions of table if it is built from this set
+    void Load(const std::string &path, uint64_t hash);
+
+    std::vector<std::string> names;
+    size_t                   variableCount;
+    AotState                 state{ AotState::Invalid };
+    std::string              loadError;
+    void                    *handle{ nullptr };
+    // native function of each expression
+    std::vector<AotFunction> functions;
+    // interpreter of each expression when not native, evaluators refer to programs
+    std::vector<CompiledExpression>     programs;
+    std::vector<TypedEvaluator<double>> evaluators;
+    ErrorList                           errors;
+};
+} // namespace exp_solver
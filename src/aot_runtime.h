@@ -0,0 +1,81 @@
+/*
+
+aot_runtime.h
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Header only support of C++ code
+generated ahead of time by exp_codegen, the
+status of generated functions and the table a
+generated shared object exports to AotLibrary.
+
+*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include "double_ops.h"
+#include "exp_error.h"
+
+#if defined(_WIN32)
+#    define EXP_AOT_EXPORT extern "C" __declspec(dllexport)
+#else
+#    define EXP_AOT_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+namespace exp_solver
+{
+// Failure of a generated function, not changed when it succeeds
+struct AotStatus {
+    bool       failed{ false };
+    ErrorCode  code{ ErrorCode::CalculationAborted };
+    ValueError error{ ValueError::None };
+};
+
+// Generated function in double, values[i] is value of i-th variable of its set
+using AotFunction = double (*)(const double *values, AotStatus &status);
+
+struct AotEntry {
+    const char *name;
+    AotFunction function;
+};
+
+// Table exported by a generated shared object, returned by its function of aot_table_symbol
+struct AotTable {
+    // aot_format_version of the generator
+    uint32_t version;
+    // hash of expression set, see HashExpressionSet
+    uint64_t        hash;
+    size_t          count;
+    const AotEntry *entries;
+};
+
+// Version of generated code, a library of another version is stale
+static constexpr uint32_t aot_format_version = 1;
+// Name of exported function returning the table, const AotTable *(*)()
+static constexpr const char *aot_table_symbol = "exp_aot_table";
+
+namespace aot
+{
+// Result of a failed generated function
+template <typename T>
+inline T Failed() {
+    return T();
+}
+
+template <>
+inline double Failed<double>() {
+    return std::numeric_limits<double>::quiet_NaN();
+}
+
+// Record fail in status, returns result of failed function
+template <typename T>
+inline T Fail(AotStatus &status, ErrorCode code, ValueError error = ValueError::None) {
+    status.failed = true;
+    status.code   = code;
+    status.error  = error;
+    return Failed<T>();
+}
+} // namespace aot
+} // namespace exp_solver
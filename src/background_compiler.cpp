@@ -0,0 +1,67 @@
+/*
+
+background_compiler.cpp
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Implementation of BackgroundCompiler.
+
+*/
+#include <utility>
+
+#include "background_compiler.h"
+
+namespace exp_solver
+{
+BackgroundCompiler::BackgroundCompiler() : worker(&BackgroundCompiler::WorkerLoop, this) {}
+
+BackgroundCompiler::~BackgroundCompiler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        jobs.clear();
+    }
+    wakeWorker.notify_one();
+    worker.join();
+}
+
+void BackgroundCompiler::Submit(Job job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    wakeWorker.notify_one();
+}
+
+void BackgroundCompiler::Wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    jobsDone.wait(lock, [this] { return jobs.empty() && !running; });
+}
+
+uint64_t BackgroundCompiler::GetCompletedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return completed;
+}
+
+void BackgroundCompiler::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wakeWorker.wait(lock, [this] { return stopping || !jobs.empty(); });
+        if (stopping) break;
+        auto job = std::move(jobs.front());
+        jobs.pop_front();
+        running = true;
+        lock.unlock();
+        job();
+        // job holds programs and solvers, they are released out of the lock
+        job = nullptr;
+        lock.lock();
+        running = false;
+        completed++;
+        if (jobs.empty()) jobsDone.notify_all();
+    }
+    // wake waiters of dropped jobs
+    jobsDone.notify_all();
+}
+} // namespace exp_solver
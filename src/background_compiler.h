@@ -0,0 +1,61 @@
+/*
+
+background_compiler.h
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Header file for BackgroundCompiler,
+one thread shared by solvers that compiles hot
+expressions into their optimized tier while the
+solvers keep running the cheap one.
+
+*/
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace exp_solver
+{
+/**
+ * @brief thread running jobs one after another in submit order, see ExpSolver::SetTiering
+ * @note jobs only make programs faster, so jobs not started yet are dropped when
+ *       the compiler is destroyed
+ */
+class BackgroundCompiler {
+public:
+    using Job = std::function<void()>;
+
+    BackgroundCompiler();
+    ~BackgroundCompiler();
+
+    BackgroundCompiler(const BackgroundCompiler &)            = delete;
+    BackgroundCompiler &operator=(const BackgroundCompiler &) = delete;
+
+    // Queue job to run on the compiler thread, job must not throw
+    void Submit(Job job);
+
+    // Block until every job submitted before is done
+    void Wait();
+
+    // Count of jobs done
+    uint64_t GetCompletedCount() const;
+
+private:
+    void WorkerLoop();
+
+    mutable std::mutex      mutex;
+    std::condition_variable wakeWorker, jobsDone;
+    std::deque<Job>         jobs;
+    // a job is taken off jobs and running
+    bool     running{ false };
+    bool     stopping{ false };
+    uint64_t completed{ 0 };
+    // started last, once the members above are ready
+    std::thread worker;
+};
+} // namespace exp_solver
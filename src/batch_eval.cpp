@@ -0,0 +1,169 @@
+/*
+
+batch_eval.cpp
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Implementation of BatchEvaluator.
+
+*/
+#include <algorithm>
+#include <limits>
+
+#include "batch_eval.h"
+#include "double_ops.h"
+
+namespace exp_solver
+{
+static constexpr double not_a_number = std::numeric_limits<double>::quiet_NaN();
+
+constexpr size_t BatchEvaluator::chunk_size;
+
+// Apply op on every row, simple loops so compiler can vectorize them
+template <typename Op>
+static inline void Unary(const double *a, double *out, size_t n, Op op) {
+    for (size_t i = 0; i < n; i++) out[i] = op(a[i]);
+}
+
+template <typename Op>
+static inline void Binary(const double *a, const double *b, double *out, size_t n, Op op) {
+    for (size_t i = 0; i < n; i++) out[i] = op(a[i], b[i]);
+}
+
+// Apply checked operator of double_ops on every row, rows it rejects get NaN
+template <typename Op>
+static inline void Checked(const double *a, const double *b, double *out, size_t n, Op op) {
+    Binary(a, b, out, n, [op](double x, double y) {
+        ValueError error = ValueError::None;
+        return op(x, y, error);
+    });
+}
+
+// Kernel of '/' or '//' for rows, unless a row divides by zero and fails like Value,
+// out may be b, so divisors are checked before
+template <typename Kernel, typename Op>
+static inline void Divide(const double *a, const double *b, double *out, size_t n,
+                          Kernel kernel, Op op) {
+    if (std::find(b, b + n, 0.0) == b + n) {
+        kernel(a, b, out, n);
+    } else {
+        Checked(a, b, out, n, op);
+    }
+}
+
+BatchEvaluator::BatchEvaluator(const CompiledExpression &program,
+                               std::vector<const double *> columns, std::vector<double> scalars,
+                               const BatchKernels &kernels) :
+    program(program),
+    columns(std::move(columns)),
+    scalars(std::move(scalars)),
+    kernels(kernels),
+    stack(program.stackDepth),
+    scratch(program.stackDepth * chunk_size),
+    temps(program.tempCount * chunk_size) {
+    literals.reserve(program.literals.size());
+    for (const auto &literal : program.literals) literals.push_back(literal.GetValueDouble());
+    functionKernels.reserve(program.functions.size());
+    for (const auto &function : program.functions) {
+        functionKernels.push_back(FindFunctionKernel(kernels, function.name.c_str()));
+    }
+}
+
+void BatchEvaluator::Run(size_t begin, size_t end, double *output) {
+    if (!program.IsValid()) {
+        std::fill(output + begin, output + end, not_a_number);
+        return;
+    }
+    for (size_t row = begin; row < end; row += chunk_size) {
+        RunChunk(row, std::min(chunk_size, end - row), output + row);
+    }
+}
+
+void BatchEvaluator::RunChunk(size_t begin, size_t count, double *output) {
+    size_t top = 0;
+
+    for (const auto &instruction : program.code) {
+        switch (instruction.code) {
+            case OpCode::PushValue: {
+                auto *out = &scratch[top * chunk_size];
+                std::fill(out, out + count, literals[instruction.arg]);
+                stack[top++] = out;
+                break;
+            }
+            case OpCode::Store: {
+                auto *out = &temps[instruction.arg * chunk_size];
+                std::copy(stack[top - 1], stack[top - 1] + count, out);
+                break;
+            }
+            case OpCode::Load: stack[top++] = &temps[instruction.arg * chunk_size]; break;
+            case OpCode::PushVar: {
+                auto slot = static_cast<size_t>(instruction.arg);
+                if (slot < columns.size() && columns[slot]) {
+                    stack[top++] = columns[slot] + begin;
+                } else {
+                    auto *out = &scratch[top * chunk_size];
+                    std::fill(out, out + count, slot < scalars.size() ? scalars[slot] : not_a_number);
+                    stack[top++] = out;
+                }
+                break;
+            }
+            case OpCode::Call:
+            case OpCode::CallSqrt: {
+                // sqrt of negative number is NaN already
+                auto *out = &scratch[(top - 1) * chunk_size];
+                if (auto kernel = functionKernels[instruction.arg]) {
+                    kernel(stack[top - 1], out, count);
+                } else {
+                    Unary(stack[top - 1], out, count, program.functions[instruction.arg].func);
+                }
+                stack[top - 1] = out;
+                break;
+            }
+            case OpCode::Neg: {
+                auto *out = &scratch[(top - 1) * chunk_size];
+                kernels.neg(stack[top - 1], out, count);
+                stack[top - 1] = out;
+                break;
+            }
+            case OpCode::Invert: {
+                auto *out = &scratch[(top - 1) * chunk_size];
+                Unary(stack[top - 1], out, count, [](double x) {
+                    ValueError error  = ValueError::None;
+                    auto       result = double_ops::Invert(x, error);
+                    return error == ValueError::None ? result : not_a_number;
+                });
+                stack[top - 1] = out;
+                break;
+            }
+            default: {
+                // binary operator, left operand is on top
+                top--;
+                const auto *a   = stack[top];
+                const auto *b   = stack[top - 1];
+                auto       *out = &scratch[(top - 1) * chunk_size];
+                switch (instruction.code) {
+                    case OpCode::Pow: Checked(a, b, out, count, double_ops::Pow); break;
+                    case OpCode::Mul: kernels.mul(a, b, out, count); break;
+                    case OpCode::Div: Divide(a, b, out, count, kernels.div, double_ops::Div); break;
+                    case OpCode::FloorDiv:
+                        Divide(a, b, out, count, kernels.floorDiv, double_ops::FloorDiv);
+                        break;
+                    case OpCode::Mod: Checked(a, b, out, count, double_ops::Mod); break;
+                    case OpCode::Add: kernels.add(a, b, out, count); break;
+                    case OpCode::Sub: kernels.sub(a, b, out, count); break;
+                    case OpCode::Shl: Checked(a, b, out, count, double_ops::Shl); break;
+                    case OpCode::Shr: Checked(a, b, out, count, double_ops::Shr); break;
+                    case OpCode::And: Checked(a, b, out, count, double_ops::And); break;
+                    case OpCode::Xor: Checked(a, b, out, count, double_ops::Xor); break;
+                    case OpCode::Or: Checked(a, b, out, count, double_ops::Or); break;
+                    default: std::fill(out, out + count, not_a_number); break;
+                }
+                stack[top - 1] = out;
+                break;
+            }
+        }
+    }
+    std::copy(stack[0], stack[0] + count, output);
+}
+} // namespace exp_solver
@@ -0,0 +1,64 @@
+/*
+
+batch_eval.h
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Header file for BatchEvaluator that
+evaluates a CompiledExpression over columns of
+variable values, one operator over many rows
+at a time.
+
+*/
+#pragma once
+#include <vector>
+#include "compiled_exp.h"
+#include "simd_kernels.h"
+
+namespace exp_solver
+{
+/**
+ * @brief double precision evaluator of a compiled program over rows
+ * @note '+', '-' and '*' follow IEEE double, other operators are checked like
+ *       Value, so bit operators, '%' and '~' need integer operands and division
+ *       by zero fails, any row that fails gets NaN
+ */
+class BatchEvaluator {
+public:
+    // rows computed per operator step, so scratch stays in L1 cache
+    static constexpr size_t chunk_size = 256;
+
+    /**
+     * @param program compiled program, must be valid and outlive the evaluator
+     * @param columns columns[slot] is values of variable in slot for every row,
+     *                nullptr or missing means use scalars[slot] for all rows
+     * @param scalars value of every variable slot
+     * @param kernels kernels of arithmetic, the highest level supported by default
+     */
+    BatchEvaluator(const CompiledExpression &program, std::vector<const double *> columns,
+                   std::vector<double> scalars, const BatchKernels &kernels = GetBatchKernels());
+
+    // Evaluate rows [begin,end) into output[begin,end)
+    void Run(size_t begin, size_t end, double *output);
+
+private:
+    // Evaluate rows [begin,begin+count) into output, count <= chunk_size
+    void RunChunk(size_t begin, size_t count, double *output);
+
+    const CompiledExpression   &program;
+    std::vector<const double *> columns;
+    std::vector<double>         scalars;
+    std::vector<double>         literals;
+    const BatchKernels         &kernels;
+    // kernel of every function in program, nullptr to call it row by row
+    std::vector<UnaryKernel> functionKernels;
+    // stack[k] points to rows of stack level k,
+    // which is either a variable column or scratch of level k
+    std::vector<const double *> stack;
+    // one chunk of rows per stack level
+    std::vector<double> scratch;
+    // one chunk of rows per temp of shared subexpression
+    std::vector<double> temps;
+};
+} // namespace exp_solver
@@ -0,0 +1,687 @@
+/*
+
+big_rational.cpp
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Implementation of BigInt and BigRational.
+Limb arithmetic is schoolbook, division is Knuth's
+algorithm D.
+
+*/
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+
+#include "big_rational.h"
+#include "int_math.h"
+
+namespace exp_solver
+{
+using Limbs = std::vector<uint32_t>;
+
+// Largest result of shift and power in bits, about 300k decimal digits
+static constexpr size_t max_bits = size_t(1) << 20;
+
+// ******************** //
+// *  Limb Functions  * //
+// ******************** //
+
+static void Trim(Limbs &a) {
+    while (!a.empty() && a.back() == 0) a.pop_back();
+}
+
+static int CompareMagnitude(const Limbs &a, const Limbs &b) {
+    if (a.size() != b.size()) return a.size() < b.size() ? -1 : 1;
+    for (size_t i = a.size(); i-- > 0;) {
+        if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+static Limbs AddMagnitude(const Limbs &a, const Limbs &b) {
+    const auto &longer  = a.size() >= b.size() ? a : b;
+    const auto &shorter = a.size() >= b.size() ? b : a;
+    Limbs       out(longer.size() + 1);
+    uint64_t    carry = 0;
+    for (size_t i = 0; i < longer.size(); i++) {
+        carry += static_cast<uint64_t>(longer[i]) + (i < shorter.size() ? shorter[i] : 0);
+        out[i] = static_cast<uint32_t>(carry);
+        carry >>= 32;
+    }
+    out.back() = static_cast<uint32_t>(carry);
+    Trim(out);
+    return out;
+}
+
+// a - b, a must not be less than b
+static Limbs SubMagnitude(const Limbs &a, const Limbs &b) {
+    Limbs   out(a.size());
+    int64_t borrow = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        int64_t diff = static_cast<int64_t>(a[i]) - (i < b.size() ? b[i] : 0) - borrow;
+        borrow       = diff < 0;
+        out[i]       = static_cast<uint32_t>(diff);
+    }
+    Trim(out);
+    return out;
+}
+
+static Limbs MulMagnitude(const Limbs &a, const Limbs &b) {
+    if (a.empty() || b.empty()) return {};
+    Limbs out(a.size() + b.size());
+    for (size_t i = 0; i < a.size(); i++) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < b.size(); j++) {
+            // at most (2^32-1)^2 + 2 * (2^32-1), fits uint64_t
+            carry += static_cast<uint64_t>(a[i]) * b[j] + out[i + j];
+            out[i + j] = static_cast<uint32_t>(carry);
+            carry >>= 32;
+        }
+        out[i + b.size()] = static_cast<uint32_t>(carry);
+    }
+    Trim(out);
+    return out;
+}
+
+// a = a * mul + add
+static void MulAddSmall(Limbs &a, uint32_t mul, uint32_t add) {
+    uint64_t carry = add;
+    for (auto &limb : a) {
+        carry += static_cast<uint64_t>(limb) * mul;
+        limb = static_cast<uint32_t>(carry);
+        carry >>= 32;
+    }
+    if (carry != 0) a.push_back(static_cast<uint32_t>(carry));
+}
+
+// a = a / divisor, return remainder
+static uint32_t DivSmall(Limbs &a, uint32_t divisor) {
+    uint64_t remainder = 0;
+    for (size_t i = a.size(); i-- > 0;) {
+        uint64_t current = (remainder << 32) | a[i];
+        a[i]             = static_cast<uint32_t>(current / divisor);
+        remainder        = current % divisor;
+    }
+    Trim(a);
+    return static_cast<uint32_t>(remainder);
+}
+
+// Knuth's algorithm D, v must not be empty
+static void DivModMagnitude(const Limbs &u, const Limbs &v, Limbs &q, Limbs &r) {
+    if (CompareMagnitude(u, v) < 0) {
+        q.clear();
+        r = u;
+        return;
+    }
+    if (v.size() == 1) {
+        q = u;
+        r = { DivSmall(q, v[0]) };
+        Trim(r);
+        return;
+    }
+
+    // normalize so the top limb of divisor has its high bit set,
+    // then every estimated quotient limb is at most 2 too large
+    size_t n = v.size(), m = u.size();
+    int    s = CountLeadingZeros(v.back()) - 32;
+    Limbs  vn(n), un(m + 1);
+    for (size_t i = n - 1; i > 0; i--) {
+        vn[i] = (v[i] << s) | static_cast<uint32_t>(static_cast<uint64_t>(v[i - 1]) >> (32 - s));
+    }
+    vn[0] = v[0] << s;
+    un[m] = static_cast<uint32_t>(static_cast<uint64_t>(u[m - 1]) >> (32 - s));
+    for (size_t i = m - 1; i > 0; i--) {
+        un[i] = (u[i] << s) | static_cast<uint32_t>(static_cast<uint64_t>(u[i - 1]) >> (32 - s));
+    }
+    un[0] = u[0] << s;
+
+    q.assign(m - n + 1, 0);
+    for (size_t j = m - n + 1; j-- > 0;) {
+        // estimate quotient limb by top two limbs
+        uint64_t top  = (static_cast<uint64_t>(un[j + n]) << 32) | un[j + n - 1];
+        uint64_t qhat = top / vn[n - 1], rhat = top % vn[n - 1];
+        while ((qhat >> 32) != 0 || qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2])) {
+            qhat--;
+            rhat += vn[n - 1];
+            if ((rhat >> 32) != 0) break;
+        }
+
+        // multiply and subtract
+        int64_t borrow = 0, t;
+        for (size_t i = 0; i < n; i++) {
+            uint64_t product = qhat * vn[i];
+            t = static_cast<int64_t>(un[i + j]) - borrow
+                - static_cast<int64_t>(product & 0xFFFFFFFF);
+            un[i + j] = static_cast<uint32_t>(t);
+            borrow    = static_cast<int64_t>(product >> 32) - (t >> 32);
+        }
+        t         = static_cast<int64_t>(un[j + n]) - borrow;
+        un[j + n] = static_cast<uint32_t>(t);
+
+        // estimate was one too large, add back
+        q[j] = static_cast<uint32_t>(qhat);
+        if (t < 0) {
+            q[j]--;
+            uint64_t carry = 0;
+            for (size_t i = 0; i < n; i++) {
+                carry += static_cast<uint64_t>(un[i + j]) + vn[i];
+                un[i + j] = static_cast<uint32_t>(carry);
+                carry >>= 32;
+            }
+            un[j + n] += static_cast<uint32_t>(carry);
+        }
+    }
+
+    // unnormalize remainder
+    r.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        r[i] = (un[i] >> s) | static_cast<uint32_t>(static_cast<uint64_t>(un[i + 1]) << (32 - s));
+    }
+    Trim(q);
+    Trim(r);
+}
+
+// ******************** //
+// *      BigInt      * //
+// ******************** //
+
+BigInt::BigInt(int64_t value) : small(value) {
+    if (value == INT64_MIN) {
+        small    = 0;
+        limbs    = { 0, 0x80000000u };
+        negative = true;
+    }
+}
+
+BigInt BigInt::FromMagnitude(Limbs magnitude, bool negative) {
+    Trim(magnitude);
+    BigInt out;
+    if (magnitude.size() <= 2) {
+        uint64_t value = 0;
+        for (size_t i = 0; i < magnitude.size(); i++) {
+            value |= static_cast<uint64_t>(magnitude[i]) << (32 * i);
+        }
+        if (value <= static_cast<uint64_t>(INT64_MAX)) {
+            out.small = negative ? -static_cast<int64_t>(value) : static_cast<int64_t>(value);
+            return out;
+        }
+    }
+    out.limbs    = std::move(magnitude);
+    out.negative = negative;
+    return out;
+}
+
+BigInt::Limbs BigInt::Magnitude() const {
+    if (!limbs.empty()) return limbs;
+    auto  value = UnsignedAbs(small);
+    Limbs out{ static_cast<uint32_t>(value), static_cast<uint32_t>(value >> 32) };
+    Trim(out);
+    return out;
+}
+
+bool BigInt::Parse(const char *text, size_t size, BigInt &out) {
+    bool isNegative = size > 0 && text[0] == '-';
+    if (isNegative) {
+        text++;
+        size--;
+    }
+    if (size == 0) return false;
+    for (size_t i = 0; i < size; i++) {
+        if (text[i] < '0' || text[i] > '9') return false;
+    }
+
+    // 18 digits always fit int64_t
+    if (size <= 18) {
+        int64_t value = 0;
+        for (size_t i = 0; i < size; i++) value = value * 10 + (text[i] - '0');
+        out = isNegative ? -value : value;
+        return true;
+    }
+
+    // 9 digits at a time, first chunk takes the remainder
+    Limbs  magnitude;
+    size_t chunk = size % 9 == 0 ? 9 : size % 9;
+    for (size_t i = 0; i < size; i += chunk, chunk = 9) {
+        uint32_t value = 0, scale = 1;
+        for (size_t j = i; j < i + chunk; j++) {
+            value = value * 10 + (text[j] - '0');
+            scale *= 10;
+        }
+        MulAddSmall(magnitude, scale, value);
+    }
+    out = FromMagnitude(std::move(magnitude), isNegative);
+    return true;
+}
+
+size_t BigInt::BitLength() const {
+    if (limbs.empty()) return small == 0 ? 0 : 64 - CountLeadingZeros(UnsignedAbs(small));
+    return 32 * limbs.size() - (CountLeadingZeros(limbs.back()) - 32);
+}
+
+std::string BigInt::ToString() const {
+    if (limbs.empty()) return std::to_string(small);
+    // 9 digits at a time from the lowest
+    auto                  magnitude = limbs;
+    std::vector<uint32_t> chunks;
+    while (!magnitude.empty()) chunks.push_back(DivSmall(magnitude, 1000000000));
+
+    std::string out = negative ? "-" : "";
+    out += std::to_string(chunks.back());
+    for (size_t i = chunks.size() - 1; i-- > 0;) {
+        auto digits = std::to_string(chunks[i]);
+        out.append(9 - digits.size(), '0');
+        out += digits;
+    }
+    return out;
+}
+
+double BigInt::ToDouble() const {
+    if (limbs.empty()) return static_cast<double>(small);
+    double value = 0;
+    for (size_t i = limbs.size(); i-- > 0;) value = value * 4294967296.0 + limbs[i];
+    return negative ? -value : value;
+}
+
+int BigInt::Compare(const BigInt &a, const BigInt &b) {
+    if (a.IsSmall() && b.IsSmall()) return a.small < b.small ? -1 : (a.small > b.small ? 1 : 0);
+    bool aNegative = a.IsNegative(), bNegative = b.IsNegative();
+    if (aNegative != bNegative) return aNegative ? -1 : 1;
+    auto order = CompareMagnitude(a.Magnitude(), b.Magnitude());
+    return aNegative ? -order : order;
+}
+
+void BigInt::DivMod(const BigInt &a, const BigInt &b, BigInt &quotient, BigInt &remainder) {
+    // small is never INT64_MIN, so INT64_MIN / -1 can't happen
+    if (a.IsSmall() && b.IsSmall()) {
+        quotient  = a.small / b.small;
+        remainder = a.small % b.small;
+        return;
+    }
+    Limbs q, r;
+    DivModMagnitude(a.Magnitude(), b.Magnitude(), q, r);
+    quotient  = FromMagnitude(std::move(q), a.IsNegative() != b.IsNegative());
+    remainder = FromMagnitude(std::move(r), a.IsNegative());
+}
+
+BigInt BigInt::Gcd(BigInt a, BigInt b) {
+    // Euclid until both fit inline, then binary GCD
+    while (!b.IsZero() && !(a.IsSmall() && b.IsSmall())) {
+        BigInt quotient, remainder;
+        DivMod(a, b, quotient, remainder);
+        a = std::move(b);
+        b = std::move(remainder);
+    }
+    if (b.IsZero()) return a.IsNegative() ? -a : a;
+    return static_cast<int64_t>(BinaryGcd(UnsignedAbs(a.small), UnsignedAbs(b.small)));
+}
+
+BigInt BigInt::ShiftLeft(size_t shift) const {
+    if (limbs.empty() && BitLength() + shift < 63) return small * (int64_t(1) << shift);
+    auto   magnitude = Magnitude();
+    size_t limbShift = shift / 32, bitShift = shift % 32;
+    Limbs  out(magnitude.size() + limbShift + 1);
+    for (size_t i = 0; i < magnitude.size(); i++) {
+        uint64_t shifted = static_cast<uint64_t>(magnitude[i]) << bitShift;
+        out[i + limbShift] |= static_cast<uint32_t>(shifted);
+        out[i + limbShift + 1] |= static_cast<uint32_t>(shifted >> 32);
+    }
+    return FromMagnitude(std::move(out), IsNegative());
+}
+
+BigInt BigInt::ShiftRight(size_t shift) const {
+    if (limbs.empty()) return shift < 63 ? small >> shift : (small < 0 ? -1 : 0);
+    size_t limbShift = shift / 32, bitShift = shift % 32;
+    if (limbShift >= limbs.size()) return negative ? -1 : 0;
+
+    Limbs out(limbs.size() - limbShift);
+    for (size_t i = 0; i < out.size(); i++) {
+        uint64_t high = i + limbShift + 1 < limbs.size() ? limbs[i + limbShift + 1] : 0;
+        out[i]        = static_cast<uint32_t>(
+            ((high << 32) | limbs[i + limbShift]) >> bitShift);
+    }
+    // floor of negative value rounds away from zero when bits are dropped
+    bool dropped = (limbs[limbShift] & ((uint32_t(1) << bitShift) - 1)) != 0;
+    for (size_t i = 0; i < limbShift && !dropped; i++) dropped = limbs[i] != 0;
+    if (negative && dropped) out = AddMagnitude(out, { 1 });
+    return FromMagnitude(std::move(out), negative);
+}
+
+BigInt operator+(const BigInt &a, const BigInt &b) {
+    int64_t sum;
+    if (a.IsSmall() && b.IsSmall() && !AddOverflow(a.small, b.small, sum)) return sum;
+    auto x = a.Magnitude(), y = b.Magnitude();
+    bool aNegative = a.IsNegative(), bNegative = b.IsNegative();
+    if (aNegative == bNegative) return BigInt::FromMagnitude(AddMagnitude(x, y), aNegative);
+    if (CompareMagnitude(x, y) >= 0) return BigInt::FromMagnitude(SubMagnitude(x, y), aNegative);
+    return BigInt::FromMagnitude(SubMagnitude(y, x), bNegative);
+}
+
+BigInt operator-(const BigInt &a, const BigInt &b) {
+    int64_t difference;
+    if (a.IsSmall() && b.IsSmall() && !AddOverflow(a.small, -b.small, difference)) {
+        return difference;
+    }
+    return a + (-b);
+}
+
+BigInt operator*(const BigInt &a, const BigInt &b) {
+    int64_t product;
+    if (a.IsSmall() && b.IsSmall() && !MulOverflow(a.small, b.small, product)) return product;
+    return BigInt::FromMagnitude(MulMagnitude(a.Magnitude(), b.Magnitude()),
+                                 a.IsNegative() != b.IsNegative());
+}
+
+BigInt operator-(const BigInt &a) {
+    if (a.IsSmall()) return -a.small;
+    BigInt out   = a;
+    out.negative = !a.negative;
+    return out;
+}
+
+// ******************** //
+// *   BigRational    * //
+// ******************** //
+
+static bool IsOne(const BigInt &value) {
+    return value.IsSmall() && value.GetSmall() == 1;
+}
+
+// Quotient of exact division
+static BigInt Divide(const BigInt &a, const BigInt &b) {
+    BigInt quotient, remainder;
+    BigInt::DivMod(a, b, quotient, remainder);
+    return quotient;
+}
+
+BigRational::BigRational(BigInt u, BigInt d) :
+    up(std::move(u)), down(std::move(d)), calculable(true) {
+    if (down.IsZero()) {
+        *this = Failure(ValueError::DenominatorZero);
+        return;
+    }
+    if (down.IsNegative()) {
+        up   = -up;
+        down = -down;
+    }
+    if (IsOne(down)) return;
+    auto k = BigInt::Gcd(up, down);
+    if (!IsOne(k)) {
+        up   = Divide(up, k);
+        down = Divide(down, k);
+    }
+}
+
+BigRational::BigRational(const Value &value) {
+    if (!value.IsCalculable()) {
+        *this = Failure(value.GetError());
+    } else if (!value.IsDecimal()) {
+        auto fraction = value.GetFracValue();
+        *this         = BigRational(fraction.up, fraction.down);
+    } else {
+        auto dv = value.GetValueDouble();
+        *this   = FromDouble(dv);
+        exact   = dv == std::floor(dv);
+    }
+}
+
+#ifdef EXP_HAS_STRING_VIEW
+BigRational BigRational::Parse(std::string_view text) {
+#else
+BigRational BigRational::Parse(const std::string &text) {
+#endif
+    auto dot = text.find('.');
+    if (dot == text.npos) {
+        BigInt value;
+        if (!BigInt::Parse(text.data(), text.size(), value)) {
+            return Failure(ValueError::ConvertFail);
+        }
+        return BigRational(std::move(value));
+    }
+    if (text.find('.', dot + 1) != text.npos) return Failure(ValueError::MultipleDots);
+
+    // "12.345" is 12345 / 10^3
+    std::string digits(text.substr(0, dot));
+    digits.append(text.data() + dot + 1, text.size() - dot - 1);
+    std::string scale = "1" + std::string(text.size() - dot - 1, '0');
+    BigInt      up, down;
+    if (digits.empty() || !BigInt::Parse(digits.data(), digits.size(), up)) {
+        return Failure(ValueError::ConvertFail);
+    }
+    BigInt::Parse(scale.data(), scale.size(), down);
+    return BigRational(std::move(up), std::move(down));
+}
+
+BigRational BigRational::FromDouble(double dv) {
+    if (!std::isfinite(dv)) return Failure(ValueError::NumberTooLarge);
+    // dv is mantissa * 2^exponent with a 53 bit integer mantissa
+    int  exponent;
+    auto mantissa = static_cast<int64_t>(std::ldexp(std::frexp(dv, &exponent), 53));
+    exponent -= 53;
+    BigRational result = exponent >= 0
+                             ? BigRational(BigInt(mantissa).ShiftLeft(exponent))
+                             : BigRational(mantissa, BigInt(1).ShiftLeft(-exponent));
+    result.exact = false;
+    return result;
+}
+
+BigRational BigRational::Failure(ValueError error) {
+    BigRational temp;
+    temp.error = error;
+    return temp;
+}
+
+bool BigRational::BothSmallIntegers(const BigRational &a, const BigRational &b) {
+    return a.IsInteger() && b.IsInteger() && a.up.IsSmall() && b.up.IsSmall();
+}
+
+std::string BigRational::GetValueStr() const {
+    if (!calculable) return "";
+    if (IsOne(down)) return up.ToString();
+    return up.ToString() + "/" + down.ToString();
+}
+
+std::string BigRational::GetDecimalStr(size_t digits) const {
+    if (!calculable) return "";
+    // round |up| * 10^digits / down half away from zero
+    auto   scaled = up.IsNegative() ? -up : up;
+    BigInt ten(10);
+    for (size_t i = 0; i < digits; i++) scaled = scaled * ten;
+    BigInt quotient, remainder;
+    BigInt::DivMod(scaled, down, quotient, remainder);
+    if (BigInt::Compare(remainder + remainder, down) >= 0) quotient = quotient + 1;
+
+    auto text = quotient.ToString();
+    if (text.size() <= digits) text.insert(0, digits + 1 - text.size(), '0');
+    if (digits > 0) text.insert(text.size() - digits, ".");
+    if (up.IsNegative() && !quotient.IsZero()) text.insert(0, "-");
+    return text;
+}
+
+double BigRational::GetValueDouble() const {
+    if (!calculable) return 0;
+    if (up.IsSmall() && down.IsSmall()) {
+        return static_cast<double>(up.GetSmall()) / static_cast<double>(down.GetSmall());
+    }
+    // integer quotient of about 64 bits, then scale back
+    auto magnitude = up.IsNegative() ? -up : up;
+    auto shift =
+        static_cast<long>(magnitude.BitLength()) - static_cast<long>(down.BitLength()) - 64;
+    auto quotient  = shift < 0 ? Divide(magnitude.ShiftLeft(-shift), down)
+                               : Divide(magnitude, down.ShiftLeft(shift));
+    auto value = std::ldexp(quotient.ToDouble(), static_cast<int>(std::max(shift, -100000L)));
+    return up.IsNegative() ? -value : value;
+}
+
+Value BigRational::ToValue() const {
+    if (!calculable) return {};
+    if (up.IsSmall() && down.IsSmall()) return Value(Fraction(up.GetSmall(), down.GetSmall()));
+    return Value(GetValueDouble());
+}
+
+// Return the not calculable one of a and b, keep its error
+#define RETURN_IF_NOT_CALCULABLE(a, b)   \
+    if (!(a).IsCalculable()) return (a); \
+    if (!(b).IsCalculable()) return (b);
+
+BigRational operator+(const BigRational &a, const BigRational &b) {
+    RETURN_IF_NOT_CALCULABLE(a, b);
+    auto result = BigInt::Compare(a.down, b.down) == 0
+                      ? BigRational(a.up + b.up, a.down)
+                      : BigRational(a.up * b.down + b.up * a.down, a.down * b.down);
+    result.exact = a.exact && b.exact;
+    return result;
+}
+
+BigRational operator-(const BigRational &a, const BigRational &b) {
+    return a + (-b);
+}
+
+BigRational operator*(const BigRational &a, const BigRational &b) {
+    RETURN_IF_NOT_CALCULABLE(a, b);
+    BigRational result(a.up * b.up, a.down * b.down);
+    result.exact = a.exact && b.exact;
+    return result;
+}
+
+BigRational operator/(const BigRational &a, const BigRational &b) {
+    RETURN_IF_NOT_CALCULABLE(a, b);
+    BigRational result(a.up * b.down, a.down * b.up);
+    result.exact = a.exact && b.exact;
+    return result;
+}
+
+BigRational floordiv(const BigRational &a, const BigRational &b) {
+    auto quotient = a / b;
+    if (!quotient.IsCalculable() || quotient.IsInteger()) return quotient;
+    BigInt floor, remainder;
+    BigInt::DivMod(quotient.up, quotient.down, floor, remainder);
+    if (quotient.up.IsNegative()) floor = floor - 1;
+    BigRational result(floor);
+    result.exact = quotient.exact;
+    return result;
+}
+
+BigRational operator%(const BigRational &a, const BigRational &b) {
+    RETURN_IF_NOT_CALCULABLE(a, b);
+    // must both be interger
+    if (!a.IsInteger() || !b.IsInteger()) return BigRational::Failure(ValueError::ModFloat);
+    if (b.up.IsZero()) return BigRational::Failure(ValueError::ModZero);
+    BigInt quotient, remainder;
+    BigInt::DivMod(a.up, b.up, quotient, remainder);
+    BigRational result(remainder);
+    result.exact = a.exact && b.exact;
+    return result;
+}
+
+BigRational operator<<(const BigRational &a, const BigRational &b) {
+    RETURN_IF_NOT_CALCULABLE(a, b);
+    if (!a.IsInteger() || !b.IsInteger() || b.up.IsNegative()) {
+        return BigRational::Failure(ValueError::LeftShiftFloat);
+    }
+    if (!b.up.IsSmall() || a.up.BitLength() + b.up.GetSmall() > max_bits) {
+        return BigRational::Failure(ValueError::NumberTooLarge);
+    }
+    BigRational result(a.up.ShiftLeft(b.up.GetSmall()));
+    result.exact = a.exact && b.exact;
+    return result;
+}
+
+BigRational operator>>(const BigRational &a, const BigRational &b) {
+    RETURN_IF_NOT_CALCULABLE(a, b);
+    if (!a.IsInteger() || !b.IsInteger() || b.up.IsNegative()) {
+        return BigRational::Failure(ValueError::RightShiftFloat);
+    }
+    // every bit is shifted out once shift is past the length
+    auto shift = b.up.IsSmall() ? std::min<size_t>(b.up.GetSmall(), a.up.BitLength() + 1)
+                                : a.up.BitLength() + 1;
+    BigRational result(a.up.ShiftRight(shift));
+    result.exact = a.exact && b.exact;
+    return result;
+}
+
+// Bit operators work on integers fitting int64_t like Value
+#define BIT_OPERATOR(op, floatError)                                                    \
+    BigRational operator op(const BigRational &a, const BigRational &b) {               \
+        RETURN_IF_NOT_CALCULABLE(a, b);                                                 \
+        if (!a.IsInteger() || !b.IsInteger()) return BigRational::Failure(floatError);  \
+        if (!BigRational::BothSmallIntegers(a, b)) {                                    \
+            return BigRational::Failure(ValueError::NumberTooLarge);                    \
+        }                                                                               \
+        BigRational result(BigInt(a.up.GetSmall() op b.up.GetSmall()));                 \
+        result.exact = a.exact && b.exact;                                              \
+        return result;                                                                  \
+    }
+
+BIT_OPERATOR(&, ValueError::AndFloat)
+BIT_OPERATOR(|, ValueError::OrFloat)
+BIT_OPERATOR(^, ValueError::XorFloat)
+
+#undef BIT_OPERATOR
+
+BigRational operator-(const BigRational &a) {
+    if (!a.IsCalculable()) return a;
+    auto result = a;
+    result.up   = -a.up;
+    return result;
+}
+
+BigRational operator~(const BigRational &a) {
+    if (!a.IsCalculable()) return a;
+    if (!a.IsInteger()) return BigRational::Failure(ValueError::InvertFloat);
+    // two's complement, ~x == -x - 1
+    auto result = a;
+    result.up   = -a.up - 1;
+    return result;
+}
+
+// base ** exponent by squaring
+static BigInt Power(BigInt base, uint64_t exponent) {
+    BigInt result(1);
+    while (exponent != 0) {
+        if (exponent & 1) result = result * base;
+        exponent >>= 1;
+        if (exponent != 0) base = base * base;
+    }
+    return result;
+}
+
+BigRational powv(const BigRational &a, const BigRational &b) {
+    RETURN_IF_NOT_CALCULABLE(a, b);
+    if (!b.IsInteger()) {
+        if (a.up.IsNegative()) return BigRational::Failure(ValueError::NegativePower);
+        auto result  = BigRational::FromDouble(std::pow(a.GetValueDouble(), b.GetValueDouble()));
+        result.exact = false;
+        return result;
+    }
+
+    auto bits = std::max(a.up.BitLength(), a.down.BitLength());
+    if (!b.up.IsSmall() || (bits > 1 && UnsignedAbs(b.up.GetSmall()) > max_bits / (bits - 1))) {
+        return BigRational::Failure(ValueError::NumberTooLarge);
+    }
+    auto exponent = b.up.GetSmall();
+    if (exponent < 0 && a.up.IsZero()) return BigRational::Failure(ValueError::DenominatorZero);
+
+    // powers of a reduced fraction are still reduced
+    BigRational result;
+    result.calculable = true;
+    result.exact      = a.exact && b.exact;
+    result.up         = Power(a.up, UnsignedAbs(exponent));
+    result.down       = Power(a.down, UnsignedAbs(exponent));
+    if (exponent < 0) {
+        std::swap(result.up, result.down);
+        if (result.down.IsNegative()) {
+            result.up   = -result.up;
+            result.down = -result.down;
+        }
+    }
+    return result;
+}
+
+#undef RETURN_IF_NOT_CALCULABLE
+
+std::ostream &operator<<(std::ostream &out, const BigRational &m) {
+    return out << m.GetValueStr();
+}
+} // namespace exp_solver
@@ -0,0 +1,159 @@
+/*
+
+big_rational.h
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Header file for BigInt and BigRational,
+integers and fractions of any size used by the exact
+mode of ExpSolver. Numbers that fit int64_t are kept
+inline, only larger ones allocate limbs on heap.
+
+*/
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "value.h"
+
+namespace exp_solver
+{
+/**
+ * @brief signed integer of any size, kept in an int64_t while it fits
+ *        and spilled to heap limbs only when it does not
+ */
+class BigInt {
+public:
+    BigInt() = default;
+    BigInt(int64_t value);
+
+    // Parse decimal digits with optional leading '-', false if not a number
+    static bool Parse(const char *text, size_t size, BigInt &out);
+
+    // Whether value is kept inline, then GetSmall is the value
+    bool    IsSmall() const { return limbs.empty(); }
+    int64_t GetSmall() const { return small; }
+    bool    IsZero() const { return limbs.empty() && small == 0; }
+    bool    IsNegative() const { return limbs.empty() ? small < 0 : negative; }
+    // Count of bits of |value|
+    size_t BitLength() const;
+
+    std::string ToString() const;
+    double      ToDouble() const;
+
+    // -1, 0 or 1 as a <, ==, > b
+    static int Compare(const BigInt &a, const BigInt &b);
+    // Truncating division like int64_t, b must not be 0
+    static void DivMod(const BigInt &a, const BigInt &b, BigInt &quotient, BigInt &remainder);
+    // Greatest common divisor of |a| and |b|
+    static BigInt Gcd(BigInt a, BigInt b);
+
+    // value * 2^shift
+    BigInt ShiftLeft(size_t shift) const;
+    // floor(value / 2^shift)
+    BigInt ShiftRight(size_t shift) const;
+
+    friend BigInt operator+(const BigInt &a, const BigInt &b);
+    friend BigInt operator-(const BigInt &a, const BigInt &b);
+    friend BigInt operator*(const BigInt &a, const BigInt &b);
+    friend BigInt operator-(const BigInt &a);
+
+private:
+    using Limbs = std::vector<uint32_t>;
+
+    // Value of |magnitude| with sign, inline if it fits
+    static BigInt FromMagnitude(Limbs magnitude, bool negative);
+    // |value| in limbs, small value is split too
+    Limbs Magnitude() const;
+
+    // value while limbs is empty, never INT64_MIN so it can be negated
+    int64_t small{ 0 };
+    // |value| in base 2^32, least significant first, no leading zero limb
+    Limbs limbs;
+    bool  negative{ false };
+};
+
+/**
+ * @brief exact fraction of BigInt, always reduced with positive denominator.
+ *        Like Value, a failed operation gives a not calculable one with the reason
+ */
+class BigRational {
+public:
+    // Not calculable
+    BigRational() = default;
+    BigRational(BigInt up, BigInt down = 1);
+    // Exact value of a fraction, decimal value is exact only if it is an integer
+    explicit BigRational(const Value &value);
+
+    // Parse decimal number like "123.4500" of any length, not calculable if invalid
+#ifdef EXP_HAS_STRING_VIEW
+    static BigRational Parse(std::string_view text);
+#else
+    static BigRational Parse(const std::string &text);
+#endif
+    // Exact value of dv, marked inexact, as dv is a rounded result
+    static BigRational FromDouble(double dv);
+
+    bool       IsCalculable() const { return calculable; }
+    ValueError GetError() const { return error; }
+    // false once a function, constant or inexact decimal took part in the result
+    bool IsExact() const { return exact; }
+    bool IsInteger() const { return calculable && down.IsSmall() && down.GetSmall() == 1; }
+
+    const BigInt &GetUp() const { return up; }
+    const BigInt &GetDown() const { return down; }
+
+    // "up/down", or just "up" for an integer
+    std::string GetValueStr() const;
+    // Rounded half away from zero to digits after the decimal point
+    std::string GetDecimalStr(size_t digits = 6) const;
+    double      GetValueDouble() const;
+    // Same number as Value, exact fraction if it fits int64_t, otherwise double
+    Value ToValue() const;
+
+    friend BigRational operator+(const BigRational &a, const BigRational &b);
+    friend BigRational operator-(const BigRational &a, const BigRational &b);
+    friend BigRational operator*(const BigRational &a, const BigRational &b);
+    friend BigRational operator/(const BigRational &a, const BigRational &b);
+    friend BigRational operator%(const BigRational &a, const BigRational &b);
+    friend BigRational operator<<(const BigRational &a, const BigRational &b);
+    friend BigRational operator>>(const BigRational &a, const BigRational &b);
+    friend BigRational operator&(const BigRational &a, const BigRational &b);
+    friend BigRational operator|(const BigRational &a, const BigRational &b);
+    friend BigRational operator^(const BigRational &a, const BigRational &b);
+    friend BigRational operator-(const BigRational &a);
+    friend BigRational operator~(const BigRational &a);
+    friend BigRational powv(const BigRational &a, const BigRational &b);
+    friend BigRational floordiv(const BigRational &a, const BigRational &b);
+
+private:
+    // Not calculable with reason
+    static BigRational Failure(ValueError error);
+    // Both integers and fit int64_t, for bit operators
+    static bool BothSmallIntegers(const BigRational &a, const BigRational &b);
+
+    BigInt     up, down{ 1 };
+    bool       calculable{ false };
+    bool       exact{ true };
+    ValueError error{ ValueError::None };
+};
+
+BigRational operator+(const BigRational &a, const BigRational &b);
+BigRational operator-(const BigRational &a, const BigRational &b);
+BigRational operator*(const BigRational &a, const BigRational &b);
+BigRational operator/(const BigRational &a, const BigRational &b);
+BigRational operator%(const BigRational &a, const BigRational &b);
+BigRational operator<<(const BigRational &a, const BigRational &b);
+BigRational operator>>(const BigRational &a, const BigRational &b);
+BigRational operator&(const BigRational &a, const BigRational &b);
+BigRational operator|(const BigRational &a, const BigRational &b);
+BigRational operator^(const BigRational &a, const BigRational &b);
+BigRational operator-(const BigRational &a);
+BigRational operator~(const BigRational &a);
+BigRational powv(const BigRational &a, const BigRational &b);
+// floor(a / b)
+BigRational floordiv(const BigRational &a, const BigRational &b);
+
+std::ostream &operator<<(std::ostream &out, const BigRational &m);
+} // namespace exp_solver
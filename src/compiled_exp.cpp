@@ -0,0 +1,189 @@
+/*
+
+compiled_exp.cpp
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Operator resolving and applying
+for CompiledExpression, and register allocation
+of its register program.
+
+*/
+#include <algorithm>
+#include <vector>
+
+#include "compiled_exp.h"
+#include "double_ops.h"
+
+namespace exp_solver
+{
+#ifdef EXP_HAS_STRING_VIEW
+OpCode ParseOperator(std::string_view op) {
+#else
+OpCode ParseOperator(const std::string &op) {
+#endif
+    if (op == "**") return OpCode::Pow;
+    if (op == "*") return OpCode::Mul;
+    if (op == "/") return OpCode::Div;
+    if (op == "//") return OpCode::FloorDiv;
+    if (op == "%") return OpCode::Mod;
+    if (op == "+") return OpCode::Add;
+    if (op == "-") return OpCode::Sub;
+    if (op == "<<") return OpCode::Shl;
+    if (op == ">>") return OpCode::Shr;
+    if (op == "&") return OpCode::And;
+    if (op == "^") return OpCode::Xor;
+    if (op == "|") return OpCode::Or;
+    return OpCode::Nil;
+}
+
+Value ApplyOperator(OpCode code, const Value &a, const Value &b) {
+    switch (code) {
+        case OpCode::Pow: return powv(a, b);
+        case OpCode::Mul: return a * b;
+        case OpCode::Div: return a / b;
+        case OpCode::FloorDiv: {
+            auto quotient = a / b;
+            if (!quotient.IsCalculable()) return quotient;
+            return Value(floor(quotient.GetValueDouble()));
+        }
+        case OpCode::Mod: return a % b;
+        case OpCode::Add: return a + b;
+        case OpCode::Sub: return a - b;
+        case OpCode::Shl: return a << b;
+        case OpCode::Shr: return a >> b;
+        case OpCode::And: return a & b;
+        case OpCode::Xor: return a ^ b;
+        case OpCode::Or: return a | b;
+        default: return {};
+    }
+}
+
+double ApplyOperator(OpCode code, double a, double b, ValueError &error) {
+    // checks follow Value, so both modes fail on the same expressions
+    switch (code) {
+        case OpCode::Pow: return double_ops::Pow(a, b, error);
+        case OpCode::Mul: return a * b;
+        case OpCode::Div: return double_ops::Div(a, b, error);
+        case OpCode::FloorDiv: return double_ops::FloorDiv(a, b, error);
+        case OpCode::Mod: return double_ops::Mod(a, b, error);
+        case OpCode::Add: return a + b;
+        case OpCode::Sub: return a - b;
+        case OpCode::Shl: return double_ops::Shl(a, b, error);
+        case OpCode::Shr: return double_ops::Shr(a, b, error);
+        case OpCode::And: return double_ops::And(a, b, error);
+        case OpCode::Xor: return double_ops::Xor(a, b, error);
+        case OpCode::Or: return double_ops::Or(a, b, error);
+        default: return double_ops::Fail(ValueError::InvalidOperator, error);
+    }
+}
+
+BigRational ApplyOperator(OpCode code, const BigRational &a, const BigRational &b) {
+    switch (code) {
+        case OpCode::Pow: return powv(a, b);
+        case OpCode::Mul: return a * b;
+        case OpCode::Div: return a / b;
+        case OpCode::FloorDiv: return floordiv(a, b);
+        case OpCode::Mod: return a % b;
+        case OpCode::Add: return a + b;
+        case OpCode::Sub: return a - b;
+        case OpCode::Shl: return a << b;
+        case OpCode::Shr: return a >> b;
+        case OpCode::And: return a & b;
+        case OpCode::Xor: return a ^ b;
+        case OpCode::Or: return a | b;
+        default: return {};
+    }
+}
+
+void CompiledExpression::AllocateRegisters() {
+    registerCode.clear();
+    loads.clear();
+    const auto literalCount = static_cast<int32_t>(literals.size());
+
+    // first pass turns stack into operands, an operand >= 0 is slot of a literal or a
+    // loaded variable, value v made by an instruction is -1 - v until it gets a register
+    std::vector<int32_t> operands, tempOperands(tempCount), loadSlots(variableCount, -1);
+    // index of the last instruction reading each value
+    std::vector<size_t> lastUse;
+    auto                use = [&](int32_t operand) {
+        if (operand < 0) lastUse[-1 - operand] = registerCode.size();
+    };
+    auto define = [&]() {
+        lastUse.push_back(0);
+        return -static_cast<int32_t>(lastUse.size());
+    };
+    for (const auto &instruction : code) {
+        switch (instruction.code) {
+            case OpCode::PushValue: operands.push_back(instruction.arg); break;
+            case OpCode::PushVar: {
+                auto &slot = loadSlots[instruction.arg];
+                if (slot < 0) {
+                    slot = literalCount + static_cast<int32_t>(loads.size());
+                    loads.push_back(instruction.arg);
+                }
+                operands.push_back(slot);
+                break;
+            }
+            case OpCode::Store: tempOperands[instruction.arg] = operands.back(); break;
+            case OpCode::Load: operands.push_back(tempOperands[instruction.arg]); break;
+            case OpCode::Call:
+            case OpCode::CallSqrt:
+            case OpCode::Invert:
+            case OpCode::Neg: {
+                auto operand = operands.back();
+                use(operand);
+                operands.back() = define();
+                registerCode.emplace_back(instruction.code, instruction.arg, operands.back(),
+                                          operand, operand);
+                break;
+            }
+            default: {
+                // binary operator, left operand is on top
+                auto left = operands.back();
+                operands.pop_back();
+                auto right = operands.back();
+                use(left);
+                use(right);
+                operands.back() = define();
+                registerCode.emplace_back(instruction.code, 0, operands.back(), left, right);
+                break;
+            }
+        }
+    }
+    auto result = operands.back();
+    if (result < 0) lastUse[-1 - result] = registerCode.size();
+
+    // second pass gives values registers after the loaded variables, a register is free
+    // after its last read, so the instruction reading it may write its result there
+    const auto           registerBase  = literalCount + static_cast<int32_t>(loads.size());
+    int32_t              registerCount = 0;
+    std::vector<int32_t> registers(lastUse.size()), freeRegisters;
+    auto                 slotOf = [&](int32_t operand) {
+        return operand >= 0 ? operand : registers[-1 - operand];
+    };
+    for (size_t i = 0; i < registerCode.size(); i++) {
+        auto &instruction = registerCode[i];
+        auto  release     = [&](int32_t operand) {
+            if (operand < 0 && lastUse[-1 - operand] == i) {
+                freeRegisters.push_back(registers[-1 - operand]);
+            }
+        };
+        release(instruction.left);
+        if (instruction.right != instruction.left) release(instruction.right);
+        auto &assigned = registers[-1 - instruction.dst];
+        if (freeRegisters.empty()) {
+            assigned = registerBase + registerCount++;
+        } else {
+            assigned = freeRegisters.back();
+            freeRegisters.pop_back();
+        }
+        instruction.dst   = assigned;
+        instruction.left  = slotOf(instruction.left);
+        instruction.right = slotOf(instruction.right);
+    }
+    resultSlot = slotOf(result);
+    frameSize  = static_cast<size_t>(registerBase + registerCount);
+}
+} // namespace exp_solver
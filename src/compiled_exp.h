@@ -0,0 +1,285 @@
+/*
+
+compiled_exp.h
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Header file for CompiledExpression,
+an immutable postfix program produced by
+ExpSolver::Compile that can be evaluated many
+times without lexing the expression again.
+
+*/
+#pragma once
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "value.h"
+#include "big_rational.h"
+#include "symbol_table.h"
+
+namespace exp_solver
+{
+template <typename T, typename Policy>
+class TypedEvaluator;
+class JitFunction;
+class CppGenerator;
+
+enum class OpCode : uint8_t {
+    // push literals[arg]
+    PushValue,
+    // push value of variable in slot arg
+    PushVar,
+    // pop one value, push functions[arg](value)
+    Call,
+    // same as Call, but reject negative argument
+    CallSqrt,
+    // pop one value, push ~value
+    Invert,
+    // pop one value, push -value
+    Neg,
+    // copy top value to temps[arg], keep it on stack
+    Store,
+    // push temps[arg]
+    Load,
+    // binary operators, pop left then right, push result
+    Pow,
+    Mul,
+    Div,
+    FloorDiv,
+    Mod,
+    Add,
+    Sub,
+    Shl,
+    Shr,
+    And,
+    Xor,
+    Or,
+    // not a valid operator
+    Nil
+};
+
+// Number type a program computes in
+enum class NumericMode : uint8_t {
+    // Value, exact fractions while they fit, double otherwise
+    Rational,
+    // plain double, no fraction bookkeeping, errors are reported like Value
+    Double
+};
+
+// Form of program evaluation runs
+enum class Backend : uint8_t {
+    // stack for small programs, registers for large ones
+    Auto,
+    // postfix code over a value stack
+    Stack,
+    // three address code over fixed slots
+    Register
+};
+
+// How much work went into compiling a program, see ExpSolver::SetTiering
+enum class Tier : uint8_t {
+    // nodes emitted in order, cheap to compile for expressions run a few times
+    Interpreted,
+    // constants folded, shared subexpressions computed once, register form for large ones
+    Optimized
+};
+
+struct Instruction {
+    OpCode  code;
+    int32_t arg;
+    Instruction(OpCode c, int32_t a = 0) : code(c), arg(a) {}
+};
+
+// Instruction of register program, frame[dst] = code(frame[left], frame[right]),
+// unary operators and functions read left only, arg is index of function
+struct RegisterInstruction {
+    OpCode  code;
+    int32_t arg, dst, left, right;
+    RegisterInstruction(OpCode c, int32_t a, int32_t d, int32_t l, int32_t r) :
+        code(c), arg(a), dst(d), left(l), right(r) {}
+};
+
+#ifdef EXP_HAS_STRING_VIEW
+// Map an operator symbol to its OpCode, OpCode::Nil if unknown
+OpCode ParseOperator(std::string_view op);
+#else
+OpCode ParseOperator(const std::string &op);
+#endif
+
+// Apply binary operator code on a and b
+Value       ApplyOperator(OpCode code, const Value &a, const Value &b);
+BigRational ApplyOperator(OpCode code, const BigRational &a, const BigRational &b);
+// Same on doubles, returns NaN and sets error if operands are not allowed
+double ApplyOperator(OpCode code, double a, double b, ValueError &error);
+
+// Node of expression tree built while compiling,
+// left and right are node indices, -1 if absent
+struct ExpNode {
+    OpCode  code;
+    int32_t arg, left, right;
+    ExpNode(OpCode c, int32_t a, int32_t l = -1, int32_t r = -1) :
+        code(c), arg(a), left(l), right(r) {}
+};
+
+// Counts of expression tree nodes while compiling
+struct CompileStats {
+    // nodes parsed from expression
+    size_t nodes{ 0 };
+    // nodes replaced by a literal by constant folding
+    size_t foldedNodes{ 0 };
+    // operator and function nodes sharing the result of an identical subexpression
+    size_t dedupedNodes{ 0 };
+};
+
+class CompiledExpression {
+public:
+    CompiledExpression() = default;
+
+    // Whether compile succeeded
+    bool IsValid() const { return !code.empty(); }
+
+    // The expression text this program was compiled from
+    const std::string &GetExpression() const { return expression; }
+
+    // Count of instructions
+    size_t GetCodeSize() const { return code.size(); }
+
+    const CompileStats &GetStats() const { return stats; }
+
+    // Whether compiled by ExpSolver::CompileExact, so literals are kept in full precision
+    bool IsExact() const { return exact; }
+
+    // Number type of evaluation, the mode of the solver that compiled it
+    NumericMode GetNumericMode() const { return mode; }
+
+    // Backend::Register if evaluation runs the register program, Backend::Stack otherwise
+    Backend GetBackend() const { return frameSize != 0 ? Backend::Register : Backend::Stack; }
+
+    // Count of instructions of register program, 0 for stack backend
+    size_t GetRegisterCodeSize() const { return registerCode.size(); }
+
+    Tier GetTier() const { return tier; }
+
+    // Runs of a Tier::Interpreted program by tiered SolveExp and ResolveExp, of all solvers
+    // sharing it, optimized programs are not counted
+    uint32_t GetExecutionCount() const {
+        return tierState.executions.load(std::memory_order_relaxed);
+    }
+
+private:
+    friend class ExpSolver;
+    friend class BatchEvaluator;
+    friend class EvalContext;
+    friend class JitFunction;
+    friend class CppGenerator;
+    template <typename T, typename Policy>
+    friend class TypedEvaluator;
+
+    // Empty program that keeps capacity, for a program compiled again and again
+    void Clear() {
+        expression.clear();
+        code.clear();
+        literals.clear();
+        functions.clear();
+        exactLiterals.clear();
+        doubleLiterals.clear();
+        registerCode.clear();
+        loads.clear();
+        frameSize  = 0;
+        resultSlot = 0;
+        stackDepth    = 0;
+        tempCount     = 0;
+        variableCount = 0;
+        stats         = CompileStats();
+        exact         = false;
+        mode          = NumericMode::Rational;
+        tier          = Tier::Optimized;
+        tierState     = TierState();
+    }
+
+    std::string expression;
+    // postfix program, evaluated left to right with a value stack
+    std::vector<Instruction> code;
+    // pre-parsed numbers and constants
+    std::vector<Value> literals;
+    // resolved functions
+    std::vector<Function> functions;
+    // max depth of value stack during evaluation
+    size_t stackDepth{ 0 };
+    // count of temps holding shared subexpressions
+    size_t tempCount{ 0 };
+    // count of variables in solver when compiled, slots used are below it
+    size_t       variableCount{ 0 };
+    CompileStats stats;
+    // compiled by CompileExact, literals are not folded and exactLiterals is
+    // the full precision of literals at the same index
+    bool                     exact{ false };
+    std::vector<BigRational> exactLiterals;
+    NumericMode              mode{ NumericMode::Rational };
+    // literals as double, only for double mode
+    std::vector<double> doubleLiterals;
+
+    // Translate code to registerCode, values are given slots of frame by linear scan
+    // in code order, a slot is reused once the last instruction reading it is done
+    void AllocateRegisters();
+
+    // Frame of register program is literals, then values of variables in loads,
+    // then registers, frameSize is 0 if the program has no register form
+    std::vector<RegisterInstruction> registerCode;
+    // variable slot of each loaded value, every variable is loaded once
+    std::vector<int32_t> loads;
+    size_t               frameSize{ 0 };
+    // slot of result in frame
+    int32_t resultSlot{ 0 };
+
+    Tier tier{ Tier::Optimized };
+    // Counter and successor of a program shared between threads, a copy starts over
+    struct TierState {
+        std::atomic<uint32_t> executions{ 0 };
+        // set once promotion is claimed, so only one optimized program is compiled
+        std::atomic<bool> promoting{ false };
+        // set after successor, which never changes after
+        std::atomic<bool>                         promoted{ false };
+        std::shared_ptr<const CompiledExpression> successor;
+
+        TierState() = default;
+        TierState(const TierState &) {}
+        TierState &operator=(const TierState &) {
+            executions = 0;
+            promoting  = false;
+            promoted   = false;
+            successor.reset();
+            return *this;
+        }
+    };
+    mutable TierState tierState;
+
+    // Count one run, return count of runs including it
+    uint32_t CountExecution() const {
+        return tierState.executions.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    // Claim the promotion of program, true for the first caller only
+    bool ClaimPromotion() const {
+        // runs past threshold only read the flag once it is claimed
+        return !tierState.promoting.load(std::memory_order_relaxed) &&
+               !tierState.promoting.exchange(true);
+    }
+
+    // Publish optimized program that replaces this one, by the claimer only
+    void SetSuccessor(std::shared_ptr<const CompiledExpression> program) const {
+        tierState.successor = std::move(program);
+        tierState.promoted.store(true, std::memory_order_release);
+    }
+
+    // Optimized program that replaces this one, nullptr until it is compiled
+    std::shared_ptr<const CompiledExpression> GetSuccessor() const {
+        if (!tierState.promoted.load(std::memory_order_acquire)) return nullptr;
+        return tierState.successor;
+    }
+};
+} // namespace exp_solver
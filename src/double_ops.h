@@ -0,0 +1,95 @@
+/*
+
+double_ops.h
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Header only operators of double with
+the checks of Value, shared by evaluation in double
+and by code generated ahead of time, so both fail
+on the same operands.
+
+*/
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include "value.h"
+
+namespace exp_solver
+{
+namespace double_ops
+{
+// Whether v can be used as an integer operand
+inline bool IsInteger(double v) {
+    return v == std::floor(v) && std::fabs(v) < 9.2e18;
+}
+
+// NaN for fail, with reason in error
+inline double Fail(ValueError reason, ValueError &error) {
+    error = reason;
+    return std::numeric_limits<double>::quiet_NaN();
+}
+
+inline double Pow(double a, double b, ValueError &error) {
+    if (a < 0 && !IsInteger(b)) return Fail(ValueError::NegativePower, error);
+    if (a == 0 && b < 0) return Fail(ValueError::DenominatorZero, error);
+    return std::pow(a, b);
+}
+
+inline double Div(double a, double b, ValueError &error) {
+    if (b == 0) return Fail(ValueError::DenominatorZero, error);
+    return a / b;
+}
+
+inline double FloorDiv(double a, double b, ValueError &error) {
+    if (b == 0) return Fail(ValueError::DenominatorZero, error);
+    return std::floor(a / b);
+}
+
+inline double Mod(double a, double b, ValueError &error) {
+    if (!IsInteger(a) || !IsInteger(b)) return Fail(ValueError::ModFloat, error);
+    auto divisor = static_cast<int64_t>(b);
+    if (divisor == 0) return Fail(ValueError::ModZero, error);
+    // INT64_MIN % -1 traps
+    if (divisor == -1) return 0;
+    return static_cast<double>(static_cast<int64_t>(a) % divisor);
+}
+
+inline double Shl(double a, double b, ValueError &error) {
+    if (!IsInteger(a) || !IsInteger(b) || b < 0) return Fail(ValueError::LeftShiftFloat, error);
+    return std::ldexp(a, static_cast<int>(std::min(b, 2000.0)));
+}
+
+inline double Shr(double a, double b, ValueError &error) {
+    if (!IsInteger(a) || !IsInteger(b) || b < 0) return Fail(ValueError::RightShiftFloat, error);
+    return static_cast<double>(static_cast<int64_t>(a) >> static_cast<int>(std::min(b, 63.0)));
+}
+
+inline double And(double a, double b, ValueError &error) {
+    if (!IsInteger(a) || !IsInteger(b)) return Fail(ValueError::AndFloat, error);
+    return static_cast<double>(static_cast<int64_t>(a) & static_cast<int64_t>(b));
+}
+
+inline double Xor(double a, double b, ValueError &error) {
+    if (!IsInteger(a) || !IsInteger(b)) return Fail(ValueError::XorFloat, error);
+    return static_cast<double>(static_cast<int64_t>(a) ^ static_cast<int64_t>(b));
+}
+
+inline double Or(double a, double b, ValueError &error) {
+    if (!IsInteger(a) || !IsInteger(b)) return Fail(ValueError::OrFloat, error);
+    return static_cast<double>(static_cast<int64_t>(a) | static_cast<int64_t>(b));
+}
+
+// '~', a not integer is kept as it is for fail
+inline double Invert(double a, ValueError &error) {
+    if (a != std::floor(a) || std::fabs(a) >= 9.2e18) {
+        error = ValueError::InvertFloat;
+        return a;
+    }
+    return static_cast<double>(~static_cast<int64_t>(a));
+}
+} // namespace double_ops
+} // namespace exp_solver
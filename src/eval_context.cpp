@@ -0,0 +1,78 @@
+/*
+
+eval_context.cpp
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Implementation of EvalContext, whose
+programs run in TypedEvaluator like ExpSolver's.
+
+*/
+#include "eval_context.h"
+#include "typed_eval.h"
+
+namespace exp_solver
+{
+EvalContext::EvalContext(std::vector<Value> vals) : values(std::move(vals)) {}
+
+bool EvalContext::SetVariable(VariableHandle handle, const Value &value) {
+    if (handle < 0 || static_cast<size_t>(handle) >= values.size()) {
+        errors.Add(ErrorCode::InvalidHandle, handle);
+        return false;
+    }
+    if (!value.IsCalculable()) {
+        errors.Add(ErrorCode::ValueFailure, -1, 0, value.GetError());
+        return false;
+    }
+    values[handle] = value;
+    return true;
+}
+
+Value EvalContext::Evaluate(const CompiledExpression &program) {
+    errors.Clear();
+    if (!program.IsValid()) {
+        errors.Add(ErrorCode::InvalidExpression);
+        return {};
+    }
+    if (program.variableCount > values.size()) {
+        errors.Add(ErrorCode::ContextMissesVariables);
+        return {};
+    }
+    if (program.mode == NumericMode::Double) {
+        return RunDouble(program, values, doubleStack, doubleTemps, errors);
+    }
+    return Run(program, values, stack, temps, errors);
+}
+
+template <typename Variables>
+Value EvalContext::Run(const CompiledExpression &program, const Variables &variables,
+                       std::vector<Value> &stack, std::vector<Value> &temps,
+                       ErrorList &errors) {
+    Value result;
+    TypedEvaluator<Value>::Execute(program, program.literals.data(), variables, stack, temps,
+                                   errors, result);
+    return result;
+}
+
+template <typename Variables>
+Value EvalContext::RunDouble(const CompiledExpression &program, const Variables &variables,
+                             std::vector<double> &stack, std::vector<double> &temps,
+                             ErrorList &errors) {
+    double result = 0;
+    if (!TypedEvaluator<double>::Execute(program, program.doubleLiterals.data(), variables, stack,
+                                         temps, errors, result)) {
+        return {};
+    }
+    return Value(result);
+}
+
+template Value EvalContext::Run(const CompiledExpression &, const SymbolTable<Variable> &,
+                                std::vector<Value> &, std::vector<Value> &, ErrorList &);
+template Value EvalContext::Run(const CompiledExpression &, const std::vector<Value> &,
+                                std::vector<Value> &, std::vector<Value> &, ErrorList &);
+template Value EvalContext::RunDouble(const CompiledExpression &, const SymbolTable<Variable> &,
+                                      std::vector<double> &, std::vector<double> &, ErrorList &);
+template Value EvalContext::RunDouble(const CompiledExpression &, const std::vector<Value> &,
+                                      std::vector<double> &, std::vector<double> &, ErrorList &);
+} // namespace exp_solver
@@ -0,0 +1,80 @@
+/*
+
+eval_context.h
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Header file for EvalContext, the
+mutable state of evaluating a CompiledExpression:
+variable values, value stack and errors. Programs
+are immutable, so each thread can evaluate the
+same program with its own context without locks.
+
+*/
+#pragma once
+#include <string>
+#include <vector>
+#include "value.h"
+#include "compiled_exp.h"
+#include "exp_error.h"
+
+namespace exp_solver
+{
+class EvalContext {
+public:
+    EvalContext() = default;
+
+    // values[handle] is value of variable, see ExpSolver::CreateContext
+    explicit EvalContext(std::vector<Value> values);
+
+    /**
+     * @brief edit variable of this context only
+     * @param handle handle from ExpSolver::GetVariableHandle
+     * @param value  value of variable
+     * @return false if handle is invalid or value is not calculable
+     */
+    bool SetVariable(VariableHandle handle, const Value &value);
+
+    // Count of variables in this context
+    size_t GetVariableCount() const { return values.size(); }
+
+    /**
+     * @brief evaluate program with variable values of this context
+     * @note use GetErrorMessages() get fail reason
+     * @return result of output, empty for fail
+     */
+    Value Evaluate(const CompiledExpression &program);
+
+    // Text of errors of the latest call
+    std::string GetErrorMessages() const { return errors.Render(std::string()); }
+
+    const std::vector<ErrorRecord> &GetErrors() const { return errors.GetRecords(); }
+
+private:
+    friend class ExpSolver;
+
+    /**
+     * @brief run program with values of variables, stack and temps are reused between runs
+     * @tparam Variables SymbolTable<Variable> or std::vector<Value>
+     * @return result of output, empty for fail with reason added to errors
+     */
+    template <typename Variables>
+    static Value Run(const CompiledExpression &program, const Variables &variables,
+                     std::vector<Value> &stack, std::vector<Value> &temps, ErrorList &errors);
+
+    // Same as Run for program of double mode, computes in double only
+    template <typename Variables>
+    static Value RunDouble(const CompiledExpression &program, const Variables &variables,
+                           std::vector<double> &stack, std::vector<double> &temps,
+                           ErrorList &errors);
+
+    std::vector<Value> values;
+    std::vector<Value> stack;
+    // shared subexpressions
+    std::vector<Value> temps;
+    // stack and temps of double mode
+    std::vector<double> doubleStack, doubleTemps;
+    ErrorList           errors;
+};
+} // namespace exp_solver
@@ -0,0 +1,81 @@
+/*
+
+exp_cache.cpp
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Implementation of ExpressionCache.
+
+*/
+#include <algorithm>
+
+#include "exp_cache.h"
+
+namespace exp_solver
+{
+ExpressionCache::ExpressionCache(size_t capacity, size_t shardCount) :
+    shardCapacity((std::max<size_t>(capacity, 1) + std::max<size_t>(shardCount, 1) - 1)
+                  / std::max<size_t>(shardCount, 1)),
+    shards(std::max<size_t>(shardCount, 1)) {}
+
+ExpressionCache::Shard &ExpressionCache::ShardOf(const Key &key) {
+    // high bits, low bits of the same hash pick the bucket inside shard
+    return shards[(KeyHash()(key) >> 32) % shards.size()];
+}
+
+ExpressionCache::ProgramPtr ExpressionCache::Find(const std::string &exp, uint64_t version) {
+    Key                         key{ &exp, version };
+    auto                       &shard = ShardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto                        found = shard.index.find(key);
+    if (found == shard.index.end()) {
+        shard.misses++;
+        return nullptr;
+    }
+    shard.hits++;
+    shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+    return found->second->program;
+}
+
+void ExpressionCache::Insert(const std::string &exp, uint64_t version, ProgramPtr program) {
+    Key                         key{ &exp, version };
+    auto                       &shard = ShardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto                        found = shard.index.find(key);
+    if (found != shard.index.end()) {
+        found->second->program = std::move(program);
+        shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+        return;
+    }
+    if (shard.entries.size() >= shardCapacity) {
+        auto &last = shard.entries.back();
+        shard.index.erase(Key{ &last.exp, last.version });
+        shard.entries.pop_back();
+        shard.evictions++;
+    }
+    shard.entries.push_front(Entry{ exp, version, std::move(program) });
+    auto &entry = shard.entries.front();
+    shard.index.emplace(Key{ &entry.exp, entry.version }, shard.entries.begin());
+}
+
+ExpressionCache::Stats ExpressionCache::GetStats() const {
+    Stats stats;
+    for (const auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        stats.hits += shard.hits;
+        stats.misses += shard.misses;
+        stats.evictions += shard.evictions;
+        stats.size += shard.entries.size();
+    }
+    return stats;
+}
+
+void ExpressionCache::Clear() {
+    for (auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.entries.clear();
+        shard.index.clear();
+    }
+}
+} // namespace exp_solver
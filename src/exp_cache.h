@@ -0,0 +1,88 @@
+/*
+
+exp_cache.h
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Header file for ExpressionCache, a
+bounded thread safe LRU cache from expression text
+to shared compiled program, split into shards that
+each have their own lock.
+
+*/
+#pragma once
+#include <string>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "compiled_exp.h"
+
+namespace exp_solver
+{
+class ExpressionCache {
+public:
+    struct Stats {
+        uint64_t hits{ 0 }, misses{ 0 }, evictions{ 0 };
+        // programs in cache now
+        size_t size{ 0 };
+    };
+
+    using ProgramPtr = std::shared_ptr<const CompiledExpression>;
+
+    /**
+     * @param capacity max programs kept, split evenly to shards
+     * @param shards   count of shards, more shards less lock contention
+     */
+    explicit ExpressionCache(size_t capacity, size_t shards = 16);
+
+    /**
+     * @brief find program of expression compiled with symbol version
+     * @return program, nullptr if not cached
+     */
+    ProgramPtr Find(const std::string &exp, uint64_t version);
+
+    // Add or replace program, least recently used one is evicted if shard is full
+    void Insert(const std::string &exp, uint64_t version, ProgramPtr program);
+
+    Stats GetStats() const;
+
+    void Clear();
+
+private:
+    struct Entry {
+        std::string exp;
+        uint64_t    version;
+        ProgramPtr  program;
+    };
+    // refers to the text of an entry, or of the caller while finding,
+    // so finding does not copy the expression
+    struct Key {
+        const std::string *exp;
+        uint64_t           version;
+        bool               operator==(const Key &other) const {
+            return version == other.version && *exp == *other.exp;
+        }
+    };
+    struct KeyHash {
+        size_t operator()(const Key &key) const {
+            return std::hash<std::string>()(*key.exp) ^ (key.version * 0x9E3779B97F4A7C15ull);
+        }
+    };
+    struct Shard {
+        mutable std::mutex mutex;
+        // most recently used at front
+        std::list<Entry>                                         entries;
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+        uint64_t hits{ 0 }, misses{ 0 }, evictions{ 0 };
+    };
+
+    Shard &ShardOf(const Key &key);
+
+    size_t                   shardCapacity;
+    std::vector<Shard>       shards;
+};
+} // namespace exp_solver
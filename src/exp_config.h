@@ -17,3 +17,13 @@
 #ifndef EXP_SOLVER_DEBUG
 #    define EXP_SOLVER_DEBUG 1
 #endif // !EXP_SOLVER_DEBUG
+
+/// threaded dispatch of evaluator, jumps through a table of label addresses
+/// instead of a switch, needs labels as values of GNU C
+#ifndef EXP_THREADED_DISPATCH
+#    if defined(__GNUC__) || defined(__clang__)
+#        define EXP_THREADED_DISPATCH 1
+#    else
+#        define EXP_THREADED_DISPATCH 0
+#    endif // defined(__GNUC__) || defined(__clang__)
+#endif     // !EXP_THREADED_DISPATCH
@@ -0,0 +1,59 @@
+/*
+
+exp_error.cpp
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Implementation of ErrorList.
+
+*/
+#include "exp_error.h"
+
+namespace exp_solver
+{
+std::string ErrorList::Render(const std::string &text) const {
+    std::string out;
+    for (const auto &record : records) {
+        std::string range;
+        if (record.offset >= 0 && static_cast<size_t>(record.offset) <= text.size()) {
+            range = text.substr(record.offset, record.length);
+        }
+        std::string value_error = GetValueErrorText(record.valueError);
+        switch (record.code) {
+            case ErrorCode::InvalidExpression: out += "Invalid expression! "; break;
+            case ErrorCode::CalculationAborted:
+                out += "Calculation aborted";
+                if (!value_error.empty()) out += ", cuz: " + value_error;
+                break;
+            case ErrorCode::LexAborted: out += "Calculation aborted. "; break;
+            case ErrorCode::CompileAborted: out += "Compile aborted. "; break;
+            case ErrorCode::ValueFailure: out += value_error; break;
+            case ErrorCode::BracketsNotPaired: out += "Syntax error: Brackets not paired! "; break;
+            case ErrorCode::UnknownName: out += "String \"" + range + "\" not recognized! "; break;
+            case ErrorCode::NeedBrackets:
+                out += "Syntax Error: Need brackets after function name! ";
+                break;
+            case ErrorCode::NegativeSqrt:
+                out += "Arithmetic error: Cannot square root a negative number! ";
+                break;
+            case ErrorCode::UnknownFunction:
+                out += "Internal bug, function '" + range + "' not exists";
+                break;
+            case ErrorCode::UnknownCharacter:
+                out += "Encountered unknown character at " + range + "!";
+                break;
+            case ErrorCode::InvalidOperator: out += "Invalid operator: " + range; break;
+            case ErrorCode::InvalidHandle:
+                out += "Invalid variable handle " + std::to_string(record.offset) + "! ";
+                break;
+            case ErrorCode::ForeignProgram: out += "Program is not compiled by this solver! "; break;
+            case ErrorCode::ContextMissesVariables:
+                out += "Program uses variables not in context! ";
+                break;
+        }
+        out += '\n';
+    }
+    return out;
+}
+} // namespace exp_solver
@@ -0,0 +1,81 @@
+/*
+
+exp_error.h
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Header file for ErrorCode and
+ErrorList, errors recorded as codes with the
+range of expression they refer to, turned into
+text only when the messages are asked for.
+
+*/
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "value.h"
+
+namespace exp_solver
+{
+enum class ErrorCode : uint8_t {
+    // "Invalid expression! "
+    InvalidExpression,
+    // "Calculation aborted", with reason if value error is set
+    CalculationAborted,
+    // lexing failed, "Calculation aborted. "
+    LexAborted,
+    CompileAborted,
+    // value error without more context
+    ValueFailure,
+    BracketsNotPaired,
+    // name at range is not a function, constant or variable
+    UnknownName,
+    NeedBrackets,
+    NegativeSqrt,
+    // name at range is a function without implementation
+    UnknownFunction,
+    UnknownCharacter,
+    // symbol at range is not an operator
+    InvalidOperator,
+    // offset is the handle
+    InvalidHandle,
+    ForeignProgram,
+    ContextMissesVariables
+};
+
+struct ErrorRecord {
+    ErrorCode code;
+    // detail of CalculationAborted and ValueFailure
+    ValueError valueError;
+    // range of expression the error refers to, offset -1 if none
+    int32_t offset, length;
+};
+
+/**
+ * @brief errors of the latest call, recording one costs no allocation
+ *        once the list has grown, text is made by Render
+ */
+class ErrorList {
+public:
+    void Clear() { records.clear(); }
+    bool Empty() const { return records.empty(); }
+
+    void Add(ErrorCode code, int32_t offset = -1, int32_t length = 0,
+             ValueError valueError = ValueError::None) {
+        records.push_back({ code, valueError, offset, length });
+    }
+
+    const std::vector<ErrorRecord> &GetRecords() const { return records; }
+
+    /**
+     * @brief human readable text of every error, one line each
+     * @param text expression the ranges of errors refer to
+     */
+    std::string Render(const std::string &text) const;
+
+private:
+    std::vector<ErrorRecord> records;
+};
+} // namespace exp_solver
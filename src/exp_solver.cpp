@@ -16,7 +16,9 @@ strings and solves them.
 #include <vector>
 #include <algorithm>
 #include <iomanip>
-#include <regex>
+#include <map>
+#include <array>
+#include <cstring>
 
 #include <cctype>
 #include <cmath>
@@ -34,169 +36,455 @@ using std::vector;
 // ******************** //
 
 // Constructor
-ExpSolver::ExpSolver() {
-    AddPredefined();
-}
+ExpSolver::ExpSolver(NumericMode mode) :
+    constants(Registry::Predefined().constants), functions(Registry::Predefined().functions),
+    symbolVersion(14695981039346656037ull), mode(mode) {}
 
 void ExpSolver::SetExp(const std::string &exp)
 {
+    cachedProgram.reset();
     expression = exp;
     PreprocessExp();
 }
 
 Value ExpSolver::ResolveExp() {
+    // a variable added since compiling, refetch the program so it can still be promoted
+    if (compiler && cachedProgram && cachedProgram->variableCount != variables.Size()) {
+        cachedProgram.reset();
+    }
+    if (cachedProgram) return compiler ? EvaluateTiered() : Evaluate(*cachedProgram);
     if (expression.empty()) {
         return {};
     }
-    error_messages.clear();
-    error_messages.str("");
-    // Recursively solve the expression
-    Value result = CalculateExp(expression, 0, blocks.size());
+    // compile expression set by SetExp once, later calls only run the program
+    auto program = compiler ? CompileTiered(expression) : CompileCached(expression);
+    if (!program->IsValid()) return {};
+    cachedProgram = std::move(program);
+    return compiler ? EvaluateTiered() : Evaluate(*cachedProgram);
+}
 
-    if (result.IsCalculable()) {
-        // Create output string
-        return result;
-    } else {
-        // blocks.clear();
-        auto value_error = result.GetErrorMessage();
-        error_messages << "Calculation aborted"
-                       << (value_error.empty() ? "" : (", cuz: " + value_error)) << std::endl;
-        return {};
+Value ExpSolver::SolveExp(const string &input) {
+    if (compiler) {
+        // same input again with no variable added, the current program still holds
+        if (!cachedProgram || cachedProgram->expression != input ||
+            cachedProgram->variableCount != variables.Size()) {
+            auto program = CompileTiered(input);
+            if (!program->IsValid()) return {};
+            cachedProgram = std::move(program);
+        }
+        return EvaluateTiered();
     }
+    if (cache) {
+        auto program = CompileCached(input);
+        if (!program->IsValid()) return {};
+        cachedProgram = std::move(program);
+        return Evaluate(*cachedProgram);
+    }
+
+    // same input again with no variable added, the last program still holds
+    if (solveProgram.IsValid() && solveProgram.variableCount == variables.Size()
+        && solveProgram.expression == input) {
+        cachedProgram.reset();
+        expression = input;
+        return Evaluate(solveProgram);
+    }
+    CompileInto(input, false, false, solveProgram);
+    if (!solveProgram.IsValid()) return {};
+    return Evaluate(solveProgram);
 }
 
-Value ExpSolver::SolveExp(const string &input) {
+
+CompiledExpression ExpSolver::Compile(const std::string &input) {
+    return CompileProgram(input, false);
+}
+
+CompiledExpression ExpSolver::CompileExact(const std::string &input) {
+    return CompileProgram(input, true);
+}
+
+CompiledExpression ExpSolver::CompileProgram(const std::string &input, bool exact) {
+    CompiledExpression program;
+    CompileInto(input, exact, true, program);
+    return program;
+}
+
+void ExpSolver::CompileInto(const std::string &input, bool exact, bool optimize,
+                            CompiledExpression &program) {
     // clean old result
     blocks.clear();
-    error_messages.clear();
-    error_messages.str("");
+    errors.Clear();
+
+    cachedProgram.reset();
+    program.Clear();
+    program.expression    = input;
+    program.variableCount = variables.Size();
+    program.exact         = exact;
+    program.mode          = exact ? NumericMode::Rational : mode;
+    program.tier          = optimize ? Tier::Optimized : Tier::Interpreted;
 
     expression = input;
     PreprocessExp();
 
-    if (expression.empty()) {
-        return {};
+    if (blocks.empty()) {
+        if (!expression.empty()) errors.Add(ErrorCode::InvalidExpression);
+        return;
     }
 
-    // Recursively solve the expression
-    Value result = CalculateExp(expression, 0, blocks.size());
+    auto &nodes = buffers.nodes;
+    nodes.clear();
+    int root = CompileRange(program, nodes, 0, blocks.size());
+    if (root < 0) {
+        errors.Add(ErrorCode::CompileAborted);
+        return;
+    }
 
-    if (result.IsCalculable()) {
-        // Create output
-        return result;
+    program.stats.nodes = nodes.size();
+    // a program run once gains nothing from folding and sharing before its run,
+    // folding computes in Value, exact program keeps literals as they are
+    if (optimize && !exact) FoldConstants(program, nodes);
+    if (optimize) {
+        root = EliminateCommonSubexp(program, nodes, root);
+        EmitProgram(program, nodes, root);
     } else {
-        blocks.clear();
-        auto value_error = result.GetErrorMessage();
-        error_messages << "Calculation aborted"
-                       << (value_error.empty() ? "" : (", cuz: " + value_error)) << std::endl;
+        EmitInOrder(program, nodes);
+    }
+    // exact program is run in stack form by EvaluateExact
+    if (!exact && (backend == Backend::Register ||
+                   (backend == Backend::Auto && optimize &&
+                    program.code.size() >= register_threshold))) {
+        program.AllocateRegisters();
+    }
+    if (program.mode == NumericMode::Double) {
+        for (const auto &literal : program.literals) {
+            program.doubleLiterals.push_back(literal.GetValueDouble());
+        }
+    }
+}
+
+Value ExpSolver::Evaluate(const CompiledExpression &program) {
+    errors.Clear();
+
+    if (!program.IsValid()) {
+        errors.Add(ErrorCode::InvalidExpression);
         return {};
     }
+
+    if (program.variableCount > variables.Size()) {
+        errors.Add(ErrorCode::ForeignProgram);
+        return {};
+    }
+
+    if (program.mode == NumericMode::Double) {
+        return EvalContext::RunDouble(program, variables, doubleStack, doubleTemps, errors);
+    }
+    return EvalContext::Run(program, variables, evalStack, evalTemps, errors);
 }
 
+BigRational ExpSolver::EvaluateExact(const CompiledExpression &program) {
+    errors.Clear();
+
+    if (!program.IsValid()) {
+        errors.Add(ErrorCode::InvalidExpression);
+        return {};
+    }
+
+    if (program.variableCount > variables.Size()) {
+        errors.Add(ErrorCode::ForeignProgram);
+        return {};
+    }
+
+    auto &stack = exactStack;
+    auto &temps = exactTemps;
+    stack.clear();
+    if (temps.size() < program.tempCount) temps.resize(program.tempCount);
+    for (const auto &instruction : program.code) {
+        switch (instruction.code) {
+            case OpCode::Store: temps[instruction.arg] = stack.back(); break;
+            case OpCode::Load: stack.push_back(temps[instruction.arg]); break;
+            case OpCode::PushValue:
+                stack.push_back(program.exact ? program.exactLiterals[instruction.arg]
+                                              : BigRational(program.literals[instruction.arg]));
+                break;
+            case OpCode::PushVar:
+                stack.push_back(BigRational(variables[instruction.arg].value));
+                break;
+            case OpCode::CallSqrt:
+                if (stack.back().IsCalculable() && stack.back().GetUp().IsNegative()) {
+                    errors.Add(ErrorCode::NegativeSqrt);
+                    return {};
+                }
+                // fall through
+            case OpCode::Call: {
+                auto &value = stack.back();
+                if (!value.IsCalculable()) {
+                    errors.Add(ErrorCode::ValueFailure, -1, 0, value.GetError());
+                    return {};
+                }
+                value = BigRational::FromDouble(
+                    program.functions[instruction.arg].func(value.GetValueDouble()));
+                break;
+            }
+            case OpCode::Invert: stack.back() = ~stack.back(); break;
+            case OpCode::Neg: stack.back() = -stack.back(); break;
+            default: {
+                // binary operator, left operand is on top
+                auto left = std::move(stack.back());
+                stack.pop_back();
+                stack.back() = ApplyOperator(instruction.code, left, stack.back());
+                break;
+            }
+        }
+    }
+
+    const auto &result = stack.back();
+    if (result.IsCalculable()) { return result; }
+    errors.Add(ErrorCode::CalculationAborted, -1, 0, result.GetError());
+    return {};
+}
+
+BigRational ExpSolver::SolveExact(const std::string &input) {
+    auto program = CompileExact(input);
+    if (!program.IsValid()) return {};
+    return EvaluateExact(program);
+}
+
+bool ExpSolver::EvaluateBatch(const CompiledExpression &program,
+                              const std::vector<const double *> &columns, size_t rows,
+                              double *output) {
+    std::vector<double> scalars;
+    if (!PrepareBatch(program, scalars)) return false;
+
+    BatchEvaluator evaluator(program, columns, std::move(scalars));
+    evaluator.Run(0, rows, output);
+    return true;
+}
+
+bool ExpSolver::EvaluateBatch(const CompiledExpression &program,
+                              const std::vector<const double *> &columns, size_t rows,
+                              double *output, ThreadPool &pool, size_t grain) {
+    std::vector<double> scalars;
+    if (!PrepareBatch(program, scalars)) return false;
+
+    // scratch of evaluator is not shared, so one evaluator per thread
+    std::vector<BatchEvaluator> evaluators(pool.GetThreadCount(),
+                                           BatchEvaluator(program, columns, std::move(scalars)));
+    pool.ParallelFor(rows, grain, [&](size_t begin, size_t end, size_t worker) {
+        evaluators[worker].Run(begin, end, output);
+    });
+    return true;
+}
+
+
+void ExpSolver::SetCache(std::shared_ptr<ExpressionCache> newCache) {
+    cache = std::move(newCache);
+}
+
+std::shared_ptr<const CompiledExpression> ExpSolver::CompileCached(const std::string &input) {
+    if (cache) {
+        if (auto program = cache->Find(input, ProgramVersion())) {
+            errors.Clear();
+            return program;
+        }
+    }
+    auto program = std::make_shared<const CompiledExpression>(Compile(input));
+    if (cache && program->IsValid()) cache->Insert(input, ProgramVersion(), program);
+    return program;
+}
+
+void ExpSolver::SetTiering(std::shared_ptr<BackgroundCompiler> newCompiler, uint32_t threshold) {
+    compiler           = std::move(newCompiler);
+    promotionThreshold = std::max<uint32_t>(threshold, 1);
+    cachedProgram.reset();
+    compilerSolver.reset();
+}
+
+Tier ExpSolver::GetTier() const {
+    if (cachedProgram) return cachedProgram->GetTier();
+    return solveProgram.GetTier();
+}
+
+std::shared_ptr<const CompiledExpression> ExpSolver::CompileTiered(const std::string &input) {
+    if (cache) {
+        if (auto program = cache->Find(input, ProgramVersion())) {
+            errors.Clear();
+            return program;
+        }
+    }
+    auto program = std::make_shared<CompiledExpression>();
+    CompileInto(input, false, false, *program);
+    if (cache && program->IsValid()) cache->Insert(input, ProgramVersion(), program);
+    return program;
+}
+
+Value ExpSolver::EvaluateTiered() {
+    if (auto successor = cachedProgram->GetSuccessor()) cachedProgram = std::move(successor);
+    // counted by every solver running it, the first one past threshold that reads the
+    // same variables claims it, the optimized program must read them to replace it
+    if (cachedProgram->tier == Tier::Interpreted &&
+        cachedProgram->CountExecution() >= promotionThreshold &&
+        cachedProgram->variableCount == variables.Size() && cachedProgram->ClaimPromotion()) {
+        Promote(cachedProgram);
+    }
+    return Evaluate(*cachedProgram);
+}
+
+void ExpSolver::Promote(const std::shared_ptr<const CompiledExpression> &program) {
+    if (!compilerSolver || compilerSolver->symbolVersion != symbolVersion ||
+        compilerSolver->backend != backend) {
+        compilerSolver                = std::make_shared<ExpSolver>(mode);
+        compilerSolver->variables     = variables;
+        compilerSolver->symbolVersion = symbolVersion;
+        compilerSolver->backend       = backend;
+    }
+    // jobs of one compiler run one at a time, so they can share the solver
+    auto solver  = compilerSolver;
+    auto shared  = cache;
+    auto version = ProgramVersion();
+    compiler->Submit([solver, program, shared, version]() {
+        auto optimized = std::make_shared<const CompiledExpression>(
+            solver->Compile(program->expression));
+        if (!optimized->IsValid()) return;
+        program->SetSuccessor(optimized);
+        if (shared) shared->Insert(program->expression, version, std::move(optimized));
+    });
+}
+
+uint64_t ExpSolver::ProgramVersion() const {
+    return mode == NumericMode::Rational ? symbolVersion : ~symbolVersion;
+}
 
 std::string ExpSolver::GetErrorMessages() const {
-    return error_messages.str();
+    return errors.Render(expression);
 }
 
 
 bool ExpSolver::UpdateVariable(const std::string &name, const Value &value) {
     if (!value.IsCalculable()) {
-        error_messages << value.GetErrorMessage();
+        errors.Add(ErrorCode::ValueFailure, -1, 0, value.GetError());
         return false;
     }
-    for (auto &variable : variables) {
-        if (name.compare(variable.name) == 0) {
-            variable.value = value;
-            return true;
-        }
+    auto index = variables.Find(name);
+    if (index >= 0) {
+        variables[index].value = value;
+        return true;
+    }
+    variables.Insert(Variable(name, value));
+    // '\0' ends each name so "ab","c" differs from "a","bc"
+    for (size_t i = 0; i <= name.size(); i++) {
+        symbolVersion ^= i < name.size() ? static_cast<unsigned char>(name[i]) : 0;
+        symbolVersion *= 1099511628211ull;
     }
-    variables.push_back(Variable(name, value));
     return true;
 }
 
+VariableHandle ExpSolver::GetVariableHandle(const std::string &name) const {
+    return variables.Find(name);
+}
+
+bool ExpSolver::UpdateVariable(VariableHandle handle, const Value &value) {
+    if (handle < 0 || static_cast<size_t>(handle) >= variables.Size()) {
+        errors.Add(ErrorCode::InvalidHandle, handle);
+        return false;
+    }
+    if (!value.IsCalculable()) {
+        errors.Add(ErrorCode::ValueFailure, -1, 0, value.GetError());
+        return false;
+    }
+    variables[handle].value = value;
+    return true;
+}
+
+
+EvalContext ExpSolver::CreateContext() const {
+    std::vector<Value> values;
+    values.reserve(variables.Size());
+    for (const auto &variable : variables) values.push_back(variable.value);
+    return EvalContext(std::move(values));
+}
+
 
 // ********************* //
 // * Private Functions * //
 // ********************* //
 
-// Add predefined constants and functions
-void ExpSolver::AddPredefined() {
-    constants.push_back(Variable("e", Value(M_E)));
-    constants.push_back(Variable("pi", Value(M_PI)));
-    functions.push_back(Function("sin", std::sin));
-    functions.push_back(Function("cos", std::cos));
-    functions.push_back(Function("tan", std::tan));
-    functions.push_back(Function("exp", std::exp));
-    functions.push_back(Function("sqrt", std::sqrt));
-    functions.push_back(Function("floor", std::floor));
-    functions.push_back(Function("ceil", std::ceil));
-    functions.push_back(Function("round", round));
-    functions.push_back(Function("ln", std::log));
-    functions.push_back(Function("log", std::log10));
-    functions.push_back(Function("abs", std::abs));
+bool ExpSolver::PrepareBatch(const CompiledExpression &program, std::vector<double> &scalars) {
+    errors.Clear();
+
+    if (!program.IsValid()) {
+        errors.Add(ErrorCode::InvalidExpression);
+        return false;
+    }
+    if (program.variableCount > variables.Size()) {
+        errors.Add(ErrorCode::ForeignProgram);
+        return false;
+    }
+
+    scalars.reserve(variables.Size());
+    for (const auto &variable : variables) scalars.push_back(variable.value.GetValueDouble());
+    return true;
 }
 
 void ExpSolver::PreprocessExp()
 {
-     // Discard all spaces in the expression
-    auto exp = expression;
-    expression.clear();
-    exp.erase(std::remove_if(exp.begin(), exp.end(), ::isspace), exp.end());
+    // Discard all spaces in the expression, in place so its buffer is reused
+    expression.erase(std::remove_if(expression.begin(), expression.end(), ::isspace),
+                     expression.end());
 
     // Deal with no right-hand-side input
-    if (exp.length() == 0) {
-        error_messages << "Invalid expression! " << std::endl;
+    if (expression.length() == 0) {
+        errors.Add(ErrorCode::InvalidExpression);
         blocks.clear();
         return;
     }
 
-    // Deal with negative signs in the expression
-    DealWithNegativeSign(exp);
-
     // Group the expression into substrings
     // and calculate the bracket level of each substring
-    bool groupSucceed = GroupExp(exp);
+    bool groupSucceed = GroupExp(expression);
 
     if (!groupSucceed) {
         blocks.clear();
-        error_messages << "Calculation aborted. " << std::endl;
+        errors.Add(ErrorCode::LexAborted);
     }
-    expression = exp;
 }
 
 
 // reference: https://docs.python.org/zh-cn/3.7/reference/expressions.html#operator-precedence
-// The smaller the ordinal, the higher the priority
-#ifdef EXP_HAS_STRING_VIEW
-static const vector<vector<std::string_view>> sym_priority_vec{
-    { "**" }, { "~" }, { "*", "/", "//", "%" }, { "+", "-" }, { "<<", ">>" }, { "&" },
-    { "^" },  { "|" }
-};
-#else
-static const vector<vector<string>> sym_priority_vec = {
-    { "**" }, { "~" }, { "*", "/", "//", "%" }, { "+", "-" }, { "<<", ">>" }, { "&" },
-    { "^" },  { "|" }
-};
-#endif
+// The smaller the ordinal, the higher the priority,
+// 1 is '~' and negative sign
+static int OperatorPriority(OpCode code) {
+    switch (code) {
+        case OpCode::Pow: return 0;
+        case OpCode::Mul:
+        case OpCode::Div:
+        case OpCode::FloorDiv:
+        case OpCode::Mod: return 2;
+        case OpCode::Add:
+        case OpCode::Sub: return 3;
+        case OpCode::Shl:
+        case OpCode::Shr: return 4;
+        case OpCode::And: return 5;
+        case OpCode::Xor: return 6;
+        case OpCode::Or: return 7;
+        default: return INT32_MAX;
+    }
+}
 
-static void SetPriority(const string &exp, Block &block) {
+// Resolve operator of symbol block once, so it is never compared as text again
+static void SetOperator(const string &exp, Block &block) {
     if (block.type != BlockType::Sym) return;
 #ifdef EXP_HAS_STRING_VIEW
     auto sym = std::string_view{ exp }.substr(block.start, block.end - block.start);
 #else
     auto sym = exp.substr(block.start, block.end - block.start);
 #endif
-    for (size_t i = 0; i < sym_priority_vec.size(); i++) {
-        bool found = false;
-        for (size_t k = 0; k < sym_priority_vec[i].size(); k++) {
-            if (sym == sym_priority_vec[i][k]) {
-                block.priority = i;
-                found          = true;
-                break;
-            }
-        }
-        if (found) break;
+    // negative sign has the same priority as '~'
+    if (block.unary) {
+        block.code     = sym == "~" ? OpCode::Invert : OpCode::Neg;
+        block.priority = 1;
+        return;
     }
+    block.code     = ParseOperator(sym);
+    block.priority = OperatorPriority(block.code);
 }
 
 // This is similar to lexical analysis in a compiler
@@ -208,6 +496,9 @@ bool ExpSolver::GroupExp(const string &exp) {
     // Record type of the last character
     BlockType lastType = Nil;
 
+    // Block ids of '(' not paired yet
+    auto &openBrackets = bracketStack;
+    openBrackets.clear();
 
     for (size_t i = 0; i <= exp.length(); i++) {
         // Record type of the just inspected character
@@ -221,23 +512,49 @@ bool ExpSolver::GroupExp(const string &exp) {
         // needNewBlock |= (lastType == Sym);
         needNewBlock |= (thisType != lastType);
         needNewBlock |= (i == exp.length());
-        // once encounter ~, new a block
-        needNewBlock |= exp[i] == '~';
+        // once encounter ~ or -, new a block
+        needNewBlock |= exp[i] == '~' || exp[i] == '-';
         // function can has num in name
         needNewBlock &= !(thisType == Num && lastType == Func);
 
         if (needNewBlock) {
             // Label string as function, constant or variable
+            int symbol = -1;
             if (lastType == Func) {
-                lastType = AnalyzeStrType(exp.substr(start, i - start));
+#ifdef EXP_HAS_STRING_VIEW
+                lastType = AnalyzeStrType(std::string_view{ exp }.substr(start, i - start), start,
+                                          symbol);
+#else
+                lastType = AnalyzeStrType(exp.substr(start, i - start), start, symbol);
+#endif
                 if (lastType == Nil) return false;
             }
 
             // Push new block into stack
             // if it's not the case where there is '(' at start
             if (i != 0) {
-                auto newBlock = Block(start, i, level, lastType);
-                SetPriority(exp, newBlock);
+                auto newBlock   = Block(start, i, level, lastType);
+                newBlock.symbol = symbol;
+                // '-' is negative sign at start, after '(' or after another operator
+                if (lastType == Sym) {
+                    newBlock.unary = exp[start] == '~'
+                                     || (exp[start] == '-' && i - start == 1
+                                         && (blocks.empty() || blocks.back().type == Sym
+                                             || blocks.back().type == BracL));
+                }
+                SetOperator(exp, newBlock);
+                // Pair brackets so evaluation can jump over them directly
+                if (lastType == BracL) {
+                    openBrackets.push_back(blocks.size());
+                } else if (lastType == BracR) {
+                    if (openBrackets.empty()) {
+                        errors.Add(ErrorCode::BracketsNotPaired, start, i - start);
+                        return false;
+                    }
+                    newBlock.match                    = openBrackets.back();
+                    blocks[openBrackets.back()].match = blocks.size();
+                    openBrackets.pop_back();
+                }
                 blocks.push_back(newBlock);
 #if EXP_SOLVER_DEBUG
                 std::cout << exp.substr(newBlock.start, newBlock.end - newBlock.start) << std::endl;
@@ -257,9 +574,8 @@ bool ExpSolver::GroupExp(const string &exp) {
     }
 
     // Throw error if brackets are not paired
-    // (diagonized by inspecting variable level)
-    if (level != 0) {
-        error_messages << "Syntax error: Brackets not paired! " << std::endl;
+    if (!openBrackets.empty()) {
+        errors.Add(ErrorCode::BracketsNotPaired, blocks[openBrackets.back()].start, 1);
         return false;
     }
 
@@ -267,17 +583,15 @@ bool ExpSolver::GroupExp(const string &exp) {
 }
 
 // Analyze whether a string Block is of BlockType Func, Constant or Var
-BlockType ExpSolver::AnalyzeStrType(const string &str) {
-    for (auto &function : functions) {
-        if (str.compare(function.name) == 0) return Func;
-    }
-    for (auto &constant : constants) {
-        if (str.compare(constant.name) == 0) return Constant;
-    }
-    for (auto &variable : variables) {
-        if (str.compare(variable.name) == 0) return Var;
-    }
-    error_messages << "String \"" << str << "\" not recognized! " << std::endl;
+#ifdef EXP_HAS_STRING_VIEW
+BlockType ExpSolver::AnalyzeStrType(std::string_view str, int offset, int &symbol) {
+#else
+BlockType ExpSolver::AnalyzeStrType(const string &str, int offset, int &symbol) {
+#endif
+    if ((symbol = functions.Find(str)) >= 0) return Func;
+    if ((symbol = constants.Find(str)) >= 0) return Constant;
+    if ((symbol = variables.Find(str)) >= 0) return Var;
+    errors.Add(ErrorCode::UnknownName, offset, str.size());
     return Nil;
 }
 
@@ -303,258 +617,341 @@ BlockType ExpSolver::Char2Type(char c) {
         return Nil;
 }
 
-// prefix with sym_char replace to (0-)
-// example expression: "-2*3" and "3*-2", will replace to "(0-2)*3" and "3*(0-2)"
-static const std::regex negative_pattern{ R"(([+\-*\/^%&|<>~]|^)(-[\d.]+))" };
-// "-(1+1)" -> "0-(1+1)", "(-2)+1" -> "(0-2)+1"
-static const std::regex negative_pattern2{ R"((\(|^)(?=-(?:[\d(])))" };
-
-// Replace every "-" as negative sign by "0-"
-void ExpSolver::DealWithNegativeSign(string &exp) {
-    exp = std::regex_replace(exp, negative_pattern, "$1(0$2)");
-#if EXP_SOLVER_DEBUG
-    std::cout << "replace to:" << exp << std::endl;
-#endif
-    exp = std::regex_replace(exp, negative_pattern2, "$010");
-#if EXP_SOLVER_DEBUG
-    std::cout << "replace to:" << exp << std::endl;
-#endif
+// Evaluate nodes whose operands are all literals once, and turn them into literals.
+// Children always come before parents in nodes, so one pass folds whole constant subtrees
+void ExpSolver::FoldConstants(CompiledExpression &program, std::vector<ExpNode> &nodes) {
+    for (auto &node : nodes) {
+        if (node.left < 0 || nodes[node.left].code != OpCode::PushValue) continue;
+        if (node.right >= 0 && nodes[node.right].code != OpCode::PushValue) continue;
+
+        const auto &value = program.literals[nodes[node.left].arg];
+        Value       result;
+        if (program.mode == NumericMode::Double) {
+            // fold in double like evaluation does
+            double     operand = value.GetValueDouble(), folded;
+            ValueError error   = ValueError::None;
+            switch (node.code) {
+                case OpCode::CallSqrt:
+                    if (operand < 0) continue;
+                    // fall through
+                case OpCode::Call: folded = program.functions[node.arg].func(operand); break;
+                // ~ is rare, left to evaluation
+                case OpCode::Invert: continue;
+                case OpCode::Neg: folded = -operand; break;
+                default:
+                    folded = ApplyOperator(node.code, operand,
+                                           program.literals[nodes[node.right].arg].GetValueDouble(),
+                                           error);
+                    break;
+            }
+            if (error != ValueError::None) continue;
+            program.literals.push_back(Value(folded));
+            node = ExpNode(OpCode::PushValue, program.literals.size() - 1);
+            program.stats.foldedNodes++;
+            continue;
+        }
+        switch (node.code) {
+            case OpCode::CallSqrt:
+                if (value.GetValueDouble() < 0) continue;
+                // fall through
+            case OpCode::Call:
+                result = Value(program.functions[node.arg].func(value.GetValueDouble()));
+                break;
+            case OpCode::Invert: result = ~value; break;
+            case OpCode::Neg: result = -value; break;
+            default:
+                result = ApplyOperator(node.code, value, program.literals[nodes[node.right].arg]);
+                break;
+        }
+        // keep failed one, so evaluation reports the error
+        if (!result.IsCalculable()) continue;
+        program.literals.push_back(result);
+        node = ExpNode(OpCode::PushValue, program.literals.size() - 1);
+        program.stats.foldedNodes++;
+    }
 }
 
-// Calculate expression in block range [startBlock,endBlock)
-Value ExpSolver::CalculateExp(const string &exp, int startBlock, int endBlock) {
-    // Create stacks that stores operands and operators
-    std::stack<Value> values;
-    std::stack<Block> ops;
-
-    for (int i = endBlock - 1; i >= startBlock; i--) {
-// Record the content of the current block
-#ifdef EXP_HAS_STRING_VIEW
-        std::string_view blockStr =
-            std::string_view{ exp }.substr(blocks[i].start, blocks[i].end - blocks[i].start);
-#else
-        string blockStr = exp.substr(blocks[i].start, blocks[i].end - blocks[i].start);
-#endif
+// Make identical subtrees share one node, return the new root.
+// Children always come before parents in nodes, so children of a node
+// are already shared when the node is looked up
+int ExpSolver::EliminateCommonSubexp(CompiledExpression &program, std::vector<ExpNode> &nodes,
+                                     int root) {
+    // nodes still reachable from root after folding
+    std::vector<bool> used(nodes.size());
+    used[root] = true;
+    for (int i = root; i >= 0; i--) {
+        if (!used[i]) continue;
+        if (nodes[i].left >= 0) used[nodes[i].left] = true;
+        if (nodes[i].right >= 0) used[nodes[i].right] = true;
+    }
 
+    // literal and function are keyed by what they are, not where they are
+    std::map<std::array<int64_t, 4>, int64_t> literalIds;
+    std::map<std::string, int64_t>            exactIds;
+    std::map<std::array<int64_t, 4>, int>     unique;
+    std::vector<int>                          shared(nodes.size(), -1);
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (!used[i]) continue;
+        auto &node = nodes[i];
+        if (node.left >= 0) node.left = shared[node.left];
+        if (node.right >= 0) node.right = shared[node.right];
+
+        int64_t arg = node.arg;
+        if (node.code == OpCode::PushValue && program.exact) {
+            // exact literals are keyed by their text
+            const auto &value = program.exactLiterals[node.arg];
+            auto        text  = value.GetValueStr() + (value.IsExact() ? "" : "~");
+            arg               = exactIds.emplace(text, exactIds.size()).first->second;
+        } else if (node.code == OpCode::PushValue) {
+            const auto &value = program.literals[node.arg];
+            double      dec   = value.GetValueDouble();
+            int64_t     bits{};
+            std::memcpy(&bits, &dec, sizeof(bits));
+            std::array<int64_t, 4> literalKey{ value.IsDecimal(), value.GetFracValue().up,
+                                               value.GetFracValue().down, bits };
+            arg = literalIds.emplace(literalKey, literalIds.size()).first->second;
+        } else if (node.code == OpCode::Call || node.code == OpCode::CallSqrt) {
+            arg = static_cast<int64_t>(reinterpret_cast<uintptr_t>(program.functions[node.arg].func));
+        }
 
-        // Variable to prepare for skipping items inside the for loop
-        // When this method is recursively called to calculate in-bracket contents
-        // this variable is modified
-        int iIncrement = 0;
+        std::array<int64_t, 4> key{ static_cast<int64_t>(node.code), arg, node.left, node.right };
+        auto found = unique.emplace(key, i);
+        shared[i]  = found.first->second;
+        // leaf is pushed again where used, only count computed node
+        if (!found.second && node.left >= 0) program.stats.dedupedNodes++;
+    }
+    return shared[root];
+}
 
-        // Push numbers to stack
-        if (blocks[i].type == Num) {
-            values.push(Value(blockStr));
+// Emit tree from root into postfix program, without recursion
+// so deep nested expression is fine, only used literals and functions are kept.
+// Node used more than once is stored to a temp at first time and loaded later
+void ExpSolver::EmitProgram(CompiledExpression &program, const std::vector<ExpNode> &nodes,
+                            int root) {
+    auto &literals      = buffers.literals;
+    auto &exactLiterals = buffers.exactLiterals;
+    auto &functions     = buffers.functions;
+    literals.clear();
+    exactLiterals.clear();
+    functions.clear();
+
+    // references of every node reachable from root
+    auto &refs = buffers.refs;
+    refs.assign(nodes.size(), 0);
+    refs[root] = 1;
+    for (int i = root; i >= 0; i--) {
+        if (!refs[i]) continue;
+        if (nodes[i].left >= 0) refs[nodes[i].left]++;
+        if (nodes[i].right >= 0) refs[nodes[i].right]++;
+    }
+    auto &temps = buffers.temps;
+    temps.assign(nodes.size(), -1);
+
+    auto &pending = buffers.pending;
+    pending.assign(1, std::make_pair(root, false));
+    size_t height = 0;
+    program.code.reserve(nodes.size());
+    while (!pending.empty()) {
+        int  index   = pending.back().first;
+        bool visited = pending.back().second;
+        pending.pop_back();
+        const auto &node = nodes[index];
+        if (!visited) {
+            if (temps[index] >= 0) {
+                program.code.emplace_back(OpCode::Load, temps[index]);
+                program.stackDepth = std::max(program.stackDepth, ++height);
+                continue;
+            }
+            // right operand is emitted first, so left one is on top, like the
+            // order nodes are made in by the right to left scan
+            pending.emplace_back(index, true);
+            if (node.left >= 0) pending.emplace_back(node.left, false);
+            if (node.right >= 0) pending.emplace_back(node.right, false);
+            continue;
         }
 
-        // Throw error if function names occur without brackets
-        else if (blocks[i].type == Func) {
-            error_messages << "Syntax Error: Need brackets after function name! " << std::endl;
-            return {};
+        int arg = node.arg;
+        if (node.code == OpCode::PushValue) {
+            literals.push_back(program.literals[arg]);
+            if (program.exact) exactLiterals.push_back(program.exactLiterals[arg]);
+            arg = literals.size() - 1;
+        } else if (node.code == OpCode::Call || node.code == OpCode::CallSqrt) {
+            functions.push_back(program.functions[arg]);
+            arg = functions.size() - 1;
         }
+        program.code.emplace_back(node.code, arg);
 
-        // Replace constants with Value
-        else if (blocks[i].type == Constant) {
-            for (auto &constant : constants) {
-                if (blockStr == constant.name) {
-                    values.push(constant.value);
-                    break;
-                }
-            }
+        if (node.left < 0) {
+            program.stackDepth = std::max(program.stackDepth, ++height);
+        } else if (node.right >= 0) {
+            height--;
+        }
 
+        // leaf is as cheap as load, only share computed node
+        if (refs[index] > 1 && node.left >= 0) {
+            temps[index] = program.tempCount++;
+            program.code.emplace_back(OpCode::Store, temps[index]);
         }
+    }
+    // swap keeps capacity of both sides for the next compile
+    program.literals.swap(literals);
+    program.exactLiterals.swap(exactLiterals);
+    program.functions.swap(functions);
+}
 
-        // Replace values with Value
-        else if (blocks[i].type == Var) {
-            for (auto &variable : variables) {
-                if (blockStr.compare(variable.name) == 0) {
-                    values.emplace(variable.value);
-                    break;
-                }
-            }
+// Nodes are made by the right to left scan in postfix order with left operand on top,
+// so a tree without shared or folded node is written as it is
+void ExpSolver::EmitInOrder(CompiledExpression &program, const std::vector<ExpNode> &nodes) {
+    size_t height = 0;
+    program.code.reserve(nodes.size());
+    for (const auto &node : nodes) {
+        program.code.emplace_back(node.code, node.arg);
+        if (node.left < 0) {
+            program.stackDepth = std::max(program.stackDepth, ++height);
+        } else if (node.right >= 0) {
+            height--;
+        }
+    }
+}
 
+// Build expression tree of block range [startBlock,endBlock) into nodes,
+// blocks are scanned right to left and operators are reduced by priority.
+// A bracket pair opens a range on ranges instead of a nested call, so depth
+// of brackets costs heap, not native stack
+int ExpSolver::CompileRange(CompiledExpression &program, std::vector<ExpNode> &nodes,
+                            int startBlock, int endBlock) {
+    // stacks of node ids and operators, shared by all ranges
+    auto &values = buffers.values;
+    auto &ops    = buffers.ops;
+    auto &ranges = buffers.ranges;
+    values.clear();
+    ops.clear();
+    ranges.clear();
+    ranges.push_back({ startBlock, 0, 0 });
+
+    // Pop one operator of innermost range and make node of it
+    auto reduce = [&]() {
+        const auto *op = ops.back();
+        ops.pop_back();
+        if (op->code == OpCode::Nil) {
+            errors.Add(ErrorCode::InvalidOperator, op->start, op->end - op->start);
+            return false;
+        }
+        if (values.size() - ranges.back().values < (op->unary ? 1u : 2u)) {
+            errors.Add(ErrorCode::InvalidExpression);
+            return false;
         }
+        int left = values.back();
+        values.pop_back();
+        if (op->unary) {
+            nodes.emplace_back(op->code, 0, left);
+        } else {
+            int right = values.back();
+            values.pop_back();
+            nodes.emplace_back(op->code, 0, left, right);
+        }
+        values.push_back(nodes.size() - 1);
+        return true;
+    };
+
+    // Add leaf node pushing a literal value, exact program pushes to exactLiterals before
+    auto pushLiteral = [&](const Value &value) {
+        program.literals.push_back(value);
+        nodes.emplace_back(OpCode::PushValue, program.literals.size() - 1);
+        values.push_back(nodes.size() - 1);
+    };
+
+    int i = endBlock - 1;
+    while (true) {
+        if (i < ranges.back().start) {
+            // innermost range is done, reduce what is left of it
+            auto range = ranges.back();
+            while (ops.size() > range.ops && values.size() > range.values) {
+                if (!reduce()) return -1;
+            }
+            // remain other value or ops, invalid
+            if (values.size() != range.values + 1 || ops.size() != range.ops) {
+                errors.Add(ErrorCode::InvalidExpression);
+                return -1;
+            }
+            ranges.pop_back();
+            if (ranges.empty()) return values.back();
 
-        // Recursively solve expression inside brackets
-        // and modify iIncrement to skip in-bracket loop items
-        else if (blocks[i].type == BracR) {
-            // Corresponding Block ID
-            int corBlock = FindIndexOfBracketEnding(i);
+            // value of brackets stays on values for enclosing range, or is argument of function
+            int corBlock = range.start - 1;
+            i            = corBlock - 1;
             if (corBlock != 0 && blocks[corBlock - 1].type == Func) {
-                // Find the function and calculate the result of the function.
-                double (*funcToUse)(double) = nullptr;
+                const auto &nameBlock = blocks[corBlock - 1];
 #ifdef EXP_HAS_STRING_VIEW
-                auto funcName = std::string_view{ exp }.substr(blocks[corBlock - 1].start,
-                                                               blocks[corBlock - 1].end
-                                                                   - blocks[corBlock - 1].start);
+                auto funcName = std::string_view{ expression }.substr(
+                    nameBlock.start, nameBlock.end - nameBlock.start);
 #else
-                string funcName = exp.substr(blocks[corBlock - 1].start,
-                                             blocks[corBlock - 1].end - blocks[corBlock - 1].start);
+                string funcName = expression.substr(nameBlock.start, nameBlock.end - nameBlock.start);
 #endif
-
-                for (auto &function : functions) {
-                    if (funcName.compare(function.name) == 0) {
-                        funcToUse = function.func;
-                        break;
-                    }
+                auto funcIndex = nameBlock.symbol;
+                if (funcIndex < 0) {
+                    errors.Add(ErrorCode::UnknownFunction, blocks[corBlock - 1].start,
+                               funcName.size());
+                    return -1;
                 }
-                Value valueInFunc = CalculateExp(exp, corBlock + 1, i);
-                if (!valueInFunc.IsCalculable()) {
-                    error_messages << valueInFunc.GetErrorMessage() << std::endl;
-                    return {};
-                } else if (valueInFunc.GetValueDouble() < 0 && funcName.compare("sqrt") == 0) {
-                    error_messages << "Arithmetic error: Cannot square root a negative number! "
-                                   << std::endl;
-                    return {};
-                }
-                if (funcToUse) {
-                    double funcResult = (*funcToUse)(valueInFunc.GetValueDouble());
-
-                    // Convert to Value and push to stack.
-                    values.push(Value(funcResult));
-                } else {
-                    error_messages << "Internal bug, function '" << funcName << "' not exists"
-                                   << std::endl;
-                    return {};
-                }
-                iIncrement -= i - corBlock + 1;
-            } else {
-                // only recursive brace
-                Value valueToPush = CalculateExp(exp, corBlock + 1, i);
-                if (!valueToPush.IsCalculable()) { return {}; }
-                values.push(valueToPush);
-                iIncrement -= i - corBlock;
-            }
-        }
-
-        // Push symbols into stack and calculate
-        // from highest calculation priority down
-        else if (blocks[i].type == Sym) {
-            auto priority = blocks[i].priority;
-            while (!ops.empty()) {
-                // process all priority num less(which mean priority higher) op
-                if (ops.top().priority < priority) {
-                    auto op = ops.top();
-                    ops.pop();
-#ifdef EXP_HAS_STRING_VIEW
-                    auto currentBlock = std::string_view{ exp }.substr(op.start, op.end - op.start);
-#else
-                    auto currentBlock = exp.substr(op.start, op.end - op.start);
-#endif
-
-                    // need pop 2 value
-                    if (currentBlock != "~") {
-                        if (values.empty()) {
-                            error_messages << "Invalid expression! ";
-                            return {};
-                        }
-                        Value v1 = values.top();
-                        values.pop();
-                        if (values.empty()) {
-                            error_messages << "Invalid expression! ";
-                            return {};
-                        }
-                        Value v2 = values.top();
-#if EXP_SOLVER_DEBUG
-                        std::cout << v1 << currentBlock << v2 << std::endl;
-#endif // EXP_SOLVER_DEBUG
-                        values.pop();
-                        values.push(v1.operate(currentBlock, v2));
-                    } else {
-                        if (values.empty()) {
-                            error_messages << "Invalid expression! ";
-                            return {};
-                        }
-                        // Negate op, pop one value
-                        Value v1 = values.top();
-                        values.pop();
-                        values.push(~v1);
-                    }
-                } else
-                    break;
+                program.functions.push_back(functions[funcIndex]);
+                nodes.emplace_back(funcName == "sqrt" ? OpCode::CallSqrt : OpCode::Call,
+                                   program.functions.size() - 1, values.back());
+                values.back() = nodes.size() - 1;
+                i             = corBlock - 2;
             }
-
-            ops.push(blocks[i]);
-        } else {
-            error_messages << "Encountered unknown character at " << blockStr << "!" << std::endl;
-            return {};
+            continue;
         }
 
-        i += iIncrement;
-    }
-
-    // Final calculation not containing any bracket
-#if EXP_SOLVER_DEBUG
-    std::cout << "remained" << std::endl;
-#endif // EXP_SOLVER_DEBUG
-    while (!ops.empty()) {
-        // values empty, no need to cal
-        if (values.empty()) break;
-
-        auto op = ops.top();
-        ops.pop();
-        // Record the content of the current block
-
 #ifdef EXP_HAS_STRING_VIEW
-        auto currentBlock = std::string_view{ exp }.substr(op.start, op.end - op.start);
+        std::string_view blockStr =
+            std::string_view{ expression }.substr(blocks[i].start, blocks[i].end - blocks[i].start);
 #else
-        string currentBlock = exp.substr(op.start, op.end - op.start);
+        string blockStr = expression.substr(blocks[i].start, blocks[i].end - blocks[i].start);
 #endif
 
-        if (currentBlock != "~") {
-            if (values.empty()) {
-                error_messages << "Invalid expression! ";
-                return {};
-            }
-            Value v1 = values.top();
-            values.pop();
-            if (!v1.IsCalculable()) {
-                error_messages << v1.GetErrorMessage() << "\n";
-                error_messages << "Invalid expression! ";
-                return {};
+        if (blocks[i].type == Num && program.exact) {
+            auto value = BigRational::Parse(blockStr);
+            if (!value.IsCalculable()) {
+                errors.Add(ErrorCode::ValueFailure, blocks[i].start, blocks[i].end - blocks[i].start,
+                           value.GetError());
+                return -1;
             }
-            if (values.empty()) {
-                error_messages << "Invalid expression! ";
-                return {};
+            program.exactLiterals.push_back(value);
+            pushLiteral(value.ToValue());
+        } else if (blocks[i].type == Num) {
+            Value value(blockStr);
+            if (!value.IsCalculable()) {
+                errors.Add(ErrorCode::ValueFailure, blocks[i].start, blocks[i].end - blocks[i].start,
+                           value.GetError());
+                return -1;
             }
-            Value v2 = values.top();
-            values.pop();
-            if (!v2.IsCalculable()) {
-                error_messages << v2.GetErrorMessage() << "\n";
-                error_messages << "Invalid expression! ";
-                return {};
+            pushLiteral(value);
+        } else if (blocks[i].type == Func) {
+            errors.Add(ErrorCode::NeedBrackets, blocks[i].start, blocks[i].end - blocks[i].start);
+            return -1;
+        } else if (blocks[i].type == Constant) {
+            const auto &value = constants[blocks[i].symbol].value;
+            if (program.exact) program.exactLiterals.push_back(BigRational(value));
+            pushLiteral(value);
+        } else if (blocks[i].type == Var) {
+            // refer variable by its slot
+            nodes.emplace_back(OpCode::PushVar, blocks[i].symbol);
+            values.push_back(nodes.size() - 1);
+        } else if (blocks[i].type == BracR) {
+            // blocks inside brackets are scanned next, as a range of their own
+            ranges.push_back({ blocks[i].match + 1, values.size(), ops.size() });
+        } else if (blocks[i].type == Sym) {
+            while (ops.size() > ranges.back().ops
+                   && (ops.back()->unary || ops.back()->priority < blocks[i].priority)) {
+                if (!reduce()) return -1;
             }
-
-#if EXP_SOLVER_DEBUG
-            std::cout << v1 << currentBlock << v2 << std::endl;
-#endif // EXP_SOLVER_DEBUG
-
-            values.push(v1.operate(currentBlock, v2));
+            ops.push_back(&blocks[i]);
         } else {
-            if (values.empty()) {
-                error_messages << "Invalid expression! ";
-                return {};
-            }
-            Value v1 = values.top();
-            values.pop();
-            values.push(~v1);
+            errors.Add(ErrorCode::UnknownCharacter, blocks[i].start, blockStr.size());
+            return -1;
         }
+        i--;
     }
-    // remain other value or ops, invalid
-    if (values.size() != 1 || !ops.empty()) {
-        error_messages << "Invalid expression! " << std::endl;
-        return {};
-    }
-    return values.top();
-}
-
-// Given the block id of ')', find the block id of corresponding '('
-int ExpSolver::FindIndexOfBracketEnding(int blockId) {
-    int levelToFind = blocks[blockId].level - 1, currentBlockId = blockId;
-    while (blocks[currentBlockId].level != levelToFind) {
-        if (currentBlockId == 0) return currentBlockId;
-        currentBlockId--;
-    }
-    return currentBlockId + 1;
 }
 } // namespace exp_solver
\ No newline at end of file
@@ -16,56 +16,235 @@ and solves them.
 #include <vector>
 #include <stack>
 #include <sstream>
+#include <memory>
 #include "value.h"
+#include "compiled_exp.h"
+#include "batch_eval.h"
+#include "symbol_table.h"
+#include "exp_cache.h"
+#include "eval_context.h"
+#include "typed_eval.h"
+#include "jit.h"
+#include "aot_library.h"
+#include "registry.h"
+#include "thread_pool.h"
+#include "background_compiler.h"
+#include "exp_error.h"
 
 namespace exp_solver
 {
-struct Variable {
-    std::string name;
-    Value       value;
-    Variable(std::string nm, Value val) : name(nm), value(val) {}
-};
-
-struct Function {
-    std::string name;
-    double (*func)(double);
-    Function(std::string nm, double (*f)(double)) : name(nm), func(f) {}
-};
-
 enum BlockType { Num, Sym, Func, Constant, Var, BracL, BracR, Nil };
 
 struct Block {
     int       start, end, level, priority;
     BlockType type;
-    Block() : start(0), end(0), level(0), priority(INT32_MAX), type(Nil) {}
+    // prefix operator '~' or negative sign '-'
+    bool unary;
+    // block id of the paired bracket, -1 if not a bracket
+    int match;
+    // index of function, constant or variable in its table, -1 if not a name
+    int symbol;
+    // operator of symbol, resolved while lexing, OpCode::Nil if not an operator
+    OpCode code;
+    Block() :
+        start(0), end(0), level(0), priority(INT32_MAX), type(Nil), unary(false), match(-1),
+        symbol(-1), code(OpCode::Nil) {}
     Block(int s, int e, int l, BlockType tp) :
-        start(s), end(e), level(l), priority(INT32_MAX), type(tp) {}
+        start(s), end(e), level(l), priority(INT32_MAX), type(tp), unary(false), match(-1),
+        symbol(-1), code(OpCode::Nil) {}
 };
 
 class ExpSolver {
 public:
-    // Constructor to initialize the ExpSolver object
-    ExpSolver();
+    /**
+     * @brief Constructor to initialize the ExpSolver object
+     * @param mode number type of calculation, NumericMode::Double skips fraction
+     *             bookkeeping
+     */
+    explicit ExpSolver(NumericMode mode = NumericMode::Rational);
+
+    NumericMode GetNumericMode() const { return mode; }
+
+    /**
+     * @brief choose form of programs compiled after, Backend::Auto gives programs of
+     *        at least register_threshold instructions a register form
+     * @note a program run once by SolveExp is not given a register form by Backend::Auto
+     */
+    void SetBackend(Backend backend) { this->backend = backend; }
+
+    Backend GetBackend() const { return backend; }
+
+    // instructions of stack code from which Backend::Auto uses registers
+    static constexpr size_t register_threshold = 32;
 
     // set expression
     void SetExp(const std::string &exp);
 
     /**
      * @brief use old expression resolve again, must use solveExp first
-     * @note use getErrorMessages() get fail reason
+     * @note use getErrorMessages() get fail reason, expression is compiled on
+     *       the first call, later calls only run the program
      * @return result of output, empty for fail
      */
     Value ResolveExp();
     /**
-     * @brief calculate expression and output result
+     * @brief calculate expression and output result, expression is compiled to
+     *        bytecode and run once, the same expression again runs it only
      *
      * @param exp expression to be calculated
      * @return result of output
      */
     Value SolveExp(const std::string &exp);
 
+    /**
+     * @brief compile expression into a program that can be evaluated repeatedly
+     *        without parsing again, current expression is also set as SetExp
+     * @note use getErrorMessages() get fail reason, variables used must be set before
+     * @example
+     * ExpSolver exp;
+     * exp.UpdateVariable("x", 1);
+     * auto program = exp.Compile("x * 2");
+     * exp.UpdateVariable("x", 2);
+     * auto output = exp.Evaluate(program); // output will be 4
+     * @param exp expression to be compiled
+     * @return compiled program, invalid for fail
+     */
+    CompiledExpression Compile(const std::string &exp);
+
+    /**
+     * @brief evaluate program compiled by this solver with current variable values
+     * @note use getErrorMessages() get fail reason
+     * @return result of output, empty for fail
+     */
+    Value Evaluate(const CompiledExpression &program);
+
+    /**
+     * @brief same as Compile, but numbers of any size and digits are kept exactly,
+     *        the program can still run by Evaluate in Value precision
+     * @note constant subexpressions are not folded, as folding rounds them to Value
+     */
+    CompiledExpression CompileExact(const std::string &exp);
+
+    /**
+     * @brief evaluate program in big fractions that never overflow, values of
+     *        variables are taken exactly, functions and decimal values are
+     *        computed in double and make the result inexact
+     * @note use getErrorMessages() get fail reason
+     * @return result of output, not calculable for fail
+     */
+    BigRational EvaluateExact(const CompiledExpression &program);
+
+    /**
+     * @brief calculate expression exactly, like CompileExact then EvaluateExact
+     * @example
+     * ExpSolver exp;
+     * auto output = exp.SolveExact("123456789012345678901234567890.25 * 4");
+     * output.GetValueStr(); // "493827156049382715604938271561"
+     */
+    BigRational SolveExact(const std::string &exp);
+
+    /**
+     * @brief evaluate program compiled by this solver over rows of variable values
+     *        in double precision, rows fail to calculate get NaN
+     * @example
+     * ExpSolver exp;
+     * exp.UpdateVariable("x", 0);
+     * exp.UpdateVariable("y", 10);
+     * auto program = exp.Compile("x * y");
+     * std::vector<double> xs{ 1, 2, 3 }, output(3);
+     * std::vector<const double *> columns(exp.GetVariableHandle("x") + 1);
+     * columns[exp.GetVariableHandle("x")] = xs.data();
+     * exp.EvaluateBatch(program, columns, 3, output.data()); // output will be 10, 20, 30
+     * @param program compiled program
+     * @param columns columns[handle] is values of variable for every row,
+     *                nullptr or missing means use current value of variable
+     * @param rows    count of rows
+     * @param output  results of rows
+     * @return false if program is invalid
+     */
+    bool EvaluateBatch(const CompiledExpression &program, const std::vector<const double *> &columns,
+                       size_t rows, double *output);
+
+    /**
+     * @brief same as EvaluateBatch above, but rows are split into ranges of grain
+     *        evaluated on threads of pool, each range writes its own rows of output
+     * @example
+     * ThreadPool pool(8);
+     * exp.EvaluateBatch(program, columns, rows, output.data(), pool);
+     * @param pool  threads to run on
+     * @param grain rows of one range, smaller ranges balance better but cost more
+     * @return false if program is invalid
+     */
+    bool EvaluateBatch(const CompiledExpression &program, const std::vector<const double *> &columns,
+                       size_t rows, double *output, ThreadPool &pool,
+                       size_t grain = default_batch_grain);
+
+    // rows of one parallel batch range
+    static constexpr size_t default_batch_grain = 16 * BatchEvaluator::chunk_size;
+
+    /**
+     * @brief run SolveExp and ResolveExp in tiers, an expression is first compiled
+     *        without optimizing, which is cheap for the long tail of rarely run ones,
+     *        once run threshold times it is compiled with folding, sharing and the
+     *        register backend on compiler, and the next run swaps that program in
+     * @note with a cache set, programs and their counts are shared by solvers through
+     *       it, and the optimized program replaces the cheap one in cache
+     * @example
+     * auto compiler = std::make_shared<BackgroundCompiler>();
+     * ExpSolver exp;
+     * exp.SetTiering(compiler, 100);
+     * exp.SolveExp("1 + 2"); // Tier::Interpreted
+     * // ... 100 runs later, once compiler is done
+     * exp.SolveExp("1 + 2"); // Tier::Optimized
+     * @param compiler thread compiling hot programs, may be shared, nullptr to compile
+     *                 as before
+     * @param threshold runs of an expression before it is optimized
+     */
+    void SetTiering(std::shared_ptr<BackgroundCompiler> compiler,
+                    uint32_t threshold = default_promotion_threshold);
+
+    // runs of an expression before tiered SolveExp optimizes it
+    static constexpr uint32_t default_promotion_threshold = 64;
+
+    // Tier of program SolveExp and ResolveExp run for current expression
+    Tier GetTier() const;
+
+    /**
+     * @brief share a cache of compiled programs, then SolveExp compiles each distinct
+     *        expression once and evaluates the cached program after
+     * @note the cache may be shared by solvers on many threads, nullptr to detach
+     * @example
+     * auto cache = std::make_shared<ExpressionCache>(1024);
+     * ExpSolver exp;
+     * exp.SetCache(cache);
+     * exp.SolveExp("1 + 2"); // compiled and cached
+     * exp.SolveExp("1 + 2"); // cache hit
+     */
+    void SetCache(std::shared_ptr<ExpressionCache> cache);
+
+    /**
+     * @brief same as Compile, but reuse program from cache when one is set,
+     *        invalid program is never cached
+     * @return compiled program, never nullptr, invalid for fail
+     */
+    std::shared_ptr<const CompiledExpression> CompileCached(const std::string &exp);
+
+    /**
+     * @brief fingerprint of variable names and their slots, solvers with the same
+     *        variables added in the same order have the same version, so programs
+     *        compiled by one can be evaluated by the other
+     */
+    uint64_t GetSymbolVersion() const { return symbolVersion; }
+
+    // Text of errors of the latest call, rendered from the error codes
     std::string GetErrorMessages() const;
 
+    /**
+     * @brief errors of the latest call as codes, cheap to check without making text
+     * @note offset of a record is in the expression with spaces removed
+     */
+    const std::vector<ErrorRecord> &GetErrors() const { return errors.GetRecords(); }
+
     /**
      * @brief set or edit a constant variable with value
      * @note use getErrorMessages() get fail reason
@@ -81,41 +260,157 @@ public:
      */
     bool UpdateVariable(const std::string &name, const Value &value);
 
+    /**
+     * @brief get the slot of a variable, slot never changes for this solver
+     * @example
+     * ExpSolver exp;
+     * exp.UpdateVariable("test", 10);
+     * auto handle = exp.GetVariableHandle("test");
+     * auto program = exp.Compile("test + 10");
+     * exp.UpdateVariable(handle, 20);
+     * auto output = exp.Evaluate(program); // output will be 30
+     * @param name name of variable, must be set by UpdateVariable before
+     * @return handle of variable, -1 if variable not exists
+     */
+    VariableHandle GetVariableHandle(const std::string &name) const;
+
+    /**
+     * @brief edit variable by handle without searching its name
+     * @note use getErrorMessages() get fail reason
+     * @param handle handle from GetVariableHandle
+     * @param value  value of variable
+     * @return false if handle is invalid or value is not calculable
+     */
+    bool UpdateVariable(VariableHandle handle, const Value &value);
+
+    /**
+     * @brief copy current variable values into a context, so threads can evaluate
+     *        programs of this solver concurrently, each with its own context
+     * @example
+     * ExpSolver exp;
+     * exp.UpdateVariable("x", 1);
+     * auto program = exp.Compile("x * 2");
+     * // on every thread
+     * auto context = exp.CreateContext();
+     * context.SetVariable(exp.GetVariableHandle("x"), 3);
+     * auto output = context.Evaluate(program); // output will be 6
+     * @return context with a copy of variable values
+     */
+    EvalContext CreateContext() const;
+
 private:
     std::string        expression;
-    std::ostringstream error_messages;
+    // errors of the latest call, text is rendered by GetErrorMessages
+    ErrorList errors;
     // The partition of expression that the object is
     // currently working on
     std::vector<Block> blocks;
+    // Buffers reused by every solve, so solving again allocates nothing
+    std::vector<int> bracketStack;
+    struct CompileBuffers {
+        std::vector<ExpNode>              nodes;
+        std::vector<int>                  values, refs, temps;
+        std::vector<const Block *>        ops;
+        std::vector<std::pair<int, bool>> pending;
+        // bracket range being compiled, blocks from start to its ')', with the sizes of
+        // values and ops when it started, entries below them belong to enclosing ranges
+        struct Range {
+            int    start;
+            size_t values, ops;
+        };
+        std::vector<Range>                ranges;
+        std::vector<Value>                literals;
+        std::vector<BigRational>          exactLiterals;
+        std::vector<Function>             functions;
+    } buffers;
+    // program of the latest SolveExp without cache, compiled again in place
+    CompiledExpression solveProgram;
+
+    // Tables of variables, constants and functions
+    // that might be used in calculations,
+    // constants and functions are shared by all solvers
+    SymbolTable<Variable>        variables;
+    const SymbolTable<Variable> &constants;
+    const SymbolTable<Function> &functions;
+    // FNV-1a of variable names in slot order
+    uint64_t symbolVersion;
 
-    // Vector of variables, constants and functions
-    // that might be used in calculations
-    std::vector<Variable> variables;
-    std::vector<Variable> constants;
-    std::vector<Function> functions;
+    std::shared_ptr<ExpressionCache> cache;
+    // program of current expression when SolveExp used cache or tiers
+    std::shared_ptr<const CompiledExpression> cachedProgram;
 
-    // Add predefined constants and functions
-    void AddPredefined();
+    std::shared_ptr<BackgroundCompiler> compiler;
+    uint32_t                            promotionThreshold{ default_promotion_threshold };
+    // copy of variables the compiler thread compiles with, never changed once a job
+    // holds it, made again when variables are added
+    std::shared_ptr<ExpSolver> compilerSolver;
+
+    NumericMode mode;
+    Backend     backend{ Backend::Auto };
+
+    // reused by Evaluate
+    std::vector<Value>  evalStack, evalTemps;
+    std::vector<double> doubleStack, doubleTemps;
+    // reused by EvaluateExact
+    std::vector<BigRational> exactStack, exactTemps;
 
     void PreprocessExp();
 
+    // Compile or CompileExact
+    CompiledExpression CompileProgram(const std::string &exp, bool exact);
+
+    // Compile exp into program, reusing its capacity,
+    // a program to run only once is not optimized
+    void CompileInto(const std::string &exp, bool exact, bool optimize,
+                     CompiledExpression &program);
+
+    // Program of exp in Tier::Interpreted, or the one shared in cache
+    std::shared_ptr<const CompiledExpression> CompileTiered(const std::string &exp);
+
+    // Evaluate cachedProgram, swapping in its optimized successor, or
+    // promoting it once it is run threshold times
+    Value EvaluateTiered();
+
+    // Compile program optimized on compiler, then publish it as successor
+    void Promote(const std::shared_ptr<const CompiledExpression> &program);
+
+    // Key of programs in cache, symbol version salted by mode,
+    // so solvers of both modes can share a cache
+    uint64_t ProgramVersion() const;
+
     // This is similar to lexical analysis in a compiler
     // Partition an expression into blocks of different types
     bool GroupExp(const std::string &exp);
 
-    // Analyze whether a std::string Block is of BlockType Func, Constant or Var
-    BlockType AnalyzeStrType(const std::string &str);
+    // Analyze whether a std::string Block at offset is of BlockType Func, Constant or Var
+    // and set symbol to its index in the table
+#ifdef EXP_HAS_STRING_VIEW
+    BlockType AnalyzeStrType(std::string_view str, int offset, int &symbol);
+#else
+    BlockType AnalyzeStrType(const std::string &str, int offset, int &symbol);
+#endif
 
     // Determine the type of one single character
     BlockType Char2Type(char c);
 
-    // Replace every "-" as negative sign by "0-"
-    void DealWithNegativeSign(std::string &exp);
+    // Check program can run on this solver and collect values of variables for batch
+    bool PrepareBatch(const CompiledExpression &program, std::vector<double> &scalars);
+
+    // Build expression tree of block range [startBlock,endBlock) into nodes without
+    // recursion, return index of root node, -1 for fail
+    int CompileRange(CompiledExpression &program, std::vector<ExpNode> &nodes, int startBlock,
+                     int endBlock);
+
+    // Replace nodes with only constant operands by their result
+    void FoldConstants(CompiledExpression &program, std::vector<ExpNode> &nodes);
+
+    // Share identical subtrees, return new root
+    int EliminateCommonSubexp(CompiledExpression &program, std::vector<ExpNode> &nodes, int root);
 
-    // Calculate expression in block range [startBlock,endBlock)
-    Value CalculateExp(const std::string &exp, int startBlock, int endBlock);
+    // Write tree from root to program in postfix order
+    void EmitProgram(CompiledExpression &program, const std::vector<ExpNode> &nodes, int root);
 
-    // Given the block id of ')', find the block id of corresponding '('
-    int FindIndexOfBracketEnding(int blockId);
+    // Write every node to program in the order they were made
+    void EmitInOrder(CompiledExpression &program, const std::vector<ExpNode> &nodes);
 };
 } // namespace exp_solver
\ No newline at end of file
@@ -0,0 +1,88 @@
+/*
+
+int_math.h
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Checked int64_t arithmetic, bit counting
+and binary GCD shared by Value and BigInt.
+
+*/
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+
+namespace exp_solver
+{
+// Checked int64_t arithmetic, true on overflow. INT64_MIN counts as overflow
+// too, so results can always be negated and passed to std::abs
+inline bool MulOverflow(int64_t a, int64_t b, int64_t &out) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_mul_overflow(a, b, &out) || out == INT64_MIN;
+#else
+    if (a != 0 && (b == INT64_MIN || std::abs(b) > INT64_MAX / std::abs(a))) return true;
+    out = a * b;
+    return out == INT64_MIN;
+#endif
+}
+
+inline bool AddOverflow(int64_t a, int64_t b, int64_t &out) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_add_overflow(a, b, &out) || out == INT64_MIN;
+#else
+    if ((b > 0 && a > INT64_MAX - b) || (b < 0 && a < INT64_MIN - b)) return true;
+    out = a + b;
+    return out == INT64_MIN;
+#endif
+}
+
+// |x| without overflow for INT64_MIN
+inline uint64_t UnsignedAbs(int64_t x) {
+    return x < 0 ? 0 - static_cast<uint64_t>(x) : static_cast<uint64_t>(x);
+}
+
+// Count of trailing zero bits of x, x must not be 0
+inline int CountTrailingZeros(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#else
+    int count = 0;
+    for (; (x & 1) == 0; x >>= 1) count++;
+    return count;
+#endif
+}
+
+// Count of leading zero bits of x, x must not be 0
+inline int CountLeadingZeros(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(x);
+#else
+    int count = 0;
+    for (; (x >> 63) == 0; x <<= 1) count++;
+    return count;
+#endif
+}
+
+// Stein's binary GCD, every run of zero bits is removed by one shift
+inline uint64_t BinaryGcd(uint64_t a, uint64_t b) {
+    // GCD(0, b) == b; GCD(a, 0) == a, GCD(0, 0) == 0
+    if (a == 0) return b;
+    if (b == 0) return a;
+
+    // greatest power of 2 that divides both a and b
+    auto k = CountTrailingZeros(a | b);
+    a >>= CountTrailingZeros(a);
+    // From here on, a is always odd
+    do {
+        b >>= CountTrailingZeros(b);
+        // Now a and b are both odd, keep a <= b, then b - a is even
+        if (a > b) std::swap(a, b);
+        b -= a;
+    } while (b != 0);
+
+    // restore common factors of 2
+    return a << k;
+}
+} // namespace exp_solver
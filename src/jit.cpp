@@ -0,0 +1,775 @@
+/*
+
+jit.cpp
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Implementation of JitFunction, an
+x86-64 code generator from the register form
+of a CompiledExpression, with SSE2 scalar code
+and SSE2 or AVX packed code for batches.
+
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+#include <map>
+#include <utility>
+
+#include "jit.h"
+#include "batch_eval.h"
+#include "numeric_policy.h"
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#    include <sys/mman.h>
+#    include <unistd.h>
+#    define EXP_JIT_X86_64 1
+#else
+#    define EXP_JIT_X86_64 0
+#endif // x86-64 with mmap
+
+namespace exp_solver
+{
+static constexpr double not_a_number = std::numeric_limits<double>::quiet_NaN();
+
+// native code writes status by these offsets
+static_assert(offsetof(JitStatus, code) == 4 && offsetof(JitStatus, error) == 5,
+              "layout of JitStatus is used by native code");
+
+#if EXP_JIT_X86_64
+namespace
+{
+// General registers by their number in encoding
+enum Gpr : int { rax = 0, rbx = 3, rsp = 4, r12 = 12, r14 = 14 };
+
+// Code for one value per run, two rows per step or four rows per step
+enum class Form { Scalar, Sse2, Avx };
+
+// xmm registers given to registers of program, xmm0 and xmm1 are scratch
+static constexpr int xmm_registers = 14;
+
+// Operand of SSE and AVX instructions, an xmm register, memory at [base + index + disp]
+// or a constant at disp of the constant pool, addressed relative to rip
+struct Operand {
+    enum Kind { Xmm, Memory, Pool } kind;
+    int     reg;
+    int     index;
+    int32_t disp;
+
+    static Operand Register(int xmm) { return { Xmm, xmm, -1, 0 }; }
+    static Operand At(int base, int32_t disp, int index = -1) {
+        return { Memory, base, index, disp };
+    }
+    bool IsRegister(int xmm) const { return kind == Xmm && reg == xmm; }
+};
+
+// Bytes of machine code and the constants it reads, pool follows code
+class Assembler {
+public:
+    void Byte(uint8_t byte) { code.push_back(byte); }
+    void Bytes(std::initializer_list<uint8_t> bytes) {
+        code.insert(code.end(), bytes.begin(), bytes.end());
+    }
+    void Dword(uint32_t value) {
+        for (int i = 0; i < 4; i++) Byte(static_cast<uint8_t>(value >> (8 * i)));
+    }
+    void Qword(uint64_t value) {
+        for (int i = 0; i < 8; i++) Byte(static_cast<uint8_t>(value >> (8 * i)));
+    }
+    size_t Position() const { return code.size(); }
+
+    // Constant of width bytes holding bits in every double, aligned to its width
+    Operand Constant(uint64_t bits, size_t width) {
+        auto key   = std::make_pair(bits, width);
+        auto found = constants.find(key);
+        if (found != constants.end()) return { Operand::Pool, 0, -1, found->second };
+        auto offset = (pool.size() + width - 1) / width * width;
+        pool.resize(offset + width);
+        for (size_t i = 0; i < width; i += 8) std::memcpy(&pool[offset + i], &bits, 8);
+        constants[key] = static_cast<int32_t>(offset);
+        return { Operand::Pool, 0, -1, static_cast<int32_t>(offset) };
+    }
+
+    // Legacy SSE instruction, prefix 0F opcode, reg is xmm register of ModRM
+    void Sse(uint8_t prefix, uint8_t opcode, int reg, const Operand &rm) {
+        if (prefix) Byte(prefix);
+        Rex(false, reg, rm);
+        Bytes({ 0x0F, opcode });
+        ModRm(reg, rm);
+    }
+
+    // Same with an imm8 after the operand, a rip relative operand is addressed from its end
+    void Sse(uint8_t prefix, uint8_t opcode, int reg, const Operand &rm, uint8_t imm) {
+        Sse(prefix, opcode, reg, rm);
+        if (rm.kind == Operand::Pool) fixups.back().second--;
+        Byte(imm);
+    }
+
+    // VEX encoded instruction 66 0F opcode, reg = op(src, rm), 256 bits wide
+    void Vex(uint8_t opcode, int reg, int src, const Operand &rm) {
+        int x = rm.kind == Operand::Memory && rm.index >= 0 ? rm.index >> 3 : 0;
+        int b = rm.kind == Operand::Pool ? 0 : rm.reg >> 3;
+        Byte(0xC4);
+        Byte(static_cast<uint8_t>((!(reg >> 3) << 7) | (!x << 6) | (!b << 5) | 0x01));
+        Byte(static_cast<uint8_t>(((~src & 15) << 3) | 0x04 | 0x01));
+        Byte(opcode);
+        ModRm(reg, rm);
+    }
+    void Vex(uint8_t opcode, int reg, int src, const Operand &rm, uint8_t imm) {
+        Vex(opcode, reg, src, rm);
+        if (rm.kind == Operand::Pool) fixups.back().second--;
+        Byte(imm);
+    }
+
+    // Instruction of general registers, opcode with reg and memory rm, 64 bit if wide
+    void General(bool wide, uint8_t opcode, int reg, const Operand &rm) {
+        Rex(wide, reg, rm);
+        Byte(opcode);
+        ModRm(reg, rm);
+    }
+
+    // Conditional jump 0F cc with rel32 to be bound, returns position of rel32
+    size_t Jump(uint8_t condition) {
+        Bytes({ 0x0F, condition });
+        Dword(0);
+        return code.size() - 4;
+    }
+    size_t Jump() {
+        Byte(0xE9);
+        Dword(0);
+        return code.size() - 4;
+    }
+    // Point rel32 at position to target
+    void Bind(size_t position, size_t target) {
+        auto rel = static_cast<int32_t>(target - (position + 4));
+        std::memcpy(&code[position], &rel, 4);
+    }
+
+    // Code then pool aligned to 32 bytes, with rip relative operands resolved
+    std::vector<uint8_t> Finish() {
+        auto poolStart = (code.size() + 31) / 32 * 32;
+        for (const auto &fixup : fixups) {
+            auto rel = static_cast<int32_t>(poolStart + fixup.second - (fixup.first + 4));
+            std::memcpy(&code[fixup.first], &rel, 4);
+        }
+        std::vector<uint8_t> bytes(code);
+        // int3 between code and pool
+        bytes.resize(poolStart, 0xCC);
+        bytes.insert(bytes.end(), pool.begin(), pool.end());
+        return bytes;
+    }
+
+private:
+    void Rex(bool wide, int reg, const Operand &rm) {
+        int rex = 0x40 | (wide << 3) | ((reg >> 3) << 2);
+        if (rm.kind == Operand::Xmm) rex |= rm.reg >> 3;
+        if (rm.kind == Operand::Memory) {
+            rex |= rm.reg >> 3;
+            if (rm.index >= 0) rex |= (rm.index >> 3) << 1;
+        }
+        if (rex != 0x40) Byte(static_cast<uint8_t>(rex));
+    }
+
+    // memory is always written with disp32, so rbp and r13 need no special case
+    void ModRm(int reg, const Operand &rm) {
+        reg &= 7;
+        switch (rm.kind) {
+            case Operand::Xmm: Byte(static_cast<uint8_t>(0xC0 | (reg << 3) | (rm.reg & 7))); break;
+            case Operand::Pool:
+                Byte(static_cast<uint8_t>((reg << 3) | 0x05));
+                fixups.emplace_back(code.size(), rm.disp);
+                Dword(0);
+                break;
+            case Operand::Memory:
+                if (rm.index < 0 && (rm.reg & 7) != rsp) {
+                    Byte(static_cast<uint8_t>(0x80 | (reg << 3) | (rm.reg & 7)));
+                } else {
+                    // SIB byte, index 100 is none
+                    Byte(static_cast<uint8_t>(0x84 | (reg << 3)));
+                    int index = rm.index < 0 ? rsp : rm.index & 7;
+                    Byte(static_cast<uint8_t>((index << 3) | (rm.reg & 7)));
+                }
+                Dword(static_cast<uint32_t>(rm.disp));
+                break;
+        }
+    }
+
+    std::vector<uint8_t>                           code, pool;
+    std::map<std::pair<uint64_t, size_t>, int32_t> constants;
+    // position of rel32 and offset in pool it refers to
+    std::vector<std::pair<size_t, int32_t>> fixups;
+};
+
+static uint64_t BitsOf(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, 8);
+    return bits;
+}
+
+// Operators of NumericPolicy<double> without an inlined form, error goes to status
+static double ApplyChecked(double a, double b, int32_t code, JitStatus *status) {
+    ValueError error  = ValueError::None;
+    auto       result = NumericPolicy<double>::Apply(static_cast<OpCode>(code), a, b, error);
+    if (error != ValueError::None) *status = { 1, ErrorCode::CalculationAborted, error };
+    return result;
+}
+
+static double InvertChecked(double a, JitStatus *status) {
+    ValueError error  = ValueError::None;
+    auto       result = NumericPolicy<double>::Invert(a, error);
+    if (error != ValueError::None) *status = { 1, ErrorCode::CalculationAborted, error };
+    return result;
+}
+
+// '**' of a row in batch, rows failing like Value get NaN
+static double PowRow(double a, double b) {
+    ValueError error = ValueError::None;
+    return double_ops::Pow(a, b, error);
+}
+
+/**
+ * @brief writer of machine code for the register form of a program, registers of
+ *        program live in xmm2 to xmm15 and in spill slots of the native stack frame
+ */
+class CodeGenerator {
+public:
+    CodeGenerator(const std::vector<double> &literals, const std::vector<Function> &functions,
+                  const std::vector<RegisterInstruction> &code, const std::vector<int32_t> &loads,
+                  int32_t resultSlot, Form form) :
+        literals(literals), functions(functions), instructions(code), loads(loads),
+        resultSlot(resultSlot), form(form),
+        width(form == Form::Scalar ? 8 : form == Form::Sse2 ? 16 : 32),
+        literalCount(static_cast<int32_t>(literals.size())),
+        registerBase(literalCount + static_cast<int32_t>(loads.size())) {}
+
+    // Whether form can run every instruction
+    bool Supported() const {
+        if (form == Form::Scalar) return true;
+        for (const auto &instruction : instructions) {
+            switch (instruction.code) {
+                case OpCode::FloorDiv:
+                case OpCode::Mod:
+                case OpCode::Shl:
+                case OpCode::Shr:
+                case OpCode::And:
+                case OpCode::Xor:
+                case OpCode::Or:
+                case OpCode::Invert: return false;
+                default: break;
+            }
+        }
+        return true;
+    }
+
+    std::vector<uint8_t> Generate() {
+        FindLastReads();
+        int32_t registerCount = 0;
+        for (const auto &instruction : instructions) {
+            registerCount = std::max(registerCount, instruction.dst - registerBase + 1);
+        }
+        // frame is spill slots, saved xmm registers around calls and arguments of lanes
+        spillOffset     = 0;
+        saveOffset      = std::max(0, registerCount - xmm_registers) * width;
+        laneOffset      = saveOffset + xmm_registers * width;
+        auto frameBytes = (laneOffset + 2 * width + 15) / 16 * 16;
+
+        // prologue, entry rsp is 8 off 16 bytes, so five pushes align it
+        a.Bytes({ 0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57 });
+        a.Bytes({ 0x48, 0x81, 0xEC });
+        a.Dword(static_cast<uint32_t>(frameBytes));
+        // mov rbx, rdi; mov r12, rsi
+        a.Bytes({ 0x48, 0x89, 0xFB, 0x49, 0x89, 0xF4 });
+        size_t loop = 0;
+        if (form != Form::Scalar) {
+            // mov r13, rdx; shl r13, 3; xor r14d, r14d
+            a.Bytes({ 0x49, 0x89, 0xD5, 0x49, 0xC1, 0xE5, 0x03, 0x45, 0x31, 0xF6 });
+            loop = a.Position();
+        }
+
+        owners.assign(registerCount, -1);
+        for (size_t i = 0; i < instructions.size(); i++) {
+            Emit(i);
+            owners[instructions[i].dst - registerBase] = static_cast<int32_t>(i);
+        }
+
+        if (form == Form::Scalar) {
+            Move(0, Slot(resultSlot));
+        } else {
+            auto result = Slot(resultSlot);
+            if (result.kind != Operand::Xmm) {
+                Move(0, result);
+                result = Operand::Register(0);
+            }
+            Store(Operand::At(r12, 0, r14), result.reg);
+            // add r14, width; cmp r14, r13; jb loop
+            a.Bytes({ 0x49, 0x83, 0xC6, static_cast<uint8_t>(width), 0x4D, 0x39, 0xEE });
+            a.Bind(a.Jump(0x82), loop);
+        }
+
+        // epilogue
+        auto epilogue = a.Position();
+        a.Bytes({ 0x48, 0x81, 0xC4 });
+        a.Dword(static_cast<uint32_t>(frameBytes));
+        if (form == Form::Avx) a.Bytes({ 0xC5, 0xF8, 0x77 });
+        a.Bytes({ 0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5B, 0xC3 });
+        for (auto position : toEpilogue) a.Bind(position, epilogue);
+
+        // failures found by native code write status and leave
+        auto fail = [&](const std::vector<size_t> &jumps, ErrorCode code, ValueError error) {
+            if (jumps.empty()) return;
+            for (auto position : jumps) a.Bind(position, a.Position());
+            // mov dword [r12], 1; mov byte [r12+4], code; mov byte [r12+5], error
+            a.Bytes({ 0x41, 0xC7, 0x04, 0x24, 0x01, 0x00, 0x00, 0x00 });
+            a.Bytes({ 0x41, 0xC6, 0x44, 0x24, 0x04, static_cast<uint8_t>(code) });
+            a.Bytes({ 0x41, 0xC6, 0x44, 0x24, 0x05, static_cast<uint8_t>(error) });
+            a.Bind(a.Jump(), epilogue);
+        };
+        fail(toDenominatorZero, ErrorCode::CalculationAborted, ValueError::DenominatorZero);
+        fail(toNegativeSqrt, ErrorCode::NegativeSqrt, ValueError::None);
+        return a.Finish();
+    }
+
+private:
+    bool IsBinary(OpCode code) const {
+        return code != OpCode::Call && code != OpCode::CallSqrt && code != OpCode::Neg &&
+               code != OpCode::Invert;
+    }
+
+    // lastReads[i] is the last instruction reading the value instruction i makes
+    void FindLastReads() {
+        lastReads.assign(instructions.size(), 0);
+        std::vector<int32_t> owner(instructions.size() + registerBase, -1);
+        auto                 read = [&](int32_t slot, size_t i) {
+            if (slot >= registerBase) lastReads[owner[slot]] = i;
+        };
+        for (size_t i = 0; i < instructions.size(); i++) {
+            const auto &instruction = instructions[i];
+            read(instruction.left, i);
+            if (IsBinary(instruction.code)) read(instruction.right, i);
+            owner[instruction.dst] = static_cast<int32_t>(i);
+        }
+        if (resultSlot >= registerBase) lastReads[owner[resultSlot]] = instructions.size();
+    }
+
+    // Operand of frame slot, a variable of batch code loads its row pointer to rax first
+    Operand Slot(int32_t slot) {
+        if (slot < literalCount) {
+            return a.Constant(BitsOf(literals[slot]), width);
+        }
+        if (slot < registerBase) {
+            auto input = slot - literalCount;
+            if (form == Form::Scalar) return Operand::At(rbx, loads[input] * 8);
+            // mov rax, [rbx + 8 * input]
+            a.General(true, 0x8B, rax, Operand::At(rbx, input * 8));
+            return Operand::At(rax, 0, r14);
+        }
+        auto reg = slot - registerBase;
+        if (reg < xmm_registers) return Operand::Register(2 + reg);
+        return Operand::At(rsp, spillOffset + (reg - xmm_registers) * width);
+    }
+
+    bool InXmm(int32_t slot, int xmm) const {
+        return slot >= registerBase && slot - registerBase < xmm_registers &&
+               2 + slot - registerBase == xmm;
+    }
+
+    // xmm = src
+    void Move(int xmm, const Operand &src) {
+        if (src.IsRegister(xmm)) return;
+        bool reg = src.kind == Operand::Xmm;
+        switch (form) {
+            case Form::Scalar: a.Sse(reg ? 0x66 : 0xF2, reg ? 0x28 : 0x10, xmm, src); break;
+            case Form::Sse2: a.Sse(0x66, reg ? 0x28 : 0x10, xmm, src); break;
+            case Form::Avx: a.Vex(reg ? 0x28 : 0x10, xmm, 0, src); break;
+        }
+    }
+
+    // memory dst = xmm
+    void Store(const Operand &dst, int xmm) {
+        switch (form) {
+            case Form::Scalar: a.Sse(0xF2, 0x11, xmm, dst); break;
+            case Form::Sse2: a.Sse(0x66, 0x11, xmm, dst); break;
+            case Form::Avx: a.Vex(0x11, xmm, 0, dst); break;
+        }
+    }
+
+    void Put(const Operand &dst, int xmm) {
+        if (dst.kind == Operand::Xmm) {
+            Move(dst.reg, Operand::Register(xmm));
+        } else {
+            Store(dst, xmm);
+        }
+    }
+
+    // xmm register a result of dst is computed in
+    int Target(const Operand &dst) const { return dst.kind == Operand::Xmm ? dst.reg : 0; }
+
+    // Operand legacy SSE can read, packed memory other than pool may be unaligned
+    Operand Readable(const Operand &src, int scratch) {
+        if (form != Form::Sse2 || src.kind != Operand::Memory) return src;
+        Move(scratch, src);
+        return Operand::Register(scratch);
+    }
+
+    // dst = left op right for opcode of addsd or addpd family
+    void Arithmetic(uint8_t opcode, const RegisterInstruction &instruction) {
+        auto dst = Slot(instruction.dst);
+        if (form == Form::Avx) {
+            auto left = Slot(instruction.left);
+            if (left.kind != Operand::Xmm) {
+                Move(0, left);
+                left = Operand::Register(0);
+            }
+            auto target = Target(dst);
+            a.Vex(opcode, target, left.reg, Slot(instruction.right));
+            Put(dst, target);
+            return;
+        }
+        auto target = Target(dst);
+        // target holding right would be overwritten before right is read
+        if (!InXmm(instruction.left, target) && InXmm(instruction.right, target)) target = 0;
+        Move(target, Slot(instruction.left));
+        a.Sse(form == Form::Scalar ? 0xF2 : 0x66, opcode, target,
+              Readable(Slot(instruction.right), 1));
+        Put(dst, target);
+    }
+
+    // dst = src op mask for opcode of xorpd or andpd
+    void Mask(uint8_t opcode, uint64_t bits, const RegisterInstruction &instruction) {
+        auto dst    = Slot(instruction.dst);
+        auto target = Target(dst);
+        auto mask   = a.Constant(bits, std::max<size_t>(width, 16));
+        if (form == Form::Avx) {
+            auto src = Slot(instruction.left);
+            if (src.kind != Operand::Xmm) {
+                Move(0, src);
+                src = Operand::Register(0);
+            }
+            a.Vex(opcode, target, src.reg, mask);
+        } else {
+            Move(target, Slot(instruction.left));
+            a.Sse(0x66, opcode, target, mask);
+        }
+        Put(dst, target);
+    }
+
+    void Sqrt(const RegisterInstruction &instruction) {
+        auto dst    = Slot(instruction.dst);
+        auto target = Target(dst);
+        auto src    = Slot(instruction.left);
+        switch (form) {
+            case Form::Scalar: a.Sse(0xF2, 0x51, target, src); break;
+            case Form::Sse2: a.Sse(0x66, 0x51, target, Readable(src, 1)); break;
+            case Form::Avx: a.Vex(0x51, target, 0, src); break;
+        }
+        Put(dst, target);
+    }
+
+    // dst = left / right of packed rows, or of all ones, a NaN, where right is 0
+    void DivideRows(const RegisterInstruction &instruction) {
+        auto zero = a.Constant(0, width);
+        Move(1, Slot(instruction.right));
+        Move(0, Slot(instruction.left));
+        if (form == Form::Avx) {
+            // vdivpd ymm0, ymm0, ymm1; vcmpeqpd ymm1, ymm1, zero; vorpd ymm0, ymm0, ymm1
+            a.Vex(0x5E, 0, 0, Operand::Register(1));
+            a.Vex(0xC2, 1, 1, zero, 0);
+            a.Vex(0x56, 0, 0, Operand::Register(1));
+        } else {
+            // divpd xmm0, xmm1; cmpeqpd xmm1, zero; orpd xmm0, xmm1
+            a.Sse(0x66, 0x5E, 0, Operand::Register(1));
+            a.Sse(0x66, 0xC2, 1, zero, 0);
+            a.Sse(0x66, 0x56, 0, Operand::Register(1));
+        }
+        Put(Slot(instruction.dst), 0);
+    }
+
+    // Jump to failure if the scalar operand is 0 or below 0, NaN never jumps
+    void CheckZero(const Operand &value, std::vector<size_t> &jumps) {
+        // xorpd xmm1, xmm1; ucomisd xmm1, value; jp skip; je fail
+        a.Sse(0x66, 0x57, 1, Operand::Register(1));
+        a.Sse(0x66, 0x2E, 1, value);
+        a.Bytes({ 0x7A, 0x06 });
+        jumps.push_back(a.Jump(0x84));
+    }
+    void CheckNegative(const Operand &value, std::vector<size_t> &jumps) {
+        // xorpd xmm1, xmm1; ucomisd xmm1, value; ja fail
+        a.Sse(0x66, 0x57, 1, Operand::Register(1));
+        a.Sse(0x66, 0x2E, 1, value);
+        jumps.push_back(a.Jump(0x87));
+    }
+
+    // Registers in xmm holding values read after instruction i
+    std::vector<int> LiveAcross(size_t i) const {
+        std::vector<int> live;
+        for (int reg = 0; reg < std::min<int>(xmm_registers, owners.size()); reg++) {
+            if (owners[reg] >= 0 && lastReads[owners[reg]] > i) live.push_back(reg);
+        }
+        return live;
+    }
+    void Save(const std::vector<int> &live) {
+        for (auto reg : live) Store(Operand::At(rsp, saveOffset + reg * width), 2 + reg);
+    }
+    void Restore(const std::vector<int> &live) {
+        for (auto reg : live) Move(2 + reg, Operand::At(rsp, saveOffset + reg * width));
+    }
+
+    // call absolute address, registers of program are saved around it by caller
+    void Call(const void *function) {
+        // mov rax, imm64; call rax
+        a.Bytes({ 0x48, 0xB8 });
+        a.Qword(reinterpret_cast<uint64_t>(function));
+        a.Bytes({ 0xFF, 0xD0 });
+    }
+
+    // Scalar helper with status in rsi or rdi, leave if it failed
+    void CallChecked(const void *function) {
+        Call(function);
+        // cmp dword [r12], 0; jne epilogue
+        a.Bytes({ 0x41, 0x83, 0x3C, 0x24, 0x00 });
+        toEpilogue.push_back(a.Jump(0x85));
+    }
+
+    // dst = function(left) or function(left, right) of every row
+    void CallRows(const void *function, bool binary, const RegisterInstruction &instruction) {
+        auto live = LiveAcross(static_cast<size_t>(&instruction - instructions.data()));
+        Save(live);
+        Move(0, Slot(instruction.left));
+        Store(Operand::At(rsp, laneOffset), 0);
+        if (binary) {
+            Move(0, Slot(instruction.right));
+            Store(Operand::At(rsp, laneOffset + width), 0);
+        }
+        // functions are SSE code, no AVX state is live across them
+        if (form == Form::Avx) a.Bytes({ 0xC5, 0xF8, 0x77 });
+        for (int32_t lane = 0; lane < width; lane += 8) {
+            a.Sse(0xF2, 0x10, 0, Operand::At(rsp, laneOffset + lane));
+            if (binary) a.Sse(0xF2, 0x10, 1, Operand::At(rsp, laneOffset + width + lane));
+            Call(function);
+            a.Sse(0xF2, 0x11, 0, Operand::At(rsp, laneOffset + lane));
+        }
+        Restore(live);
+        auto dst    = Slot(instruction.dst);
+        auto target = Target(dst);
+        Move(target, Operand::At(rsp, laneOffset));
+        Put(dst, target);
+    }
+
+    void Emit(size_t i) {
+        const auto &instruction = instructions[i];
+        switch (instruction.code) {
+            case OpCode::Add: Arithmetic(0x58, instruction); return;
+            case OpCode::Sub: Arithmetic(0x5C, instruction); return;
+            case OpCode::Mul: Arithmetic(0x59, instruction); return;
+            case OpCode::Div:
+                // division by zero fails like Value, rows of batch get NaN like EvaluateBatch
+                if (form == Form::Scalar) {
+                    CheckZero(Slot(instruction.right), toDenominatorZero);
+                    Arithmetic(0x5E, instruction);
+                } else {
+                    DivideRows(instruction);
+                }
+                return;
+            case OpCode::Neg: Mask(0x57, BitsOf(-0.0), instruction); return;
+            case OpCode::CallSqrt:
+                // sqrt of negative row is NaN already
+                if (form == Form::Scalar) CheckNegative(Slot(instruction.left), toNegativeSqrt);
+                Sqrt(instruction);
+                return;
+            case OpCode::Call: {
+                const auto &function = functions[instruction.arg];
+                if (function.name == "abs") {
+                    Mask(0x54, ~BitsOf(-0.0), instruction);
+                } else if (form != Form::Scalar) {
+                    CallRows(reinterpret_cast<const void *>(function.func), false, instruction);
+                } else {
+                    auto live = LiveAcross(i);
+                    Save(live);
+                    Move(0, Slot(instruction.left));
+                    Call(reinterpret_cast<const void *>(function.func));
+                    Restore(live);
+                    Put(Slot(instruction.dst), 0);
+                }
+                return;
+            }
+            case OpCode::Pow:
+                if (form != Form::Scalar) {
+                    CallRows(reinterpret_cast<const void *>(&PowRow), true, instruction);
+                    return;
+                }
+                break;
+            default: break;
+        }
+
+        // the other operators of scalar code run NumericPolicy<double> by a call
+        auto live = LiveAcross(i);
+        Save(live);
+        Move(0, Slot(instruction.left));
+        if (instruction.code == OpCode::Invert) {
+            // mov rdi, r12
+            a.Bytes({ 0x4C, 0x89, 0xE7 });
+            CallChecked(reinterpret_cast<const void *>(&InvertChecked));
+        } else {
+            Move(1, Slot(instruction.right));
+            // mov edi, code; mov rsi, r12
+            a.Byte(0xBF);
+            a.Dword(static_cast<uint32_t>(instruction.code));
+            a.Bytes({ 0x4C, 0x89, 0xE6 });
+            CallChecked(reinterpret_cast<const void *>(&ApplyChecked));
+        }
+        Restore(live);
+        Put(Slot(instruction.dst), 0);
+    }
+
+    Assembler                               a;
+    const std::vector<double>              &literals;
+    const std::vector<Function>            &functions;
+    const std::vector<RegisterInstruction> &instructions;
+    const std::vector<int32_t>             &loads;
+    int32_t                                 resultSlot;
+    Form                                    form;
+    int32_t                                 width;
+    int32_t                                 literalCount;
+    int32_t                                 registerBase;
+    int32_t                                 spillOffset{ 0 }, saveOffset{ 0 }, laneOffset{ 0 };
+    std::vector<size_t>                     lastReads;
+    // instruction whose value each register holds, -1 for none
+    std::vector<int32_t> owners;
+    // jumps to be bound
+    std::vector<size_t> toEpilogue, toDenominatorZero, toNegativeSqrt;
+};
+} // namespace
+#endif // EXP_JIT_X86_64
+
+JitFunction::JitFunction(const CompiledExpression &program, SimdLevel level) :
+    program(program), interpreter(program) {
+    valid = program.IsValid();
+#if EXP_JIT_X86_64
+    if (!valid) return;
+    // register form of program, made here if the compiler didn't
+    const CompiledExpression *registers = &program;
+    CompiledExpression        allocated;
+    if (program.frameSize == 0) {
+        allocated = program;
+        allocated.AllocateRegisters();
+        registers = &allocated;
+    }
+    loads = registers->loads;
+
+    std::vector<double> literals;
+    for (const auto &literal : registers->literals) literals.push_back(literal.GetValueDouble());
+    auto generate = [&](Form form) {
+        CodeGenerator generator(literals, registers->functions, registers->registerCode,
+                                registers->loads, registers->resultSlot, form);
+        return generator.Supported() ? generator.Generate() : std::vector<uint8_t>();
+    };
+    auto scalar = generate(Form::Scalar);
+    auto form   = level >= SimdLevel::AVX2 ? Form::Avx : Form::Sse2;
+    auto batch  = level >= SimdLevel::SSE2 ? generate(form) : std::vector<uint8_t>();
+
+    // both forms in one mapping, written then made executable
+    auto batchStart = (scalar.size() + 63) / 64 * 64;
+    codeSize        = scalar.size() + batch.size();
+    auto page       = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    mappedSize      = (batchStart + batch.size() + page - 1) / page * page;
+    code = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code == MAP_FAILED) {
+        code = nullptr;
+        return;
+    }
+    auto *bytes = static_cast<uint8_t *>(code);
+    std::memcpy(bytes, scalar.data(), scalar.size());
+    if (!batch.empty()) std::memcpy(bytes + batchStart, batch.data(), batch.size());
+    if (mprotect(code, mappedSize, PROT_READ | PROT_EXEC) != 0) return;
+    scalarEntry = reinterpret_cast<ScalarEntry>(bytes);
+    if (!batch.empty()) {
+        batchEntry = reinterpret_cast<BatchEntry>(bytes + batchStart);
+        batchWidth = form == Form::Avx ? 4 : 2;
+    }
+#else
+    (void)level;
+#endif // EXP_JIT_X86_64
+}
+
+JitFunction::~JitFunction() {
+#if EXP_JIT_X86_64
+    if (code) munmap(code, mappedSize);
+#endif // EXP_JIT_X86_64
+}
+
+bool JitFunction::Evaluate(const std::vector<double> &values, double &result) {
+    if (!scalarEntry) {
+        auto succeeded = interpreter.Evaluate(values, result);
+        errors.Clear();
+        for (const auto &record : interpreter.GetErrors()) {
+            errors.Add(record.code, record.offset, record.length, record.valueError);
+        }
+        return succeeded;
+    }
+    errors.Clear();
+    if (program.variableCount > values.size()) {
+        errors.Add(ErrorCode::ContextMissesVariables);
+        return false;
+    }
+    JitStatus status{ 0, ErrorCode::CalculationAborted, ValueError::None };
+    auto      value = scalarEntry(values.data(), &status);
+    if (status.failed) {
+        errors.Add(status.code, -1, 0, status.error);
+        return false;
+    }
+    result = value;
+    return true;
+}
+
+void JitFunction::EvaluateBatch(const std::vector<const double *> &columns,
+                                const std::vector<double> &scalars, size_t rows,
+                                double *output) {
+    if (!valid) {
+        std::fill(output, output + rows, not_a_number);
+        return;
+    }
+    if (!batchEntry) {
+        BatchEvaluator(program, columns, scalars).Run(0, rows, output);
+        return;
+    }
+
+    // inputs of variables without a column repeat their value over a chunk of rows
+    const size_t                chunk = BatchEvaluator::chunk_size;
+    std::vector<const double *> inputs(loads.size()), rowColumns(loads.size());
+    std::vector<double>         repeated(loads.size() * chunk);
+    for (size_t i = 0; i < loads.size(); i++) {
+        auto slot = static_cast<size_t>(loads[i]);
+        if (slot < columns.size()) rowColumns[i] = columns[slot];
+        if (!rowColumns[i]) {
+            std::fill_n(&repeated[i * chunk], chunk,
+                        slot < scalars.size() ? scalars[slot] : not_a_number);
+        }
+    }
+    auto run = [&](size_t begin, size_t count, double *out) {
+        for (size_t i = 0; i < loads.size(); i++) {
+            inputs[i] = rowColumns[i] ? rowColumns[i] + begin : &repeated[i * chunk];
+        }
+        batchEntry(inputs.data(), out, count);
+    };
+
+    const size_t whole = rows / batchWidth * batchWidth;
+    for (size_t begin = 0; begin < whole; begin += chunk) {
+        run(begin, std::min(chunk, whole - begin), output + begin);
+    }
+    if (whole == rows) return;
+
+    // rows after the last whole step, padded to one step
+    std::vector<double> tail(loads.size() * batchWidth), tailOutput(batchWidth);
+    for (size_t i = 0; i < loads.size(); i++) {
+        const auto *from = rowColumns[i] ? rowColumns[i] + whole : &repeated[i * chunk];
+        std::copy(from, from + (rows - whole), &tail[i * batchWidth]);
+        inputs[i] = &tail[i * batchWidth];
+    }
+    batchEntry(inputs.data(), tailOutput.data(), batchWidth);
+    std::copy(tailOutput.begin(), tailOutput.begin() + (rows - whole), output + whole);
+}
+} // namespace exp_solver
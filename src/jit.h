@@ -0,0 +1,123 @@
+/*
+
+jit.h
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Header file for JitFunction, native
+x86-64 code of a compiled program in double
+precision, written to an executable buffer at
+runtime. Programs or platforms it can't compile
+run in the interpreters instead.
+
+*/
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "compiled_exp.h"
+#include "exp_error.h"
+#include "simd_kernels.h"
+#include "typed_eval.h"
+
+namespace exp_solver
+{
+// Failure of a native run, written by native code and its helpers
+struct JitStatus {
+    int32_t    failed;
+    ErrorCode  code;
+    ValueError error;
+};
+
+/**
+ * @brief program compiled to x86-64 machine code, computing in double
+ * @note Evaluate gives the same results and errors as TypedEvaluator<double>,
+ *       EvaluateBatch the same rows as ExpSolver::EvaluateBatch. Scalar code
+ *       uses SSE2, batch code packed SSE2 or AVX by level. Functions are
+ *       called directly, sqrt and abs are inlined. Batch code can't run
+ *       '//', '%', bit operators and '~', those programs and platforms
+ *       other than x86-64 with mmap run the interpreters
+ */
+class JitFunction {
+public:
+    /**
+     * @param program program to compile, must outlive the function
+     * @param level   instruction set of batch code, AVX2 and above use AVX,
+     *                SimdLevel::Scalar runs batches in the interpreter
+     */
+    explicit JitFunction(const CompiledExpression &program, SimdLevel level = DetectSimdLevel());
+    // program is kept by reference, a temporary one would dangle
+    explicit JitFunction(CompiledExpression &&, SimdLevel = SimdLevel::Scalar) = delete;
+    ~JitFunction();
+
+    // owns its executable buffer
+    JitFunction(const JitFunction &)            = delete;
+    JitFunction &operator=(const JitFunction &) = delete;
+
+    // Whether program is valid
+    bool IsValid() const { return valid; }
+
+    // Whether Evaluate runs native code
+    bool IsNative() const { return scalarEntry != nullptr; }
+
+    // Whether EvaluateBatch runs native code
+    bool IsBatchNative() const { return batchEntry != nullptr; }
+
+    // Rows one step of native batch code computes, 0 if batches are interpreted
+    size_t GetBatchWidth() const { return batchWidth; }
+
+    // Bytes of machine code of both forms
+    size_t GetCodeSize() const { return codeSize; }
+
+    // Count of values Evaluate needs, values[handle] is value of variable
+    size_t GetVariableCount() const { return program.variableCount; }
+
+    /**
+     * @brief evaluate program with values of variables
+     * @param values values[handle] is value of variable of handle from ExpSolver
+     * @param result result of output, not changed for fail
+     * @return false for fail, use GetErrorMessages() get fail reason
+     */
+    bool Evaluate(const std::vector<double> &values, double &result);
+
+    /**
+     * @brief evaluate program over rows, rows fail to calculate get NaN
+     * @param columns columns[handle] is values of variable for every row,
+     *                nullptr or missing means use scalars[handle] for all rows
+     * @param scalars value of every variable, NaN for missing ones
+     * @param rows    count of rows
+     * @param output  results of rows
+     */
+    void EvaluateBatch(const std::vector<const double *> &columns,
+                       const std::vector<double> &scalars, size_t rows, double *output);
+
+    // Text of errors of the latest call
+    std::string GetErrorMessages() const { return errors.Render(std::string()); }
+
+    const std::vector<ErrorRecord> &GetErrors() const { return errors.GetRecords(); }
+
+private:
+    // double f(const double *values, JitStatus *status)
+    using ScalarEntry = double (*)(const double *, JitStatus *);
+    // void f(const double *const *inputs, double *output, size_t rows), rows of every
+    // input are contiguous, rows is a multiple of batch width
+    using BatchEntry = void (*)(const double *const *, double *, size_t);
+
+    const CompiledExpression &program;
+    // runs program when native code is missing
+    TypedEvaluator<double> interpreter;
+    ErrorList              errors;
+    bool                   valid{ false };
+
+    // mapping of native code of both forms
+    void       *code{ nullptr };
+    size_t      codeSize{ 0 };
+    size_t      mappedSize{ 0 };
+    ScalarEntry scalarEntry{ nullptr };
+    BatchEntry  batchEntry{ nullptr };
+    size_t      batchWidth{ 0 };
+    // variable slot of each batch input
+    std::vector<int32_t> loads;
+};
+} // namespace exp_solver
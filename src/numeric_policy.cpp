@@ -0,0 +1,110 @@
+/*
+
+numeric_policy.cpp
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Implementation of the out of line
+parts of NumericPolicy<int64_t>.
+
+*/
+#include <cmath>
+
+#include "numeric_policy.h"
+
+namespace exp_solver
+{
+// Whether v is an integer of int64_t other than INT64_MIN
+static inline bool IsInteger(double v) {
+    return v == std::floor(v) && std::fabs(v) < 9.2e18;
+}
+
+int64_t NumericPolicy<int64_t>::FromValue(const Value &value, ValueError &error) {
+    if (value.IsDecimal()) {
+        auto dv = value.GetValueDouble();
+        if (IsInteger(dv)) return static_cast<int64_t>(dv);
+    } else {
+        auto fraction = value.GetFracValue();
+        if (fraction.down == 1 && fraction.up != INT64_MIN) return fraction.up;
+    }
+    error = ValueError::ConvertFail;
+    return 0;
+}
+
+int64_t NumericPolicy<int64_t>::Call(double (*func)(double), int64_t a, ValueError &error) {
+    auto result = func(static_cast<double>(a));
+    if (IsInteger(result)) return static_cast<int64_t>(result);
+    error = ValueError::ConvertFail;
+    return 0;
+}
+
+// floor(a / b), b is not 0
+static inline int64_t FloorDivide(int64_t a, int64_t b) {
+    auto quotient = a / b;
+    if (a % b != 0 && (a < 0) != (b < 0)) quotient--;
+    return quotient;
+}
+
+int64_t NumericPolicy<int64_t>::ApplyInteger(OpCode code, int64_t a, int64_t b,
+                                             ValueError &error) {
+    // operands are never INT64_MIN, so results that may be it are checked
+    auto checked = [&](int64_t result) {
+        if (result == INT64_MIN) error = ValueError::NumberTooLarge;
+        return result;
+    };
+    switch (code) {
+        case OpCode::Pow: {
+            if (b < 0) {
+                if (a == 0) error = ValueError::DenominatorZero;
+                // floor of 1 / a ** -b
+                if (a == 1) return 1;
+                return a < 0 && (b & 1) ? -1 : a == -1 ? 1 : 0;
+            }
+            int64_t result = 1;
+            for (; b > 0; b >>= 1) {
+                if ((b & 1) && MulOverflow(result, a, result)) break;
+                if (b > 1 && MulOverflow(a, a, a)) break;
+            }
+            if (b > 0) error = ValueError::NumberTooLarge;
+            return result;
+        }
+        case OpCode::Div:
+        case OpCode::FloorDiv:
+            if (b == 0) {
+                error = ValueError::DenominatorZero;
+                return 0;
+            }
+            return FloorDivide(a, b);
+        case OpCode::Mod:
+            if (b == 0) {
+                error = ValueError::ModZero;
+                return 0;
+            }
+            return a % b;
+        case OpCode::Shl: {
+            if (b < 0) {
+                error = ValueError::LeftShiftFloat;
+                return 0;
+            }
+            if (a == 0) return 0;
+            // shift as unsigned, left shift of negative number is undefined
+            auto shifted = b < 63 ? static_cast<int64_t>(static_cast<uint64_t>(a) << b) : 0;
+            if (b >= 63 || (shifted >> b) != a) error = ValueError::NumberTooLarge;
+            return checked(shifted);
+        }
+        case OpCode::Shr:
+            if (b < 0) {
+                error = ValueError::RightShiftFloat;
+                return 0;
+            }
+            return a >> (b < 63 ? b : 63);
+        case OpCode::And: return checked(a & b);
+        case OpCode::Xor: return checked(a ^ b);
+        case OpCode::Or: return a | b;
+        default:
+            error = ValueError::InvalidOperator;
+            return 0;
+    }
+}
+} // namespace exp_solver
@@ -0,0 +1,150 @@
+/*
+
+numeric_policy.h
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Header file for NumericPolicy, the
+arithmetic of a number type TypedEvaluator runs
+compiled programs in. Policies of Value, double,
+float and int64_t are provided, other types can
+be used by specializing NumericPolicy for them.
+
+*/
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include "value.h"
+#include "int_math.h"
+#include "compiled_exp.h"
+#include "double_ops.h"
+
+namespace exp_solver
+{
+/**
+ * @brief arithmetic of number type T, chosen at compile time so evaluation has no
+ *        branch on the kind of number. A specialization has these static members,
+ *        failing ones set error and may return anything:
+ *
+ *        T FromValue(const Value &value, ValueError &error)    literal or variable as T
+ *        Value ToValue(const T &value)
+ *        T Apply(OpCode code, const T &a, const T &b, ValueError &error)    binary operator
+ *        T Negate(const T &a, ValueError &error)
+ *        T Invert(const T &a, ValueError &error)
+ *        T Call(double (*func)(double), const T &a, ValueError &error)
+ *        bool IsNegative(const T &a)    rejects argument of sqrt
+ *        ValueError ErrorOf(const T &a)    error carried by the number, for types like Value
+ */
+template <typename T>
+struct NumericPolicy;
+
+// Exact fractions while they fit, errors are carried by the value
+template <>
+struct NumericPolicy<Value> {
+    static Value FromValue(const Value &value, ValueError &) { return value; }
+    static Value ToValue(const Value &value) { return value; }
+    static Value Apply(OpCode code, const Value &a, const Value &b, ValueError &) {
+        return ApplyOperator(code, a, b);
+    }
+    static Value Negate(const Value &a, ValueError &) { return -a; }
+    static Value Invert(const Value &a, ValueError &) { return ~a; }
+    static Value Call(double (*func)(double), const Value &a, ValueError &error) {
+        if (!a.IsCalculable()) {
+            error = a.GetError();
+            return a;
+        }
+        return Value(func(a.GetValueDouble()));
+    }
+    static bool IsNegative(const Value &a) {
+        return a.IsCalculable() && a.GetValueDouble() < 0;
+    }
+    static ValueError ErrorOf(const Value &a) { return a.GetError(); }
+};
+
+// IEEE double, operators other than + - * are checked like Value
+template <>
+struct NumericPolicy<double> {
+    static double FromValue(const Value &value, ValueError &) { return value.GetValueDouble(); }
+    static Value  ToValue(double value) { return Value(value); }
+    static double Apply(OpCode code, double a, double b, ValueError &error) {
+        switch (code) {
+            case OpCode::Add: return a + b;
+            case OpCode::Sub: return a - b;
+            case OpCode::Mul: return a * b;
+            default: return ApplyOperator(code, a, b, error);
+        }
+    }
+    static double Negate(double a, ValueError &) { return -a; }
+    static double Invert(double a, ValueError &error) { return double_ops::Invert(a, error); }
+    static double Call(double (*func)(double), double a, ValueError &) { return func(a); }
+    static bool   IsNegative(double a) { return a < 0; }
+    static ValueError ErrorOf(double) { return ValueError::None; }
+};
+
+// IEEE float, same checks as double
+template <>
+struct NumericPolicy<float> {
+    static float FromValue(const Value &value, ValueError &) {
+        return static_cast<float>(value.GetValueDouble());
+    }
+    static Value ToValue(float value) { return Value(static_cast<double>(value)); }
+    static float Apply(OpCode code, float a, float b, ValueError &error) {
+        switch (code) {
+            case OpCode::Add: return a + b;
+            case OpCode::Sub: return a - b;
+            case OpCode::Mul: return a * b;
+            default: return static_cast<float>(ApplyOperator(code, a, b, error));
+        }
+    }
+    static float Negate(float a, ValueError &) { return -a; }
+    static float Invert(float a, ValueError &error) {
+        return static_cast<float>(NumericPolicy<double>::Invert(a, error));
+    }
+    static float Call(double (*func)(double), float a, ValueError &) {
+        return static_cast<float>(func(a));
+    }
+    static bool       IsNegative(float a) { return a < 0; }
+    static ValueError ErrorOf(float) { return ValueError::None; }
+};
+
+/**
+ * @brief integer arithmetic, for rule sets of bit operators. '/' floors like '//',
+ *        x ** -n is floor(1 / x ** n), overflow fails with NumberTooLarge, function
+ *        results and values converted from Value must be integers
+ */
+template <>
+struct NumericPolicy<int64_t> {
+    static int64_t FromValue(const Value &value, ValueError &error);
+    static Value   ToValue(int64_t value) { return Value(Fraction(value, 1)); }
+    static int64_t Apply(OpCode code, int64_t a, int64_t b, ValueError &error) {
+        int64_t out = 0;
+        switch (code) {
+            case OpCode::Add:
+                if (AddOverflow(a, b, out)) error = ValueError::NumberTooLarge;
+                return out;
+            case OpCode::Sub:
+                // b is never INT64_MIN, so -b can't overflow
+                if (AddOverflow(a, -b, out)) error = ValueError::NumberTooLarge;
+                return out;
+            case OpCode::Mul:
+                if (MulOverflow(a, b, out)) error = ValueError::NumberTooLarge;
+                return out;
+            default: return ApplyInteger(code, a, b, error);
+        }
+    }
+    static int64_t Negate(int64_t a, ValueError &) { return -a; }
+    static int64_t Invert(int64_t a, ValueError &error) {
+        // ~INT64_MAX is INT64_MIN, which can't be negated
+        if (a == INT64_MAX) error = ValueError::NumberTooLarge;
+        return ~a;
+    }
+    static int64_t    Call(double (*func)(double), int64_t a, ValueError &error);
+    static bool       IsNegative(int64_t a) { return a < 0; }
+    static ValueError ErrorOf(int64_t) { return ValueError::None; }
+
+private:
+    // Operators other than + - *
+    static int64_t ApplyInteger(OpCode code, int64_t a, int64_t b, ValueError &error);
+};
+} // namespace exp_solver
@@ -0,0 +1,40 @@
+/*
+
+registry.cpp
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Implementation of Registry.
+
+*/
+#include <cmath>
+
+#include "registry.h"
+
+namespace exp_solver
+{
+static Registry BuildPredefined() {
+    Registry registry;
+    registry.constants.Insert(Variable("e", Value(M_E)));
+    registry.constants.Insert(Variable("pi", Value(M_PI)));
+    registry.functions.Insert(Function("sin", std::sin));
+    registry.functions.Insert(Function("cos", std::cos));
+    registry.functions.Insert(Function("tan", std::tan));
+    registry.functions.Insert(Function("exp", std::exp));
+    registry.functions.Insert(Function("sqrt", std::sqrt));
+    registry.functions.Insert(Function("floor", std::floor));
+    registry.functions.Insert(Function("ceil", std::ceil));
+    registry.functions.Insert(Function("round", round));
+    registry.functions.Insert(Function("ln", std::log));
+    registry.functions.Insert(Function("log", std::log10));
+    registry.functions.Insert(Function("abs", std::abs));
+    return registry;
+}
+
+const Registry &Registry::Predefined() {
+    // initialized once, thread safe since C++11
+    static const Registry registry = BuildPredefined();
+    return registry;
+}
+} // namespace exp_solver
@@ -0,0 +1,26 @@
+/*
+
+registry.h
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Header file for Registry, the
+predefined constants and functions, built once
+and shared read-only by every ExpSolver.
+
+*/
+#pragma once
+#include "symbol_table.h"
+
+namespace exp_solver
+{
+struct Registry {
+    SymbolTable<Variable> constants;
+    SymbolTable<Function> functions;
+
+    // The immutable registry of predefined constants and functions,
+    // safe to read from many threads
+    static const Registry &Predefined();
+};
+} // namespace exp_solver
@@ -0,0 +1,50 @@
+/*
+
+simd_avx2.cpp
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: BatchKernels of AVX2, this file is
+built with -mavx2 and only called after CPU
+support is checked.
+
+*/
+#include <immintrin.h>
+
+#include "simd_kernels_impl.h"
+
+namespace exp_solver
+{
+namespace
+{
+struct Avx2 {
+    using Reg                       = __m256d;
+    static constexpr size_t width = 4;
+
+    static Reg  Load(const double *p) { return _mm256_loadu_pd(p); }
+    static void Store(double *p, Reg v) { _mm256_storeu_pd(p, v); }
+    static Reg  Add(Reg a, Reg b) { return _mm256_add_pd(a, b); }
+    static Reg  Sub(Reg a, Reg b) { return _mm256_sub_pd(a, b); }
+    static Reg  Mul(Reg a, Reg b) { return _mm256_mul_pd(a, b); }
+    static Reg  Div(Reg a, Reg b) { return _mm256_div_pd(a, b); }
+    static Reg  Neg(Reg a) { return _mm256_xor_pd(a, _mm256_set1_pd(-0.0)); }
+    static Reg  Abs(Reg a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+    static Reg  Sqrt(Reg a) { return _mm256_sqrt_pd(a); }
+    static Reg  Floor(Reg a) { return _mm256_round_pd(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+    static Reg  Ceil(Reg a) { return _mm256_round_pd(a, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC); }
+    // half away from zero, like std::round
+    static Reg Round(Reg a) {
+        auto trunc = _mm256_round_pd(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+        auto half  = _mm256_cmp_pd(Abs(Sub(a, trunc)), _mm256_set1_pd(0.5), _CMP_GE_OQ);
+        auto one   = _mm256_or_pd(_mm256_and_pd(a, _mm256_set1_pd(-0.0)), _mm256_set1_pd(1.0));
+        return Add(trunc, _mm256_and_pd(half, one));
+    }
+};
+} // namespace
+
+const BatchKernels &GetAvx2Kernels() {
+    static const BatchKernels kernels = MakeBatchKernels<Avx2>(SimdLevel::AVX2);
+    return kernels;
+}
+} // namespace exp_solver
@@ -0,0 +1,55 @@
+/*
+
+simd_avx512.cpp
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: BatchKernels of AVX-512, this file
+is built with -mavx512f and only called after
+CPU support is checked.
+
+*/
+#include <immintrin.h>
+
+#include "simd_kernels_impl.h"
+
+namespace exp_solver
+{
+namespace
+{
+struct Avx512 {
+    using Reg                       = __m512d;
+    static constexpr size_t width = 8;
+
+    static __m512i Bits(Reg a) { return _mm512_castpd_si512(a); }
+    static Reg     SignMask() { return _mm512_set1_pd(-0.0); }
+
+    static Reg  Load(const double *p) { return _mm512_loadu_pd(p); }
+    static void Store(double *p, Reg v) { _mm512_storeu_pd(p, v); }
+    static Reg  Add(Reg a, Reg b) { return _mm512_add_pd(a, b); }
+    static Reg  Sub(Reg a, Reg b) { return _mm512_sub_pd(a, b); }
+    static Reg  Mul(Reg a, Reg b) { return _mm512_mul_pd(a, b); }
+    static Reg  Div(Reg a, Reg b) { return _mm512_div_pd(a, b); }
+    // xor_pd needs AVX512DQ, use integer xor
+    static Reg Neg(Reg a) { return _mm512_castsi512_pd(_mm512_xor_si512(Bits(a), Bits(SignMask()))); }
+    static Reg Abs(Reg a) { return _mm512_abs_pd(a); }
+    static Reg Sqrt(Reg a) { return _mm512_sqrt_pd(a); }
+    static Reg Floor(Reg a) { return _mm512_roundscale_pd(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+    static Reg Ceil(Reg a) { return _mm512_roundscale_pd(a, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC); }
+    // half away from zero, like std::round
+    static Reg Round(Reg a) {
+        auto trunc = _mm512_roundscale_pd(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+        auto half  = _mm512_cmp_pd_mask(Abs(Sub(a, trunc)), _mm512_set1_pd(0.5), _CMP_GE_OQ);
+        auto one   = _mm512_castsi512_pd(_mm512_or_si512(
+            _mm512_and_si512(Bits(a), Bits(SignMask())), Bits(_mm512_set1_pd(1.0))));
+        return _mm512_mask_add_pd(trunc, half, trunc, one);
+    }
+};
+} // namespace
+
+const BatchKernels &GetAvx512Kernels() {
+    static const BatchKernels kernels = MakeBatchKernels<Avx512>(SimdLevel::AVX512);
+    return kernels;
+}
+} // namespace exp_solver
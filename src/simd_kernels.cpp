@@ -0,0 +1,144 @@
+/*
+
+simd_kernels.cpp
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Scalar and SSE2 BatchKernels and
+runtime selection of the kernels.
+
+*/
+#include <cmath>
+#include <cstring>
+
+#include "simd_kernels.h"
+
+#if defined(__SSE2__)
+#    include <emmintrin.h>
+#    include "simd_kernels_impl.h"
+#endif
+
+namespace exp_solver
+{
+namespace
+{
+struct Scalar {
+    static double Add(double a, double b) { return a + b; }
+    static double Sub(double a, double b) { return a - b; }
+    static double Mul(double a, double b) { return a * b; }
+    static double Div(double a, double b) { return a / b; }
+    static double FloorDiv(double a, double b) { return std::floor(a / b); }
+    static double Neg(double a) { return -a; }
+    static double Sqrt(double a) { return std::sqrt(a); }
+    static double Floor(double a) { return std::floor(a); }
+    static double Ceil(double a) { return std::ceil(a); }
+    static double Round(double a) { return std::round(a); }
+    static double Abs(double a) { return std::fabs(a); }
+};
+
+template <double (*Op)(double, double)>
+void ScalarBinary(const double *a, const double *b, double *out, size_t n) {
+    for (size_t i = 0; i < n; i++) out[i] = Op(a[i], b[i]);
+}
+
+template <double (*Op)(double)>
+void ScalarUnary(const double *a, double *out, size_t n) {
+    for (size_t i = 0; i < n; i++) out[i] = Op(a[i]);
+}
+
+const BatchKernels scalar_kernels{ SimdLevel::Scalar,
+                                   &ScalarBinary<Scalar::Add>,
+                                   &ScalarBinary<Scalar::Sub>,
+                                   &ScalarBinary<Scalar::Mul>,
+                                   &ScalarBinary<Scalar::Div>,
+                                   &ScalarBinary<Scalar::FloorDiv>,
+                                   &ScalarUnary<Scalar::Neg>,
+                                   &ScalarUnary<Scalar::Sqrt>,
+                                   &ScalarUnary<Scalar::Floor>,
+                                   &ScalarUnary<Scalar::Ceil>,
+                                   &ScalarUnary<Scalar::Round>,
+                                   &ScalarUnary<Scalar::Abs> };
+
+#if defined(__SSE2__)
+struct Sse2 {
+    using Reg                       = __m128d;
+    static constexpr size_t width = 2;
+
+    static Reg  Load(const double *p) { return _mm_loadu_pd(p); }
+    static void Store(double *p, Reg v) { _mm_storeu_pd(p, v); }
+    static Reg  Add(Reg a, Reg b) { return _mm_add_pd(a, b); }
+    static Reg  Sub(Reg a, Reg b) { return _mm_sub_pd(a, b); }
+    static Reg  Mul(Reg a, Reg b) { return _mm_mul_pd(a, b); }
+    static Reg  Div(Reg a, Reg b) { return _mm_div_pd(a, b); }
+    static Reg  Neg(Reg a) { return _mm_xor_pd(a, _mm_set1_pd(-0.0)); }
+    static Reg  Abs(Reg a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+    static Reg  Sqrt(Reg a) { return _mm_sqrt_pd(a); }
+    // SSE2 has no rounding instruction, round lane by lane
+    static Reg Floor(Reg a) { return ByLane<Scalar::Floor>(a); }
+    static Reg Ceil(Reg a) { return ByLane<Scalar::Ceil>(a); }
+    static Reg Round(Reg a) { return ByLane<Scalar::Round>(a); }
+
+    template <double (*Op)(double)>
+    static Reg ByLane(Reg a) {
+        alignas(16) double lanes[width];
+        _mm_store_pd(lanes, a);
+        return _mm_set_pd(Op(lanes[1]), Op(lanes[0]));
+    }
+};
+#endif
+} // namespace
+
+const char *SimdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::SSE2: return "SSE2";
+        case SimdLevel::AVX2: return "AVX2";
+        case SimdLevel::AVX512: return "AVX512";
+        default: return "Scalar";
+    }
+}
+
+SimdLevel DetectSimdLevel() {
+#if EXP_SOLVER_X86_SIMD
+    if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+#endif
+#if defined(__SSE2__)
+    return SimdLevel::SSE2;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+const BatchKernels *GetBatchKernels(SimdLevel level) {
+    if (level > DetectSimdLevel()) return nullptr;
+    switch (level) {
+#if EXP_SOLVER_X86_SIMD
+        case SimdLevel::AVX512: return &GetAvx512Kernels();
+        case SimdLevel::AVX2: return &GetAvx2Kernels();
+#endif
+#if defined(__SSE2__)
+        case SimdLevel::SSE2: {
+            static const BatchKernels kernels = MakeBatchKernels<Sse2>(SimdLevel::SSE2);
+            return &kernels;
+        }
+#endif
+        case SimdLevel::Scalar: return &scalar_kernels;
+        default: return nullptr;
+    }
+}
+
+const BatchKernels &GetBatchKernels() {
+    static const BatchKernels &kernels = *GetBatchKernels(DetectSimdLevel());
+    return kernels;
+}
+
+UnaryKernel FindFunctionKernel(const BatchKernels &kernels, const char *name) {
+    if (std::strcmp(name, "sqrt") == 0) return kernels.sqrt;
+    if (std::strcmp(name, "floor") == 0) return kernels.floor;
+    if (std::strcmp(name, "ceil") == 0) return kernels.ceil;
+    if (std::strcmp(name, "round") == 0) return kernels.round;
+    if (std::strcmp(name, "abs") == 0) return kernels.abs;
+    return nullptr;
+}
+} // namespace exp_solver
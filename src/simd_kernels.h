@@ -0,0 +1,46 @@
+/*
+
+simd_kernels.h
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Header file for BatchKernels, tables
+of double array operations used by BatchEvaluator,
+one table per SIMD instruction set, picked at
+runtime by what the CPU supports.
+
+*/
+#pragma once
+#include <cstddef>
+
+namespace exp_solver
+{
+enum class SimdLevel { Scalar, SSE2, AVX2, AVX512 };
+
+// out[i] = op(a[i], b[i]) for i in [0,n), out may be the same as a or b
+using BinaryKernel = void (*)(const double *a, const double *b, double *out, size_t n);
+// out[i] = op(a[i]) for i in [0,n), out may be the same as a
+using UnaryKernel = void (*)(const double *a, double *out, size_t n);
+
+struct BatchKernels {
+    SimdLevel    level;
+    BinaryKernel add, sub, mul, div, floorDiv;
+    UnaryKernel  neg, sqrt, floor, ceil, round, abs;
+};
+
+// Name of level, like "AVX2"
+const char *SimdLevelName(SimdLevel level);
+
+// Highest level supported by both the build and the CPU
+SimdLevel DetectSimdLevel();
+
+// Kernels of level, nullptr if not supported by the build or the CPU
+const BatchKernels *GetBatchKernels(SimdLevel level);
+
+// Kernels of the highest supported level
+const BatchKernels &GetBatchKernels();
+
+// Kernel of builtin function by its name, nullptr if it has none
+UnaryKernel FindFunctionKernel(const BatchKernels &kernels, const char *name);
+} // namespace exp_solver
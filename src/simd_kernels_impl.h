@@ -0,0 +1,81 @@
+/*
+
+simd_kernels_impl.h
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Kernel templates over a register
+traits type, included by the translation unit
+of every instruction set, which is built with
+the compile flags of that instruction set.
+
+*/
+#pragma once
+#include <cstddef>
+#include "simd_kernels.h"
+
+namespace exp_solver
+{
+// Kernel tables defined by the instruction set translation units
+const BatchKernels &GetAvx2Kernels();
+const BatchKernels &GetAvx512Kernels();
+
+// Everything below is compiled once per instruction set,
+// keep it internal so no definition leaks across them
+namespace
+{
+/*
+ * Traits V must provide:
+ *   Reg, width, Load, Store, Add, Sub, Mul, Div, Neg, Sqrt, Floor, Ceil, Round, Abs
+ */
+template <typename V, typename V::Reg (*Op)(typename V::Reg, typename V::Reg)>
+void BinaryKernelImpl(const double *a, const double *b, double *out, size_t n) {
+    size_t i = 0;
+    for (; i + V::width <= n; i += V::width) {
+        V::Store(out + i, Op(V::Load(a + i), V::Load(b + i)));
+    }
+    if (i == n) return;
+    // rest rows go through a full register
+    alignas(64) double restA[V::width] = {}, restB[V::width] = {}, restOut[V::width];
+    for (size_t k = 0; i + k < n; k++) {
+        restA[k] = a[i + k];
+        restB[k] = b[i + k];
+    }
+    V::Store(restOut, Op(V::Load(restA), V::Load(restB)));
+    for (size_t k = 0; i + k < n; k++) out[i + k] = restOut[k];
+}
+
+template <typename V, typename V::Reg (*Op)(typename V::Reg)>
+void UnaryKernelImpl(const double *a, double *out, size_t n) {
+    size_t i = 0;
+    for (; i + V::width <= n; i += V::width) V::Store(out + i, Op(V::Load(a + i)));
+    if (i == n) return;
+    alignas(64) double restA[V::width] = {}, restOut[V::width];
+    for (size_t k = 0; i + k < n; k++) restA[k] = a[i + k];
+    V::Store(restOut, Op(V::Load(restA)));
+    for (size_t k = 0; i + k < n; k++) out[i + k] = restOut[k];
+}
+
+template <typename V>
+typename V::Reg FloorDivImpl(typename V::Reg a, typename V::Reg b) {
+    return V::Floor(V::Div(a, b));
+}
+
+template <typename V>
+BatchKernels MakeBatchKernels(SimdLevel level) {
+    return BatchKernels{ level,
+                         &BinaryKernelImpl<V, V::Add>,
+                         &BinaryKernelImpl<V, V::Sub>,
+                         &BinaryKernelImpl<V, V::Mul>,
+                         &BinaryKernelImpl<V, V::Div>,
+                         &BinaryKernelImpl<V, FloorDivImpl<V>>,
+                         &UnaryKernelImpl<V, V::Neg>,
+                         &UnaryKernelImpl<V, V::Sqrt>,
+                         &UnaryKernelImpl<V, V::Floor>,
+                         &UnaryKernelImpl<V, V::Ceil>,
+                         &UnaryKernelImpl<V, V::Round>,
+                         &UnaryKernelImpl<V, V::Abs> };
+}
+} // namespace
+} // namespace exp_solver
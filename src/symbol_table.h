@@ -0,0 +1,122 @@
+/*
+
+symbol_table.h
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Header file for Variable, Function and
+SymbolTable, a vector of named entries indexed by
+an open addressing hash table, so entries can be
+found by name without comparing every entry.
+
+*/
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "value.h"
+
+namespace exp_solver
+{
+// Stable slot of a variable in ExpSolver, -1 for invalid
+using VariableHandle = int32_t;
+
+struct Variable {
+    std::string name;
+    Value       value;
+    Variable(std::string nm, Value val) : name(nm), value(val) {}
+};
+
+struct Function {
+    std::string name;
+    double (*func)(double);
+    Function(std::string nm, double (*f)(double)) : name(nm), func(f) {}
+};
+
+/**
+ * @brief named entries kept in insert order, index of entry never changes
+ * @tparam T entry type with a std::string member "name"
+ */
+template <typename T>
+class SymbolTable {
+public:
+    SymbolTable() : slots(initial_capacity, empty_slot) {}
+
+    // Index of entry named name, -1 if not found
+#ifdef EXP_HAS_STRING_VIEW
+    int Find(std::string_view name) const { return Find(name.data(), name.size()); }
+#endif
+    int Find(const std::string &name) const { return Find(name.data(), name.size()); }
+
+    int Find(const char *name, size_t size) const {
+        auto hash = Hash(name, size);
+        for (size_t slot = hash & (slots.size() - 1);; slot = (slot + 1) & (slots.size() - 1)) {
+            auto index = slots[slot];
+            if (index == empty_slot) return -1;
+            const auto &entryName = entries[index].name;
+            if (hashes[index] == hash && entryName.size() == size
+                && entryName.compare(0, size, name, size) == 0) {
+                return index;
+            }
+        }
+    }
+
+    // Add entry, name of entry must not exist, return its index
+    int Insert(T entry) {
+        // keep load factor under 1/2
+        if ((entries.size() + 1) * 2 > slots.size()) Rehash(slots.size() * 2);
+        auto hash = Hash(entry.name.data(), entry.name.size());
+        int  index = static_cast<int>(entries.size());
+        entries.push_back(std::move(entry));
+        hashes.push_back(hash);
+        Place(hash, index);
+        return index;
+    }
+
+    size_t   Size() const { return entries.size(); }
+    T       &operator[](size_t index) { return entries[index]; }
+    const T &operator[](size_t index) const { return entries[index]; }
+
+    typename std::vector<T>::iterator       begin() { return entries.begin(); }
+    typename std::vector<T>::iterator       end() { return entries.end(); }
+    typename std::vector<T>::const_iterator begin() const { return entries.begin(); }
+    typename std::vector<T>::const_iterator end() const { return entries.end(); }
+
+private:
+    static constexpr int32_t empty_slot       = -1;
+    static constexpr size_t  initial_capacity = 16;
+
+    // FNV-1a
+    static uint32_t Hash(const char *name, size_t size) {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < size; i++) {
+            hash ^= static_cast<unsigned char>(name[i]);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    // Put index in the first empty slot from hash
+    void Place(uint32_t hash, int32_t index) {
+        auto slot = hash & (slots.size() - 1);
+        while (slots[slot] != empty_slot) slot = (slot + 1) & (slots.size() - 1);
+        slots[slot] = index;
+    }
+
+    void Rehash(size_t capacity) {
+        slots.assign(capacity, empty_slot);
+        for (size_t i = 0; i < entries.size(); i++) Place(hashes[i], i);
+    }
+
+    std::vector<T>        entries;
+    std::vector<uint32_t> hashes;
+    // index of entries, capacity is always power of 2
+    std::vector<int32_t> slots;
+};
+
+template <typename T>
+constexpr int32_t SymbolTable<T>::empty_slot;
+template <typename T>
+constexpr size_t SymbolTable<T>::initial_capacity;
+} // namespace exp_solver
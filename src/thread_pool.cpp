@@ -0,0 +1,108 @@
+/*
+
+thread_pool.cpp
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Implementation of ThreadPool.
+
+*/
+#include <algorithm>
+
+#include "thread_pool.h"
+
+namespace exp_solver
+{
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < threads; i++) queues.emplace_back(new Queue);
+    for (size_t i = 0; i + 1 < threads; i++) workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeWorkers.notify_all();
+    for (auto &worker : workers) worker.join();
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t grain, const RangeBody &func) {
+    if (count == 0) return;
+    grain = std::max<size_t>(grain, 1);
+    std::lock_guard<std::mutex> call(callMutex);
+
+    // give each thread a contiguous share of ranges, so most work needs no stealing
+    size_t ranges  = (count + grain - 1) / grain;
+    size_t threads = queues.size();
+    for (size_t t = 0; t < threads; t++) {
+        size_t first = ranges * t / threads, last = ranges * (t + 1) / threads;
+        std::lock_guard<std::mutex> lock(queues[t]->mutex);
+        for (size_t r = first; r < last; r++) {
+            queues[t]->ranges.push_back({ r * grain, std::min(count, (r + 1) * grain) });
+        }
+    }
+
+    if (!workers.empty()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        body        = &func;
+        busyWorkers = workers.size();
+        generation++;
+    }
+    wakeWorkers.notify_all();
+
+    size_t caller = threads - 1;
+    Range  range;
+    while (Pop(caller, range) || Steal(caller, range)) func(range.begin, range.end, caller);
+
+    // all queues are empty here, but workers may still run their last range
+    std::unique_lock<std::mutex> lock(mutex);
+    jobDone.wait(lock, [this] { return busyWorkers == 0; });
+    body = nullptr;
+}
+
+void ThreadPool::WorkerLoop(size_t worker) {
+    uint64_t seen = 0;
+    while (true) {
+        const RangeBody *func;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeWorkers.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            func = body;
+        }
+        Range range;
+        while (Pop(worker, range) || Steal(worker, range)) (*func)(range.begin, range.end, worker);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busyWorkers == 0) jobDone.notify_one();
+        }
+    }
+}
+
+bool ThreadPool::Pop(size_t worker, Range &range) {
+    auto                       &queue = *queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.ranges.empty()) return false;
+    // own ranges in order, so rows of a thread are written forward
+    range = queue.ranges.front();
+    queue.ranges.pop_front();
+    return true;
+}
+
+bool ThreadPool::Steal(size_t worker, Range &range) {
+    for (size_t i = 1; i < queues.size(); i++) {
+        auto                       &queue = *queues[(worker + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.ranges.empty()) continue;
+        // take from the far end of victim
+        range = queue.ranges.back();
+        queue.ranges.pop_back();
+        return true;
+    }
+    return false;
+}
+} // namespace exp_solver
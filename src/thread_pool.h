@@ -0,0 +1,83 @@
+/*
+
+thread_pool.h
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Header file for ThreadPool, a fixed
+set of worker threads running ranges of a loop,
+each worker owns a queue of ranges and steals
+from others when its own queue is empty.
+
+*/
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace exp_solver
+{
+class ThreadPool {
+public:
+    // body(begin, end, worker) runs [begin,end), worker is in [0,GetThreadCount())
+    using RangeBody = std::function<void(size_t begin, size_t end, size_t worker)>;
+
+    /**
+     * @param threads count of threads running loops including the caller,
+     *                0 for the count of hardware threads
+     */
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &)            = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    size_t GetThreadCount() const { return queues.size(); }
+
+    /**
+     * @brief split [0,count) into ranges of grain and run body on them in parallel,
+     *        return after all ranges are done, the caller thread runs ranges too
+     * @note calls from many threads run one after another
+     * @param count count of loop items
+     * @param grain max items of one range, 0 is treated as 1
+     * @param body  function to run on every range, must not throw
+     */
+    void ParallelFor(size_t count, size_t grain, const RangeBody &body);
+
+private:
+    struct Range {
+        size_t begin, end;
+    };
+    struct Queue {
+        std::mutex        mutex;
+        std::deque<Range> ranges;
+    };
+
+    void WorkerLoop(size_t worker);
+
+    bool Pop(size_t worker, Range &range);
+    bool Steal(size_t worker, Range &range);
+
+    // one queue per thread, the last one belongs to the caller
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread>            workers;
+
+    // serialize ParallelFor calls
+    std::mutex callMutex;
+
+    std::mutex              mutex;
+    std::condition_variable wakeWorkers, jobDone;
+    // increased for every job, workers wake when it changes
+    uint64_t         generation{ 0 };
+    const RangeBody *body{ nullptr };
+    // workers still running current job
+    size_t busyWorkers{ 0 };
+    bool   stopping{ false };
+};
+} // namespace exp_solver
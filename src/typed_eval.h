@@ -0,0 +1,293 @@
+/*
+
+typed_eval.h
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Header file for TypedEvaluator, the
+postfix program interpreter templated over the
+number type it computes in. EvalContext and
+ExpSolver run their programs through it too.
+
+*/
+#pragma once
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "value.h"
+#include "compiled_exp.h"
+#include "exp_error.h"
+#include "numeric_policy.h"
+
+namespace exp_solver
+{
+// Dispatch of evaluator loops over ip and end, EXP_OP starts the handler of an opcode,
+// EXP_NEXT goes to the next instruction, EXP_CHECK goes to it after the check of error,
+// operators that can't fail skip it
+#if EXP_THREADED_DISPATCH
+// handler of each opcode in order of OpCode, the rare binary operators share one
+#    define EXP_DISPATCH_BEGIN()                                                         \
+        static void *const handlers[] = {                                                \
+            &&op_PushValue, &&op_PushVar, &&op_Call,   &&op_CallSqrt, &&op_Invert,       \
+            &&op_Neg,       &&op_Store,   &&op_Load,   &&op_Binary,   &&op_Mul,          \
+            &&op_Binary,    &&op_Binary,  &&op_Binary, &&op_Add,      &&op_Sub,          \
+            &&op_Binary,    &&op_Binary,  &&op_Binary, &&op_Binary,   &&op_Binary,       \
+            &&op_Binary                                                                  \
+        };                                                                               \
+        static_assert(sizeof(handlers) / sizeof(handlers[0]) ==                          \
+                          static_cast<size_t>(OpCode::Nil) + 1,                          \
+                      "every opcode needs a handler");                                   \
+        if (ip == end) goto finish;                                                      \
+        goto *handlers[static_cast<size_t>(ip->code)];
+#    define EXP_DISPATCH_END() finish:
+#    define EXP_OP(name) op_##name:
+#    define EXP_BINARY_OP op_Binary:
+#    define EXP_NEXT()                \
+        if (++ip == end) goto finish; \
+        goto *handlers[static_cast<size_t>(ip->code)]
+#else
+#    define EXP_DISPATCH_BEGIN() \
+        for (; ip != end;) {     \
+            switch (ip->code) {
+#    define EXP_DISPATCH_END() \
+        }                      \
+        }
+#    define EXP_OP(name) case OpCode::name:
+#    define EXP_BINARY_OP default:
+#    define EXP_NEXT() \
+        ++ip;          \
+        continue
+#endif // EXP_THREADED_DISPATCH
+#define EXP_CHECK()                                              \
+    if (error != ValueError::None) {                             \
+        errors.Add(ErrorCode::CalculationAborted, -1, 0, error); \
+        return false;                                            \
+    }                                                            \
+    EXP_NEXT()
+
+/**
+ * @brief evaluator of a compiled program in number type T, the type is fixed at
+ *        compile time, so the loop over instructions has no branch on it
+ * @tparam T      number type, like double, float, int64_t or Value
+ * @tparam Policy arithmetic of T, see NumericPolicy
+ * @note literals of program are converted to T once, so a program folded to a
+ *       fraction like 1/2 can't be evaluated in int64_t
+ */
+template <typename T, typename Policy = NumericPolicy<T>>
+class TypedEvaluator {
+public:
+    // program must be valid to be evaluated and outlive the evaluator
+    explicit TypedEvaluator(const CompiledExpression &program) : program(program) {
+        ValueError error = ValueError::None;
+        literals.reserve(program.literals.size());
+        for (const auto &literal : program.literals) {
+            literals.push_back(Policy::FromValue(literal, error));
+        }
+        if (!program.IsValid()) {
+            errors.Add(ErrorCode::InvalidExpression);
+        } else if (error != ValueError::None) {
+            errors.Add(ErrorCode::ValueFailure, -1, 0, error);
+        }
+        valid = errors.Empty();
+    }
+    // program is kept by reference, a temporary one would dangle
+    explicit TypedEvaluator(CompiledExpression &&) = delete;
+
+    // Whether program is valid and its literals are representable in T
+    bool IsValid() const { return valid; }
+
+    // Count of values Evaluate needs, values[handle] is value of variable
+    size_t GetVariableCount() const { return program.variableCount; }
+
+    /**
+     * @brief evaluate program with values of variables
+     * @param values values[handle] is value of variable of handle from ExpSolver
+     * @param result result of output, not changed for fail
+     * @return false for fail, use GetErrorMessages() get fail reason
+     */
+    bool Evaluate(const std::vector<T> &values, T &result) {
+        errors.Clear();
+        if (!valid) {
+            errors.Add(ErrorCode::InvalidExpression);
+            return false;
+        }
+        if (program.variableCount > values.size()) {
+            errors.Add(ErrorCode::ContextMissesVariables);
+            return false;
+        }
+        return Execute(program, literals.data(), values.data(), stack, temps, errors, result);
+    }
+
+    // Text of errors of the latest call
+    std::string GetErrorMessages() const { return errors.Render(std::string()); }
+
+    const std::vector<ErrorRecord> &GetErrors() const { return errors.GetRecords(); }
+
+private:
+    friend class EvalContext;
+
+    // Value of variable in slot as T, from values in T or in Value
+    static T Load(const T *values, int32_t slot, ValueError &) { return values[slot]; }
+    static T Load(const std::vector<Value> &values, int32_t slot, ValueError &error) {
+        return Policy::FromValue(values[slot], error);
+    }
+    static T Load(const SymbolTable<Variable> &variables, int32_t slot, ValueError &error) {
+        return Policy::FromValue(variables[slot].value, error);
+    }
+
+    /**
+     * @brief run program, stack and temps are reused between runs, a program with a
+     *        register form runs it in stack as frame
+     * @param literals  literals of program as T
+     * @param variables values of variables, in T or in Value
+     * @return false for fail with reason added to errors
+     */
+    template <typename Variables>
+    static bool Execute(const CompiledExpression &program, const T *literals,
+                        const Variables &variables, std::vector<T> &stack, std::vector<T> &temps,
+                        ErrorList &errors, T &result) {
+        if (program.frameSize != 0) {
+            return ExecuteRegisters(program, literals, variables, stack, errors, result);
+        }
+        if (stack.size() < program.stackDepth) stack.resize(program.stackDepth);
+        if (temps.size() < program.tempCount) temps.resize(program.tempCount);
+        // top is the count of values, stack is sized by depth of program
+        size_t             top   = 0;
+        ValueError         error = ValueError::None;
+        const Instruction *ip    = program.code.data();
+        const Instruction *end   = ip + program.code.size();
+
+        EXP_DISPATCH_BEGIN()
+        EXP_OP(Store) temps[ip->arg] = stack[top - 1];
+        EXP_NEXT();
+        EXP_OP(Load) stack[top++] = temps[ip->arg];
+        EXP_NEXT();
+        EXP_OP(PushValue) stack[top++] = literals[ip->arg];
+        EXP_NEXT();
+        EXP_OP(PushVar) stack[top++] = Load(variables, ip->arg, error);
+        if (error != ValueError::None) {
+            errors.Add(ErrorCode::ValueFailure, -1, 0, error);
+            return false;
+        }
+        EXP_NEXT();
+        EXP_OP(CallSqrt)
+        EXP_OP(Call)
+        if (ip->code == OpCode::CallSqrt && Policy::IsNegative(stack[top - 1])) {
+            errors.Add(ErrorCode::NegativeSqrt);
+            return false;
+        }
+        stack[top - 1] = Policy::Call(program.functions[ip->arg].func, stack[top - 1], error);
+        if (error != ValueError::None) {
+            errors.Add(ErrorCode::ValueFailure, -1, 0, error);
+            return false;
+        }
+        EXP_NEXT();
+        EXP_OP(Invert) stack[top - 1] = Policy::Invert(stack[top - 1], error);
+        EXP_CHECK();
+        EXP_OP(Neg) stack[top - 1] = Policy::Negate(stack[top - 1], error);
+        EXP_CHECK();
+        // constant code, so the common operators are inlined from Policy::Apply,
+        // left operand is on top
+        EXP_OP(Add) top--;
+        stack[top - 1] = Policy::Apply(OpCode::Add, stack[top], stack[top - 1], error);
+        EXP_CHECK();
+        EXP_OP(Sub) top--;
+        stack[top - 1] = Policy::Apply(OpCode::Sub, stack[top], stack[top - 1], error);
+        EXP_CHECK();
+        EXP_OP(Mul) top--;
+        stack[top - 1] = Policy::Apply(OpCode::Mul, stack[top], stack[top - 1], error);
+        EXP_CHECK();
+        EXP_BINARY_OP top--;
+        stack[top - 1] = Policy::Apply(ip->code, stack[top], stack[top - 1], error);
+        EXP_CHECK();
+        EXP_DISPATCH_END()
+        return Finish(stack[0], errors, result);
+    }
+
+    // Same as Execute on register form of program, frame is literals, loaded
+    // variables and registers, each instruction reads and writes fixed slots
+    template <typename Variables>
+    static bool ExecuteRegisters(const CompiledExpression &program, const T *literals,
+                                 const Variables &variables, std::vector<T> &frame,
+                                 ErrorList &errors, T &result) {
+        if (frame.size() < program.frameSize) frame.resize(program.frameSize);
+        ValueError error = ValueError::None;
+        std::copy(literals, literals + program.literals.size(), frame.begin());
+        auto *loaded = frame.data() + program.literals.size();
+        for (auto slot : program.loads) {
+            *loaded++ = Load(variables, slot, error);
+            if (error != ValueError::None) {
+                errors.Add(ErrorCode::ValueFailure, -1, 0, error);
+                return false;
+            }
+        }
+        T                         *slots = frame.data();
+        const RegisterInstruction *ip    = program.registerCode.data();
+        const RegisterInstruction *end   = ip + program.registerCode.size();
+
+        EXP_DISPATCH_BEGIN()
+        EXP_OP(CallSqrt)
+        EXP_OP(Call)
+        if (ip->code == OpCode::CallSqrt && Policy::IsNegative(slots[ip->left])) {
+            errors.Add(ErrorCode::NegativeSqrt);
+            return false;
+        }
+        slots[ip->dst] = Policy::Call(program.functions[ip->arg].func, slots[ip->left], error);
+        if (error != ValueError::None) {
+            errors.Add(ErrorCode::ValueFailure, -1, 0, error);
+            return false;
+        }
+        EXP_NEXT();
+        EXP_OP(Invert) slots[ip->dst] = Policy::Invert(slots[ip->left], error);
+        EXP_CHECK();
+        EXP_OP(Neg) slots[ip->dst] = Policy::Negate(slots[ip->left], error);
+        EXP_CHECK();
+        EXP_OP(Add)
+        slots[ip->dst] = Policy::Apply(OpCode::Add, slots[ip->left], slots[ip->right], error);
+        EXP_CHECK();
+        EXP_OP(Sub)
+        slots[ip->dst] = Policy::Apply(OpCode::Sub, slots[ip->left], slots[ip->right], error);
+        EXP_CHECK();
+        EXP_OP(Mul)
+        slots[ip->dst] = Policy::Apply(OpCode::Mul, slots[ip->left], slots[ip->right], error);
+        EXP_CHECK();
+        // stack instructions are not in register programs
+        EXP_OP(PushValue)
+        EXP_OP(PushVar)
+        EXP_OP(Store)
+        EXP_OP(Load)
+        EXP_BINARY_OP
+        slots[ip->dst] = Policy::Apply(ip->code, slots[ip->left], slots[ip->right], error);
+        EXP_CHECK();
+        EXP_DISPATCH_END()
+        return Finish(slots[program.resultSlot], errors, result);
+    }
+
+    // Check result of run, number carrying its own error, like Value, is checked once
+    static bool Finish(const T &value, ErrorList &errors, T &result) {
+        auto error = Policy::ErrorOf(value);
+        if (error != ValueError::None) {
+            errors.Add(ErrorCode::CalculationAborted, -1, 0, error);
+            return false;
+        }
+        result = value;
+        return true;
+    }
+
+    const CompiledExpression &program;
+    std::vector<T>            literals;
+    std::vector<T>            stack;
+    // shared subexpressions
+    std::vector<T> temps;
+    ErrorList      errors;
+    bool           valid{ false };
+};
+
+#undef EXP_DISPATCH_BEGIN
+#undef EXP_DISPATCH_END
+#undef EXP_OP
+#undef EXP_BINARY_OP
+#undef EXP_NEXT
+#undef EXP_CHECK
+} // namespace exp_solver
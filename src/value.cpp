@@ -15,51 +15,16 @@ Description: Implementation of Value Class.
 #include <iomanip>
 
 #include "value.h"
+#include "int_math.h"
 
 namespace exp_solver
 {
 using std::string;
 
-// Function to implement
-// Stein's Algorithm
-static int64_t gcd(int64_t a, int64_t b) {
-    /* GCD(0, b) == b; GCD(a, 0) == a,
-       GCD(0, 0) == 0 */
-    if (a == 0) return b;
-    if (b == 0) return a;
-
-    /*Finding K, where K is the
-      greatest power of 2
-      that divides both a and b. */
-    int64_t k{};
-    for (k = 0; ((a | b) & 1) == 0; ++k) {
-        a >>= 1;
-        b >>= 1;
-    }
-
-    /* Dividing a by 2 until a becomes odd */
-    while ((a & 1) == 0) a >>= 1;
-
-    /* From here on, 'a' is always odd. */
-    do {
-        /* If b is even, remove all factor of 2 in b */
-        while ((b & 1) == 0) b >>= 1;
-
-        /* Now a and b are both odd.
-           Swap if necessary so a <= b,
-           then set b = b - a (which is even).*/
-        if (a > b) std::swap(a, b); // Swap u and v.
-
-        b = (b - a);
-    } while (b != 0);
-
-    /* restore common factors of 2 */
-    return a << k;
-}
-
 Fraction::Fraction(int64_t u, int64_t d) : up(u), down(d) {
-    auto k = gcd(std::abs(u), std::abs(d));
-    if (k != 1) {
+    auto k = static_cast<int64_t>(BinaryGcd(UnsignedAbs(u), UnsignedAbs(d)));
+    // k is 0 only for 0/0, left for fractionInit to reject
+    if (k > 1) {
         // Ensure that GCD(up,down)=1
         up /= k;
         down /= k;
@@ -68,29 +33,26 @@ Fraction::Fraction(int64_t u, int64_t d) : up(u), down(d) {
 
 void Value::fractionInit(const Fraction &fv) {
     if (fv.down == 0) {
-        error_messages += "Arithmetic error: Denominator is zero! ";
+        error = ValueError::DenominatorZero;
         return;
     }
-    isDecimal     = false;
-    fracValue     = fv;
-    decValue      = (double)fv.up / fv.down;
-    calculability = true;
-    isInterger    = (fv.down == 1 || fv.up == 0);
+    kind       = Kind::Fraction;
+    up         = fv.up;
+    down       = fv.down;
+    isInterger = (fv.down == 1 || fv.up == 0);
 }
 
 void Value::doubleInit(double dv) {
-    if (dv == (double)int64_t(dv)) {
-        isInterger     = true;
-        fracValue.up   = (int64_t)dv;
-        fracValue.down = 1;
-        decValue       = dv;
-        calculability  = true;
+    // cast is only defined in range of int64_t, INT64_MIN is kept out to be negatable
+    if (dv > -9223372036854775808.0 && dv < 9223372036854775808.0 && dv == (double)int64_t(dv)) {
+        kind       = Kind::Fraction;
+        isInterger = true;
+        up         = (int64_t)dv;
+        down       = 1;
         return;
     }
-    isDecimal     = true;
-    fracValue     = Fraction();
-    decValue      = dv;
-    calculability = true;
+    kind     = Kind::Decimal;
+    decValue = dv;
 }
 
 Value::Value(Fraction fv) {
@@ -117,7 +79,7 @@ Value::Value(const string &str) {
         auto right = str.substr(found + 1);
 
         if (left.length() >= 15) {
-            error_messages += "Arithmetic error: Number too large! ";
+            error = ValueError::NumberTooLarge;
             return;
         }
 
@@ -150,14 +112,14 @@ Value::Value(const string &str) {
 
             auto [ptr, ec] = std::from_chars(left.data(), left.data() + left.size(), num);
             if (ec != std::errc()) {
-                error_messages += "Arithmetic Error: Number too large! ";
+                error = ValueError::NumberTooLarge;
                 return;
             }
 #else
             try {
                 num = std::stol(left);
             } catch (...) {
-                error_messages += "Arithmetic Error: Convert to number fail! ";
+                error = ValueError::ConvertFail;
                 return;
             }
 #endif
@@ -166,7 +128,7 @@ Value::Value(const string &str) {
             return;
         } else if (left.length() + right.length() <= 8) { // use fraction
             if (right.find('.') != string::npos) {
-                error_messages += "Arithmetic Error: More than one '.' in a number! ";
+                error = ValueError::MultipleDots;
                 return;
             }
 
@@ -176,7 +138,7 @@ Value::Value(const string &str) {
             {
                 auto [_, ec] = std::from_chars(left.data(), left.data() + left.size(), leftNumber);
                 if (ec != std::errc()) {
-                    error_messages += "Arithmetic Error: Convert to number fail! ";
+                    error = ValueError::ConvertFail;
                     return;
                 }
             }
@@ -184,7 +146,7 @@ Value::Value(const string &str) {
                 auto [_, ec] =
                     std::from_chars(right.data(), right.data() + right.size(), rightNumber);
                 if (ec != std::errc()) {
-                    error_messages += "Arithmetic Error: Convert to number fail! ";
+                    error = ValueError::ConvertFail;
                     return;
                 }
             }
@@ -193,7 +155,7 @@ Value::Value(const string &str) {
                 leftNumber  = stol(left);
                 rightNumber = stol(right);
             } catch (...) {
-                error_messages += "Arithmetic Error: Convert to number fail! ";
+                error = ValueError::ConvertFail;
                 return;
             }
 #endif
@@ -213,7 +175,7 @@ Value::Value(const string &str) {
                 value = stod(str);
 #endif
             } catch (...) {
-                error_messages += "Arithmetic Error: Convert to number fail! ";
+                error = ValueError::ConvertFail;
                 return;
             }
 
@@ -227,7 +189,7 @@ Value::Value(const string &str) {
 #ifdef EXP_HAS_STRING_VIEW
     auto [_, ec] = std::from_chars(str.data(), str.data() + str.size(), num);
     if (ec != std::errc()) {
-        error_messages += "Arithmetic Error: Convert to number fail! ";
+        error = ValueError::ConvertFail;
         return;
     }
 #else
@@ -235,34 +197,105 @@ Value::Value(const string &str) {
     try {
         num = stol(str);
     } catch (...) {
-        error_messages += "Arithmetic Error: Convert to number fail! ";
+        error = ValueError::ConvertFail;
         return;
     }
 #endif
     fractionInit(Fraction(num, 1));
 }
 
-std::string Value::GetErrorMessage() const {
-    return error_messages;
+const char *GetValueErrorText(ValueError error) {
+    switch (error) {
+        case ValueError::None: return "";
+        case ValueError::DenominatorZero: return "Arithmetic error: Denominator is zero! ";
+        case ValueError::NumberTooLarge: return "Arithmetic error: Number too large! ";
+        case ValueError::ConvertFail: return "Arithmetic Error: Convert to number fail! ";
+        case ValueError::MultipleDots: return "Arithmetic Error: More than one '.' in a number! ";
+        case ValueError::ModFloat: return "Arithmetic error: Can't mod with float number";
+        case ValueError::ModZero: return "Arithmetic error: Modulo by zero! ";
+        case ValueError::LeftShiftFloat:
+            return "Arithmetic error: Can't left shift with float number or negative number";
+        case ValueError::RightShiftFloat:
+            return "Arithmetic error: Can't right shift with float number or negative number";
+        case ValueError::AndFloat: return "Arithmetic error: Can't and with float number";
+        case ValueError::OrFloat: return "Arithmetic error: Can't or with float number";
+        case ValueError::XorFloat: return "Arithmetic error: Can't xor with float number";
+        case ValueError::InvertFloat: return "Arithmetic error: Can't negate with float number";
+        case ValueError::NegativePower:
+            return "Arithmetic error: Can't power a negative number by a non-integer! ";
+        case ValueError::InvalidOperator: return "Invalid operator";
+    }
+    return "";
+}
+
+Value Value::Failure(ValueError error) {
+    Value temp{};
+    temp.error = error;
+    return temp;
+}
+
+int64_t Value::GetInteger() const {
+    if (kind == Kind::Decimal) return (int64_t)decValue;
+    return down == 1 ? up : up / down;
+}
+
+// Below it up * down, up * up and their sums can't overflow int64_t
+static constexpr uint64_t lazy_limit = uint64_t(1) << 31;
+
+Value Value::Lazy(int64_t up, int64_t down) {
+    if (down == 0 || UnsignedAbs(up) >= lazy_limit || UnsignedAbs(down) >= lazy_limit) {
+        return Value(Fraction(up, down));
+    }
+    // 0 reduces to 0/1 or 0/-1
+    if (up == 0) down = down > 0 ? 1 : -1;
+    Value temp{};
+    temp.kind       = Kind::Fraction;
+    temp.up         = up;
+    temp.down       = down;
+    temp.isInterger = (down == 1 || up == 0);
+    temp.reduced    = temp.isInterger;
+    return temp;
+}
+
+Value Value::Reduced() const {
+    if (reduced) return *this;
+    return Value(Fraction(up, down));
+}
+
+bool Value::IsIntegral() const {
+    if (isInterger || kind != Kind::Fraction || reduced) return isInterger;
+    // same as down of reduced fraction being 1
+    return down > 0 && up % down == 0;
+}
+
+ValueError Value::GetError() const {
+    return error;
 }
 
 bool Value::IsDecimal() const {
-    return isDecimal;
+    return kind == Kind::Decimal;
 }
 
 Fraction Value::GetFracValue() const {
-    return fracValue;
+    Fraction fraction;
+    if (kind == Kind::Fraction) {
+        if (!reduced) return Fraction(up, down);
+        fraction.up   = up;
+        fraction.down = down;
+    }
+    return fraction;
 }
 
 bool Value::IsCalculable() const {
-    return calculability;
+    return kind != Kind::Invalid;
 }
 
 string Value::GetValueStr() const {
-    if (!calculability) return "";
-    if (!isDecimal && (fracValue.down == 1 || fracValue.up == 0)) {
-        return std::to_string(fracValue.up);
+    if (kind == Kind::Invalid) return "";
+    if (kind == Kind::Fraction && IsIntegral()) {
+        return std::to_string(GetInteger());
     } else {
+        auto               decValue = GetValueDouble();
         std::ostringstream oss;
         auto               precision = floor((log10(decValue))) + 7;
         if (std::isnan(precision)) {
@@ -277,62 +310,13 @@ string Value::GetValueStr() const {
 }
 
 double Value::GetValueDouble() const {
-    return decValue;
-}
-
-#ifdef EXP_HAS_STRING_VIEW
-Value &Value::operate(const std::string &op, const Value &b) {
-    return operate(std::string_view{ op }, b);
-}
-#endif
-
-#ifdef EXP_HAS_STRING_VIEW
-Value &Value::operate(std::string_view op, const Value &b) {
-#else
-Value &Value::operate(const std::string &op, const Value &b) {
-#endif
-
-#if EXP_SOLVER_DEBUG
-    std::cout << "value: a:" << decValue << " " << op << " b:" << b.decValue << std::endl;
-#endif // EXP_SOLVER_DEBUG
-
-    if (op == "**") {
-        this->powv(b);
-    } else if (op == "*") {
-        *this *= b;
-    } else if (op == "/") {
-        *this /= b;
-    } else if (op == "//") {
-        *this = Value(floor((*this / b).decValue));
-    } else if (op == "%") {
-        *this %= b;
-    } else if (op == "+") {
-        *this += b;
-    } else if (op == "-") {
-        *this -= b;
-    } else if (op == "<<") {
-        *this <<= b;
-    } else if (op == ">>") {
-        *this >>= b;
-    } else if (op == "&") {
-        *this &= b;
-    } else if (op == "^") {
-        *this ^= b;
-    } else if (op == "|") {
-        *this |= b;
-    } else {
-        *this          = Value();
-        error_messages = "Invalid operator: " + std::string{ op };
+    switch (kind) {
+        case Kind::Fraction: return (double)up / down;
+        case Kind::Decimal: return decValue;
+        default: return 0;
     }
-
-#if EXP_SOLVER_DEBUG
-    std::cout << "result: " << decValue << std::endl;
-#endif // EXP_SOLVER_DEBUG
-
-    return *this;
 }
 
-
 Value &Value::operator+=(const Value &z) {
     *this = *this + z;
     return *this;
@@ -389,103 +373,199 @@ Value &Value::powv(const Value &z) {
 }
 
 
+#ifdef __SIZEOF_INT128__
+using wide_int = __int128;
+
+static wide_int WideGcd(wide_int a, wide_int b) {
+    if (a < 0) a = -a;
+    if (b < 0) b = -b;
+    while (b != 0) {
+        auto r = a % b;
+        a      = b;
+        b      = r;
+    }
+    return a;
+}
+
+// Result of up/down that overflowed int64_t, exact if it fits after reducing,
+// otherwise the nearest double
+#    if defined(__GNUC__) || defined(__clang__)
+__attribute__((noinline, cold))
+#    endif
+static Value
+WideFraction(wide_int up, wide_int down) {
+    if (down == 0) return Value(Fraction(0, 0));
+    if (down < 0) {
+        up   = -up;
+        down = -down;
+    }
+    auto k = WideGcd(up, down);
+    up /= k;
+    down /= k;
+    if (up > INT64_MIN && up <= INT64_MAX && down <= INT64_MAX) {
+        return Value(Fraction(static_cast<int64_t>(up), static_cast<int64_t>(down)));
+    }
+    return Value(static_cast<double>(up) / static_cast<double>(down));
+}
+#endif
+
+// a.up/a.down * b.up/b.down that overflowed int64_t
+static Value WideMul(int64_t aUp, int64_t aDown, int64_t bUp, int64_t bDown) {
+#ifdef __SIZEOF_INT128__
+    return WideFraction(static_cast<wide_int>(aUp) * bUp, static_cast<wide_int>(aDown) * bDown);
+#else
+    return Value((static_cast<double>(aUp) * bUp) / (static_cast<double>(aDown) * bDown));
+#endif
+}
+
+// a.up/a.down + sign * b.up/b.down that overflowed int64_t
+static Value WideAdd(int64_t aUp, int64_t aDown, int64_t bUp, int64_t bDown, int sign) {
+#ifdef __SIZEOF_INT128__
+    return WideFraction(static_cast<wide_int>(aUp) * bDown + sign * static_cast<wide_int>(bUp) * aDown,
+                        static_cast<wide_int>(aDown) * bDown);
+#else
+    return Value(static_cast<double>(aUp) / aDown + sign * (static_cast<double>(bUp) / bDown));
+#endif
+}
+
+// base ** exponent, false on overflow
+static bool CheckedPow(int64_t base, uint64_t exponent, int64_t &out) {
+    int64_t result = 1;
+    while (exponent != 0) {
+        if ((exponent & 1) && MulOverflow(result, base, result)) return false;
+        exponent >>= 1;
+        if (exponent != 0 && MulOverflow(base, base, base)) return false;
+    }
+    out = result;
+    return true;
+}
+
+// Return the not calculable one of a and b, keep its error
+#define RETURN_IF_NOT_CALCULABLE(a, b)   \
+    if (!(a).IsCalculable()) return (a); \
+    if (!(b).IsCalculable()) return (b);
+
 Value operator+(const Value &a, const Value &b) {
-    if (!a.calculability || !b.calculability) { return {}; }
-    if (a.isDecimal || b.isDecimal) {
-        return Value(a.decValue + b.decValue);
-    } else {
-        return Value(Fraction(a.fracValue.up * b.fracValue.down + a.fracValue.down * b.fracValue.up,
-                              b.fracValue.down * a.fracValue.down));
+    RETURN_IF_NOT_CALCULABLE(a, b);
+    if (a.IsDecimal() || b.IsDecimal()) {
+        return Value(a.GetValueDouble() + b.GetValueDouble());
     }
+    int64_t left, right, up, down;
+    // same positive denominator keeps it, like cents added to cents
+    if (a.down == b.down && a.down > 0 && !AddOverflow(a.up, b.up, up)) {
+        return Value::Lazy(up, a.down);
+    }
+    if (MulOverflow(a.up, b.down, left) || MulOverflow(a.down, b.up, right)
+        || AddOverflow(left, right, up) || MulOverflow(a.down, b.down, down)) {
+        // reduce skipped factors before going wide
+        if (!a.reduced || !b.reduced) return a.Reduced() + b.Reduced();
+        return WideAdd(a.up, a.down, b.up, b.down, 1);
+    }
+    return Value::Lazy(up, down);
 }
 
 Value operator-(const Value &a, const Value &b) {
-    if (!a.calculability || !b.calculability) { return {}; }
-    if (a.isDecimal || b.isDecimal) {
-        return Value(a.decValue - b.decValue);
-    } else {
-        return Value(Fraction(a.fracValue.up * b.fracValue.down - a.fracValue.down * b.fracValue.up,
-                              b.fracValue.down * a.fracValue.down));
+    RETURN_IF_NOT_CALCULABLE(a, b);
+    if (a.IsDecimal() || b.IsDecimal()) {
+        return Value(a.GetValueDouble() - b.GetValueDouble());
+    }
+    int64_t left, right, up, down;
+    if (a.down == b.down && a.down > 0 && !AddOverflow(a.up, -b.up, up)) {
+        return Value::Lazy(up, a.down);
+    }
+    if (MulOverflow(a.up, b.down, left) || MulOverflow(a.down, b.up, right)
+        || AddOverflow(left, -right, up) || MulOverflow(a.down, b.down, down)) {
+        if (!a.reduced || !b.reduced) return a.Reduced() - b.Reduced();
+        return WideAdd(a.up, a.down, b.up, b.down, -1);
     }
+    return Value::Lazy(up, down);
 }
 
 Value operator*(const Value &a, const Value &b) {
-    if (!a.calculability || !b.calculability) { return {}; }
-    if (a.isDecimal || b.isDecimal) {
-        return Value(a.decValue * b.decValue);
-    } else {
-        return Value(
-            Fraction(b.fracValue.up * a.fracValue.up, b.fracValue.down * a.fracValue.down));
+    RETURN_IF_NOT_CALCULABLE(a, b);
+    if (a.IsDecimal() || b.IsDecimal()) {
+        return Value(a.GetValueDouble() * b.GetValueDouble());
+    }
+    int64_t up, down;
+    if (MulOverflow(a.up, b.up, up) || MulOverflow(a.down, b.down, down)) {
+        if (!a.reduced || !b.reduced) return a.Reduced() * b.Reduced();
+        return WideMul(a.up, a.down, b.up, b.down);
     }
+    return Value::Lazy(up, down);
 }
 
 Value operator/(const Value &a, const Value &b) {
-    if (!a.calculability || !b.IsCalculable()) { return {}; }
-    if (a.isDecimal || b.isDecimal) {
-        return Value(a.decValue / b.decValue);
-    } else {
-        return Value(
-            Fraction(b.fracValue.down * a.fracValue.up, b.fracValue.up * a.fracValue.down));
+    RETURN_IF_NOT_CALCULABLE(a, b);
+    if (a.IsDecimal() || b.IsDecimal()) {
+        return Value(a.GetValueDouble() / b.GetValueDouble());
     }
+    int64_t up, down;
+    if (MulOverflow(a.up, b.down, up) || MulOverflow(a.down, b.up, down)) {
+        if (!a.reduced || !b.reduced) return a.Reduced() / b.Reduced();
+        return WideMul(a.up, a.down, b.down, b.up);
+    }
+    return Value::Lazy(up, down);
 }
 
 Value operator%(const Value &a, const Value &b) {
-    if (!a.calculability || !b.calculability) { return {}; }
+    RETURN_IF_NOT_CALCULABLE(a, b);
     // must both be interger
-    if (a.isInterger && b.isInterger) { return Value((int64_t)a.decValue % (int64_t)b.decValue); }
-    Value temp{};
-    temp.error_messages = "Arithmetic error: Can't mod with float number";
-    return temp;
+    if (a.IsIntegral() && b.IsIntegral()) {
+        auto divisor = b.GetInteger();
+        if (divisor == 0) return Value::Failure(ValueError::ModZero);
+        // INT64_MIN % -1 traps
+        if (divisor == -1) return Value(0);
+        return Value(a.GetInteger() % divisor);
+    }
+    return Value::Failure(ValueError::ModFloat);
 }
 
 Value operator<<(const Value &a, const Value &b) {
-    if (!a.calculability || !b.calculability) { return {}; }
+    RETURN_IF_NOT_CALCULABLE(a, b);
     // must both be interger
-    if (a.isInterger && b.isInterger && b.decValue >= 0) {
-        return Value((int64_t)a.decValue << (int64_t)b.decValue);
+    if (a.IsIntegral() && b.IsIntegral() && b.GetInteger() >= 0) {
+        auto value = a.GetInteger();
+        auto shift = b.GetInteger();
+        // shift as unsigned, left shift of negative number is undefined
+        auto shifted = shift < 63 ? static_cast<int64_t>(static_cast<uint64_t>(value) << shift) : 0;
+        // bits shifted out, continue in double
+        if (shift >= 63 || (shifted >> shift) != value) {
+            return Value(std::ldexp(static_cast<double>(value), shift < 2000 ? shift : 2000));
+        }
+        return Value(shifted);
     }
-    Value temp{};
-    temp.error_messages = "Arithmetic error: Can't left shift with float number or negative number";
-    return temp;
+    return Value::Failure(ValueError::LeftShiftFloat);
 }
 
 Value operator>>(const Value &a, const Value &b) {
-    if (!a.calculability || !b.calculability) { return {}; }
+    RETURN_IF_NOT_CALCULABLE(a, b);
     // must both be interger
-    if (a.isInterger && b.isInterger && b.decValue >= 0) {
-        return Value((int64_t)a.decValue >> (int64_t)b.decValue);
+    if (a.IsIntegral() && b.IsIntegral() && b.GetInteger() >= 0) {
+        auto shift = b.GetInteger();
+        return Value(a.GetInteger() >> (shift < 63 ? shift : 63));
     }
-    Value temp{};
-    temp.error_messages =
-        "Arithmetic error: Can't right shift with float number or negative number";
-    return temp;
+    return Value::Failure(ValueError::RightShiftFloat);
 }
 
 Value operator&(const Value &a, const Value &b) {
-    if (!a.calculability || !b.calculability) { return {}; }
+    RETURN_IF_NOT_CALCULABLE(a, b);
     // must both be interger
-    if (a.isInterger && b.isInterger) { return Value((int64_t)a.decValue & (int64_t)b.decValue); }
-    Value temp{};
-    temp.error_messages = "Arithmetic error: Can't and with float number";
-    return temp;
+    if (a.IsIntegral() && b.IsIntegral()) { return Value(a.GetInteger() & b.GetInteger()); }
+    return Value::Failure(ValueError::AndFloat);
 }
 
 Value operator|(const Value &a, const Value &b) {
-    if (!a.calculability || !b.calculability) { return {}; }
+    RETURN_IF_NOT_CALCULABLE(a, b);
     // must both be interger
-    if (a.isInterger && b.isInterger) { return Value((int64_t)a.decValue | (int64_t)b.decValue); }
-    Value temp{};
-    temp.error_messages = "Arithmetic error: Can't or with float number";
-    return temp;
+    if (a.IsIntegral() && b.IsIntegral()) { return Value(a.GetInteger() | b.GetInteger()); }
+    return Value::Failure(ValueError::OrFloat);
 }
 
 Value operator^(const Value &a, const Value &b) {
-    if (!a.calculability || !b.calculability) { return {}; }
+    RETURN_IF_NOT_CALCULABLE(a, b);
     // must both be interger
-    if (a.isInterger && b.isInterger) { return Value((int64_t)a.decValue ^ (int64_t)b.decValue); }
-    Value temp{};
-    temp.error_messages = "Arithmetic error: Can't xor with float number";
-    return temp;
+    if (a.IsIntegral() && b.IsIntegral()) { return Value(a.GetInteger() ^ b.GetInteger()); }
+    return Value::Failure(ValueError::XorFloat);
 }
 
 Value operator-(const Value &a) {
@@ -493,40 +573,37 @@ Value operator-(const Value &a) {
 }
 
 Value operator~(const Value &a) {
-    if (a.isInterger) { return Value((double)~(int64_t)a.decValue); }
-    Value temp{};
-    temp.error_messages = "Arithmetic error: Can't negate with float number";
-    return temp;
+    if (!a.IsCalculable()) return a;
+    if (a.IsIntegral()) { return Value((double)~a.GetInteger()); }
+    return Value::Failure(ValueError::InvertFloat);
 }
 
 Value powv(const Value &a, const Value &b) {
-    if (!a.calculability || !b.calculability) { return {}; }
-    if (a.decValue < 0 && !b.isInterger) {
-        Value temp{};
-        temp.error_messages += "Arithmetic error: Can't power a negative number by a non-integer! ";
-        return temp;
+    RETURN_IF_NOT_CALCULABLE(a, b);
+    auto integral = b.IsIntegral();
+    if (a.GetValueDouble() < 0 && !integral) {
+        return Value::Failure(ValueError::NegativePower);
     }
-    // b dec value is integer
-    if (!a.isDecimal && b.isInterger) {
-        Value res(a);
-        res.fracValue.up   = std::pow(a.fracValue.up, std::fabs(b.decValue));
-        res.fracValue.down = std::pow(a.fracValue.down, std::fabs(b.decValue));
-
-        if (b.decValue < 0) {
-            std::swap(res.fracValue.up, res.fracValue.down);
-            if (res.fracValue.down < 0) {
-                res.fracValue.up *= -1;
-                res.fracValue.down *= -1;
+    // exact power of fraction by integer, double once it overflows
+    auto exponent = b.GetValueDouble();
+    if (!a.IsDecimal() && integral && std::fabs(exponent) < 4294967296.0) {
+        auto    base  = a.Reduced();
+        auto    times = static_cast<uint64_t>(std::fabs(exponent));
+        int64_t up, down;
+        if (CheckedPow(base.up, times, up) && CheckedPow(base.down, times, down)) {
+            if (exponent >= 0) return Value(Fraction(up, down));
+            if (up < 0) {
+                up   = -up;
+                down = -down;
             }
+            return Value(Fraction(down, up));
         }
-        res.decValue   = (double)res.fracValue.up / res.fracValue.down;
-        res.isInterger = res.fracValue.up == 0 || res.fracValue.down == 1;
-        return res;
-    } else {
-        return Value(std::pow(a.decValue, b.decValue));
     }
+    return Value(std::pow(a.GetValueDouble(), exponent));
 }
 
+#undef RETURN_IF_NOT_CALCULABLE
+
 std::ostream &operator<<(std::ostream &out, const Value &m) {
     return out << m.GetValueStr();
 }
@@ -31,6 +31,32 @@ struct Fraction {
     Fraction &operator=(Fraction &&)      = default;
 };
 
+// Why a value is not calculable
+enum class ValueError : uint8_t {
+    None,
+    DenominatorZero,
+    NumberTooLarge,
+    ConvertFail,
+    MultipleDots,
+    ModFloat,
+    ModZero,
+    LeftShiftFloat,
+    RightShiftFloat,
+    AndFloat,
+    OrFloat,
+    XorFloat,
+    InvertFloat,
+    NegativePower,
+    InvalidOperator
+};
+
+// Human readable text of error
+const char *GetValueErrorText(ValueError error);
+
+/**
+ * @brief number kept as an exact fraction or a double, 24 bytes and
+ *        trivially copyable, so stacks of values can be copied by memcpy
+ */
 class Value {
 public:
     // Constructors
@@ -51,17 +77,17 @@ public:
     explicit Value(double dv);
 
     template <typename T, typename std::enable_if<std::is_integral<T>::value, T>::type* = nullptr>
-    inline Value(T dv) {         
-        isInterger    = true;
-        isDecimal     = true;
-        fracValue     = Fraction();
-        decValue      = static_cast<double>(dv);
-        calculability = true;
+    inline Value(T dv) {
+        isInterger = true;
+        kind       = Kind::Decimal;
+        decValue   = static_cast<double>(dv);
     }
 
     // Check properties
     bool IsDecimal() const;
     bool IsCalculable() const;
+    // Reason of not calculable, ValueError::None if calculable
+    ValueError GetError() const;
     // Getters
     Fraction    GetFracValue() const;
     std::string GetValueStr() const;
@@ -101,25 +127,46 @@ public:
 private:
     friend class ExpSolver;
 
-#if defined(EXP_HAS_STRING_VIEW)
-    Value &operate(std::string_view op, const Value &b);
-#endif
-
     void fractionInit(const Fraction &);
     void doubleInit(double);
 
-    Value &operate(const std::string &op, const Value &b);
-
-    std::string GetErrorMessage() const;
-
-    bool        isDecimal{ false };
-    bool        isInterger{ false };
-    Fraction    fracValue{};
-    double      decValue{ 0 };
-    bool        calculability{ false };
-    std::string error_messages;
+    // Not calculable value with reason
+    static Value Failure(ValueError error);
+
+    // Value of an integer, fraction or decimal
+    int64_t GetInteger() const;
+
+    /**
+     * @brief fraction result of arithmetic, reducing by gcd is skipped while up and
+     *        down are small enough that the next operation can't overflow, so a chain
+     *        of operations reduces only once in a while
+     */
+    static Value Lazy(int64_t up, int64_t down);
+
+    // Copy with fraction reduced, as Lazy skipped
+    Value Reduced() const;
+
+    // Whether value is an integer, checks unreduced fraction by division
+    bool IsIntegral() const;
+
+    enum class Kind : uint8_t { Invalid, Fraction, Decimal };
+
+    // numerator when kind is Fraction, value when kind is Decimal
+    union {
+        int64_t up{ 0 };
+        double  decValue;
+    };
+    int64_t    down{ 1 };
+    Kind       kind{ Kind::Invalid };
+    bool       isInterger{ false };
+    ValueError error{ ValueError::None };
+    // false if fraction may have a common factor of up and down
+    bool reduced{ true };
 };
 
+static_assert(sizeof(Value) <= 24, "Value should stay compact");
+static_assert(std::is_trivially_copyable<Value>::value, "Value should be copyable by memcpy");
+
 Value operator+(const Value &a, const Value &b);
 Value operator-(const Value &a, const Value &b);
 Value operator*(const Value &a, const Value &b);
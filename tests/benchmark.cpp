@@ -0,0 +1,570 @@
+/*
+
+benchmark.cpp
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Benchmarks of ExpSolver on large
+machine generated expressions.
+
+*/
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <functional>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <random>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#include "exp_solver.h"
+
+using namespace std::chrono;
+
+// Run func once and return used time in microseconds
+static double TimeUs(const std::function<void()> &func) {
+    auto now = steady_clock::now();
+    func();
+    return duration_cast<duration<double, std::micro>>(steady_clock::now() - now).count();
+}
+
+// "((((1))))" with depth brackets
+static std::string NestedBrackets(size_t depth) {
+    return std::string(depth, '(') + "1" + std::string(depth, ')');
+}
+
+// "(1)+(1)+...+(1)" with count groups
+static std::string SiblingBrackets(size_t count) {
+    std::string exp;
+    exp.reserve(count * 4);
+    for (size_t i = 0; i < count; i++) { exp += i == 0 ? "(1)" : "+(1)"; }
+    return exp;
+}
+
+static void BenchBrackets(const char *name, std::string (*make)(size_t), size_t maxSize) {
+    std::cout << name << std::endl;
+    std::cout << std::setw(10) << "size" << std::setw(14) << "solve us" << std::setw(14)
+              << "ns/bracket" << std::setw(14) << "compile us" << std::setw(14) << "ns/bracket"
+              << std::endl;
+    for (size_t size = maxSize / 8; size <= maxSize; size *= 2) {
+        exp_solver::ExpSolver solver;
+        auto                  exp = make(size);
+
+        exp_solver::Value result;
+        auto solveUs = TimeUs([&]() { result = solver.SolveExp(exp); });
+        if (!result.IsCalculable()) {
+            std::cout << "fail: " << solver.GetErrorMessages() << std::endl;
+            return;
+        }
+        auto compileUs = TimeUs([&]() { solver.Compile(exp); });
+        std::cout << std::setw(10) << size << std::setw(14) << std::fixed << std::setprecision(0)
+                  << solveUs << std::setw(14) << std::setprecision(1) << solveUs * 1000 / size
+                  << std::setw(14) << std::setprecision(0) << compileUs << std::setw(14)
+                  << std::setprecision(1) << compileUs * 1000 / size << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+// Update and solve with count variables bound
+static void BenchVariables(size_t count) {
+    exp_solver::ExpSolver solver;
+    std::string           exp;
+    for (size_t i = 0; i < count; i++) {
+        solver.UpdateVariable("var_" + std::to_string(i), static_cast<int>(i));
+        if (i % (count / 100) == 0) exp += (exp.empty() ? "var_" : "+var_") + std::to_string(i);
+    }
+
+    std::vector<std::string> names;
+    for (size_t i = 0; i < count; i++) names.push_back("var_" + std::to_string(i));
+    auto updateUs = TimeUs([&]() {
+        for (size_t i = 0; i < names.size(); i++) solver.UpdateVariable(names[i], 1);
+    });
+    std::vector<exp_solver::VariableHandle> handles;
+    for (auto &name : names) handles.push_back(solver.GetVariableHandle(name));
+    auto handleUs = TimeUs([&]() {
+        for (size_t i = 0; i < handles.size(); i++) solver.UpdateVariable(handles[i], 1);
+    });
+    auto solveUs  = TimeUs([&]() {
+        for (size_t i = 0; i < 1000; i++) solver.SolveExp(exp);
+    });
+    std::cout << count << " variables: " << std::fixed << std::setprecision(1)
+              << updateUs * 1000 / count << " ns/update, " << handleUs * 1000 / count
+              << " ns/update by handle, " << solveUs / 1000
+              << " us/solve of 100 variables" << std::endl
+              << std::endl;
+}
+
+// Evaluate one formula over rows, row by row and in batch
+static void BenchBatch(size_t rows) {
+    exp_solver::ExpSolver solver;
+    solver.UpdateVariable("x", 0);
+    solver.UpdateVariable("y", 0);
+    auto x       = solver.GetVariableHandle("x");
+    auto y       = solver.GetVariableHandle("y");
+    auto program = solver.Compile("(x*0.75+y)*(x-y)/(1+x*x)-y/3");
+
+    std::vector<double> xs(rows), ys(rows), output(rows);
+    for (size_t i = 0; i < rows; i++) {
+        xs[i] = static_cast<double>(i % 1000) * 0.5;
+        ys[i] = static_cast<double>(i % 77) - 30.25;
+    }
+    std::vector<const double *> columns(std::max(x, y) + 1);
+    columns[x] = xs.data();
+    columns[y] = ys.data();
+
+    auto rowUs = TimeUs([&]() {
+        for (size_t i = 0; i < rows; i++) {
+            solver.UpdateVariable(x, exp_solver::Value(xs[i]));
+            solver.UpdateVariable(y, exp_solver::Value(ys[i]));
+            output[i] = solver.Evaluate(program).GetValueDouble();
+        }
+    });
+    auto batchUs = TimeUs([&]() { solver.EvaluateBatch(program, columns, rows, output.data()); });
+    std::cout << rows << " rows: " << std::fixed << std::setprecision(1)
+              << rows / rowUs << " M rows/s by row, " << rows / batchUs << " M rows/s in batch"
+              << std::endl
+              << std::endl;
+}
+
+// Rows per second of batch evaluation for every supported SIMD level
+static void BenchSimd(size_t rows) {
+    using exp_solver::SimdLevel;
+    exp_solver::ExpSolver solver;
+    solver.UpdateVariable("x", 0);
+    solver.UpdateVariable("y", 0);
+    auto x       = solver.GetVariableHandle("x");
+    auto y       = solver.GetVariableHandle("y");
+    auto program = solver.Compile("(x*0.75+y)*(x-y)/(1+x*x)-sqrt(abs(y))+floor(x/3)");
+
+    std::vector<double> xs(rows), ys(rows), output(rows);
+    for (size_t i = 0; i < rows; i++) {
+        xs[i] = static_cast<double>(i % 1000) * 0.5;
+        ys[i] = static_cast<double>(i % 77) - 30.25;
+    }
+    std::vector<const double *> columns(std::max(x, y) + 1);
+    columns[x] = xs.data();
+    columns[y] = ys.data();
+
+    std::cout << "batch rows per ISA level" << std::endl;
+    for (auto level : { SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512 }) {
+        auto kernels = exp_solver::GetBatchKernels(level);
+        std::cout << std::setw(10) << exp_solver::SimdLevelName(level);
+        if (!kernels) {
+            std::cout << std::setw(14) << "unsupported" << std::endl;
+            continue;
+        }
+        exp_solver::BatchEvaluator evaluator(program, columns, {}, *kernels);
+        auto                       us = TimeUs([&]() { evaluator.Run(0, rows, output.data()); });
+        std::cout << std::setw(10) << std::fixed << std::setprecision(1) << rows / us
+                  << " M rows/s" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+// Rows per second of parallel batch evaluation from 1 thread to all hardware threads
+static void BenchParallel(size_t rows) {
+    exp_solver::ExpSolver solver;
+    solver.UpdateVariable("x", 0);
+    solver.UpdateVariable("y", 0);
+    auto x       = solver.GetVariableHandle("x");
+    auto y       = solver.GetVariableHandle("y");
+    auto program = solver.Compile("(x*0.75+y)*(x-y)/(1+x*x)-sqrt(abs(y))+floor(x/3)");
+
+    std::vector<double> xs(rows), ys(rows), output(rows);
+    for (size_t i = 0; i < rows; i++) {
+        xs[i] = static_cast<double>(i % 1000) * 0.5;
+        ys[i] = static_cast<double>(i % 77) - 30.25;
+    }
+    std::vector<const double *> columns(std::max(x, y) + 1);
+    columns[x] = xs.data();
+    columns[y] = ys.data();
+
+    size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "parallel batch scaling" << std::endl;
+    std::cout << std::setw(10) << "threads" << std::setw(14) << "M rows/s" << std::setw(14)
+              << "speedup" << std::endl;
+    double single = 0;
+    for (size_t threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+        exp_solver::ThreadPool pool(threads);
+        auto us = TimeUs([&]() { solver.EvaluateBatch(program, columns, rows, output.data(), pool); });
+        if (threads == 1) single = us;
+        std::cout << std::setw(10) << threads << std::setw(14) << std::fixed << std::setprecision(1)
+                  << rows / us << std::setw(14) << single / us << std::endl;
+        if (threads == maxThreads) break;
+    }
+    std::cout << std::endl;
+}
+
+// Chains of 1000 exact fraction operations, like ratios of prices in cents
+static void BenchFractions(size_t chains) {
+    constexpr size_t chain_size = 1000;
+    // i % 4 picks *, +, -, /, ratio multiplied is divided back so the value stays exact
+    std::vector<exp_solver::Value> operands;
+    for (int64_t i = 0; i < static_cast<int64_t>(chain_size); i++) {
+        exp_solver::Fraction ratio((i / 4) % 13 + 2, (i / 4) % 11 + 3);
+        exp_solver::Fraction operand[] = { ratio, { i % 89 + 1, 100 }, { i % 61 + 1, 400 }, ratio };
+        operands.emplace_back(operand[i % 4]);
+    }
+
+    exp_solver::Value result;
+    auto us = TimeUs([&]() {
+        for (size_t c = 0; c < chains; c++) {
+            exp_solver::Value acc(static_cast<double>(c % 7));
+            for (size_t i = 0; i < chain_size; i++) {
+                switch (i % 4) {
+                    case 0: acc = acc * operands[i]; break;
+                    case 1: acc = acc + operands[i]; break;
+                    case 2: acc = acc - operands[i]; break;
+                    default: acc = acc / operands[i]; break;
+                }
+            }
+            result = acc;
+        }
+    });
+    auto fraction = result.GetFracValue();
+    std::cout << "fraction chains of " << chain_size << " operations: " << std::fixed
+              << std::setprecision(1) << us * 1000 / (chains * chain_size) << " ns/operation, "
+              << (result.IsDecimal() ? "inexact " : "exact ") << fraction.up << "/"
+              << fraction.down << std::endl
+              << std::endl;
+}
+
+// Evaluate and solve one arithmetic formula in rational and double mode
+static void BenchNumericModes(size_t times) {
+    const std::string formula = "(x*0.75+y)*(x-y)/(1+x*x)-y/3+x**3";
+    std::cout << "numeric modes" << std::endl;
+    std::cout << std::setw(10) << "mode" << std::setw(16) << "ns/evaluate" << std::setw(14)
+              << "ns/solve" << std::endl;
+    for (auto mode : { exp_solver::NumericMode::Rational, exp_solver::NumericMode::Double }) {
+        exp_solver::ExpSolver solver(mode);
+        solver.UpdateVariable("x", 0);
+        solver.UpdateVariable("y", 0);
+        auto x       = solver.GetVariableHandle("x");
+        auto y       = solver.GetVariableHandle("y");
+        auto program = solver.Compile(formula);
+
+        double sum = 0;
+        auto   evaluateUs = TimeUs([&]() {
+            for (size_t i = 0; i < times; i++) {
+                auto k = static_cast<int64_t>(i);
+                solver.UpdateVariable(x, exp_solver::Value(exp_solver::Fraction(k % 1000, 7)));
+                solver.UpdateVariable(y, exp_solver::Value(exp_solver::Fraction(k % 77, 4)));
+                sum += solver.Evaluate(program).GetValueDouble();
+            }
+        });
+        auto solveUs = TimeUs([&]() {
+            for (size_t i = 0; i < times / 10; i++) sum += solver.SolveExp(formula).GetValueDouble();
+        });
+        std::cout << std::setw(10)
+                  << (mode == exp_solver::NumericMode::Double ? "double" : "rational")
+                  << std::setw(16) << std::fixed << std::setprecision(1)
+                  << evaluateUs * 1000 / times << std::setw(14) << solveUs * 10000 / times
+                  << (sum == 0 ? " " : "") << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+// Time of evaluating one program in every number type with TypedEvaluator
+template <typename T>
+static void BenchTypedEvaluator(const char *name, const exp_solver::CompiledExpression &program,
+                                size_t times) {
+    exp_solver::TypedEvaluator<T> evaluator(program);
+    std::vector<T>                values(2);
+    T                             result{};
+    size_t                        succeeded = 0;
+    auto                          us        = TimeUs([&]() {
+        for (size_t i = 0; i < times; i++) {
+            values[0] = static_cast<T>(static_cast<int64_t>(i % 1000));
+            values[1] = static_cast<T>(static_cast<int64_t>(i % 77));
+            succeeded += evaluator.Evaluate(values, result);
+        }
+    });
+    std::cout << std::setw(10) << name << std::setw(16) << std::fixed << std::setprecision(1)
+              << us * 1000 / times << (succeeded == times ? "" : " failed") << std::endl;
+}
+
+static void BenchTypedEvaluators(size_t times) {
+    exp_solver::ExpSolver solver;
+    solver.UpdateVariable("x", 0);
+    solver.UpdateVariable("y", 0);
+    auto program = solver.Compile("(x*3+y)*(x-y)-y*7+x*x*x");
+    std::cout << "typed evaluator" << std::endl;
+    std::cout << std::setw(10) << "type" << std::setw(16) << "ns/evaluate" << std::endl;
+    BenchTypedEvaluator<exp_solver::Value>("Value", program, times);
+    BenchTypedEvaluator<double>("double", program, times);
+    BenchTypedEvaluator<float>("float", program, times);
+    BenchTypedEvaluator<int64_t>("int64_t", program, times);
+    std::cout << std::endl;
+}
+
+// Examples of README through the compiler and the bytecode VM, ns/solve repeats one example,
+// ns/evaluate runs its compiled program, one-shot cycles examples so every call compiles
+static void BenchReadmeExamples(size_t times) {
+    const std::vector<std::string> examples = { "1+1",
+                                                "1+((2-3*4)/5)**6%4",
+                                                "0.5+1/3",
+                                                "floor(ln(exp(e))+cos(2*pi))",
+                                                "x+y",
+                                                "x * 2 + 1",
+                                                "old_value - 10" };
+    exp_solver::ExpSolver          solver;
+    solver.UpdateVariable("x", 10);
+    solver.UpdateVariable("y", 20);
+    solver.UpdateVariable("old_value", 50);
+
+    double sum     = 0;
+    auto   solveUs = TimeUs([&]() {
+        for (size_t i = 0; i < times; i++) {
+            sum += solver.SolveExp(examples[i % examples.size()]).GetValueDouble();
+        }
+    });
+    std::cout << "README examples" << std::endl;
+    std::cout << std::setw(30) << "example" << std::setw(12) << "ns/solve" << std::setw(16)
+              << "ns/evaluate" << std::endl;
+    for (const auto &example : examples) {
+        auto exampleUs = TimeUs([&]() {
+            for (size_t i = 0; i < times; i++) sum += solver.SolveExp(example).GetValueDouble();
+        });
+        auto program    = solver.Compile(example);
+        auto evaluateUs = TimeUs([&]() {
+            for (size_t i = 0; i < times; i++) sum += solver.Evaluate(program).GetValueDouble();
+        });
+        std::cout << std::setw(30) << example << std::setw(12) << std::fixed
+                  << std::setprecision(1) << exampleUs * 1000 / times << std::setw(16)
+                  << evaluateUs * 1000 / times << std::endl;
+    }
+    std::cout << "one-shot SolveExp cycling examples: " << std::fixed << std::setprecision(1)
+              << solveUs * 1000 / times << " ns/solve" << (sum == 0 ? " " : "") << std::endl
+              << std::endl;
+}
+
+// Random expression like generated ones with about leaves numbers and variables,
+// over 16 variables named v0 to v15, values near 1 keep every result finite
+static std::string MachineExpression(size_t leaves, std::mt19937 &random) {
+    auto leaf = [&]() {
+        auto k = random() % 20;
+        return k < 16 ? "v" + std::to_string(k) : "0." + std::to_string(k - 11);
+    };
+    if (leaves <= 1) return leaf();
+    // sum of two subexpressions, or one scaled by a leaf
+    if (random() % 3 != 0) {
+        auto left = 1 + random() % (leaves - 1);
+        return "(" + MachineExpression(left, random) + (random() % 2 ? "+" : "-") +
+               MachineExpression(leaves - left, random) + ")";
+    }
+    return "(" + MachineExpression(leaves - 1, random) + (random() % 2 ? "*" : "/") + leaf() +
+           ")";
+}
+
+// Time of evaluating expressions of sizes in tokens with stack and register backends,
+// every size runs about instructions stack instructions in double, an eighth in Value
+static void BenchBackends(size_t instructions) {
+    std::cout << "backends" << std::endl;
+    std::cout << std::setw(8) << "tokens" << std::setw(8) << "stack" << std::setw(10)
+              << "register" << std::setw(12) << "ns/stack" << std::setw(14) << "ns/register"
+              << std::setw(12) << "ns/stack" << std::setw(14) << "ns/register" << std::endl;
+    std::cout << std::setw(64) << "in double" << std::setw(26) << "in Value" << std::endl;
+    std::mt19937 random(2026);
+    for (size_t size : { 16, 32, 64, 128, 256, 1024, 5000, 20000, 50000 }) {
+        // a leaf, an operator and a bracket pair make about 4 tokens
+        auto                  exp = MachineExpression(size / 4, random);
+        exp_solver::ExpSolver solvers[] = { exp_solver::ExpSolver(
+                                                exp_solver::NumericMode::Double),
+                                            exp_solver::ExpSolver() };
+        std::vector<exp_solver::CompiledExpression> programs;
+        for (auto &solver : solvers) {
+            for (int i = 0; i < 16; i++) {
+                solver.UpdateVariable("v" + std::to_string(i),
+                                      exp_solver::Value(exp_solver::Fraction(i + 3, i + 2)));
+            }
+            for (auto backend : { exp_solver::Backend::Stack, exp_solver::Backend::Register }) {
+                solver.SetBackend(backend);
+                programs.push_back(solver.Compile(exp));
+            }
+        }
+        std::cout << std::setw(8) << size << std::setw(8) << programs[0].GetCodeSize()
+                  << std::setw(10) << programs[1].GetRegisterCodeSize();
+        double sum = 0;
+        for (size_t i = 0; i < programs.size(); i++) {
+            auto &solver = solvers[i / 2];
+            auto  times  = instructions / programs[0].GetCodeSize() / (i < 2 ? 1 : 8) + 1;
+            auto  us     = TimeUs([&]() {
+                for (size_t k = 0; k < times; k++) {
+                    auto value = solver.Evaluate(programs[i]);
+                    sum += value.IsCalculable() ? value.GetValueDouble() : 1e300;
+                }
+            });
+            std::cout << std::setw(i % 2 ? 14 : 12) << std::fixed << std::setprecision(1)
+                      << us * 1000 / times;
+        }
+        std::cout << (sum > 1e299 ? " failed" : "") << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+// Pricing like formula in the interpreter, in native code and written in C++,
+// one row at a time and in batch
+static void BenchJit(size_t times, size_t rows) {
+    exp_solver::ExpSolver solver(exp_solver::NumericMode::Double);
+    for (const char *name : { "s", "k", "r", "t", "v" }) solver.UpdateVariable(name, 1);
+    auto program = solver.Compile(
+        "(s*exp(-0.01*t) - k*exp(-r*t)) * sqrt(t) + abs(s-k)/(1+v*v*t) + s*v*0.4*sqrt(t)");
+    auto native = [](const double *in) {
+        return (in[0] * std::exp(-0.01 * in[3]) - in[1] * std::exp(-in[2] * in[3])) *
+                   std::sqrt(in[3]) +
+               std::abs(in[0] - in[1]) / (1 + in[4] * in[4] * in[3]) +
+               in[0] * in[4] * 0.4 * std::sqrt(in[3]);
+    };
+    exp_solver::TypedEvaluator<double> interpreter(program);
+    exp_solver::JitFunction            jit(program);
+    std::cout << "jit, " << jit.GetCodeSize() << " bytes of code, batch width "
+              << jit.GetBatchWidth() << std::endl;
+    std::cout << std::setw(12) << "" << std::setw(14) << "interpreter" << std::setw(8) << "jit"
+              << std::setw(8) << "C++" << std::endl;
+
+    std::vector<double> values{ 100, 95, 0.03, 0.5, 0.2 };
+    double              result = 0, sum[3] = {};
+    auto                perRow = [&](const std::function<double()> &evaluate, double &total) {
+        return TimeUs([&]() {
+                   for (size_t i = 0; i < times; i++) {
+                       values[0] = 80 + static_cast<double>(i % 40);
+                       total += evaluate();
+                   }
+               }) *
+               1000 / times;
+    };
+    std::cout << std::setw(12) << "ns/row" << std::fixed << std::setprecision(1)
+              << std::setw(14)
+              << perRow([&]() { return interpreter.Evaluate(values, result) ? result : 0; },
+                        sum[0])
+              << std::setw(8)
+              << perRow([&]() { return jit.Evaluate(values, result) ? result : 0; }, sum[1])
+              << std::setw(8) << perRow([&]() { return native(values.data()); }, sum[2]);
+    auto differ = std::abs(sum[0] - sum[1]) + std::abs(sum[1] - sum[2]) > 1e-9 * std::abs(sum[2]);
+    std::cout << (differ ? " differ" : "") << std::endl;
+
+    std::vector<std::vector<double>> columns(values.size(), std::vector<double>(rows));
+    std::vector<const double *>      pointers;
+    for (size_t i = 0; i < rows; i++) {
+        for (size_t j = 0; j < values.size(); j++) columns[j][i] = values[j];
+        columns[0][i] = 80 + static_cast<double>(i % 40);
+        columns[3][i] = 0.1 + static_cast<double>(i % 19) * 0.1;
+    }
+    for (auto &column : columns) pointers.push_back(column.data());
+    std::vector<double> output(rows);
+    auto                batchUs = TimeUs(
+        [&]() { solver.EvaluateBatch(program, pointers, rows, output.data()); });
+    auto jitUs = TimeUs([&]() { jit.EvaluateBatch(pointers, values, rows, output.data()); });
+    auto nativeUs = TimeUs([&]() {
+        double in[5];
+        for (size_t i = 0; i < rows; i++) {
+            for (size_t j = 0; j < values.size(); j++) in[j] = pointers[j][i];
+            output[i] = native(in);
+        }
+    });
+    std::cout << std::setw(12) << "ns/batch row" << std::setw(14) << batchUs * 1000 / rows
+              << std::setw(8) << jitUs * 1000 / rows << std::setw(8) << nativeUs * 1000 / rows
+              << std::endl
+              << std::endl;
+}
+
+// Rules of aot_rules.txt run by their functions built ahead of time and by the
+// interpreter AotLibrary falls back to
+static void BenchAot(size_t times) {
+    std::ifstream     file(EXP_AOT_RULES_PATH);
+    std::stringstream text;
+    text << file.rdbuf();
+    exp_solver::ExpressionSet set;
+    std::string               error;
+    if (!exp_solver::ParseExpressionSet(text.str(), set, error)) {
+        std::cout << "fail: " << error << std::endl;
+        return;
+    }
+    exp_solver::AotLibrary native(set, EXP_AOT_RULES_LIBRARY);
+    exp_solver::AotLibrary interpreted(set, "");
+    if (!native.IsNative()) std::cout << "not native: " << native.GetLoadError() << std::endl;
+    std::cout << "ahead of time code" << std::endl;
+    std::cout << std::setw(12) << "rule" << std::setw(14) << "interpreter" << std::setw(8)
+              << "aot" << std::endl;
+
+    std::vector<double> values{ 3, 0.25, 4 };
+    for (const auto &named : set.expressions) {
+        auto   index  = native.Find(named.name);
+        double result = 0, sum[2] = {};
+        auto   perRow = [&](exp_solver::AotLibrary &library, double &total) {
+            return TimeUs([&]() {
+                       for (size_t i = 0; i < times; i++) {
+                           values[0] = 6 + static_cast<double>(i % 40);
+                           total += library.Evaluate(index, values, result) ? result : 0;
+                       }
+                   }) *
+                   1000 / times;
+        };
+        std::cout << std::setw(12) << named.name << std::fixed << std::setprecision(1)
+                  << std::setw(14) << perRow(interpreted, sum[0]) << std::setw(8)
+                  << perRow(native, sum[1]) << (sum[0] == sum[1] ? "" : " differ") << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+// Rule set of a long tail of expressions run twice and a few hot ones run many times,
+// every expression optimized when compiled, against tiers promoting the hot ones
+static void BenchTiering(size_t tail, size_t hotRuns) {
+    std::cout << "tiering, " << tail << " expressions run twice, 8 run " << hotRuns
+              << " times" << std::endl;
+    std::cout << std::setw(12) << "" << std::setw(10) << "us/tail" << std::setw(10) << "us/hot"
+              << std::endl;
+    std::mt19937             random(2026);
+    std::vector<std::string> tailTexts, hotTexts;
+    for (size_t i = 0; i < tail; i++) tailTexts.push_back(MachineExpression(12, random));
+    for (size_t i = 0; i < 8; i++) hotTexts.push_back(MachineExpression(24, random));
+
+    for (bool tiered : { false, true }) {
+        auto                  compiler = std::make_shared<exp_solver::BackgroundCompiler>();
+        exp_solver::ExpSolver solver;
+        for (int i = 0; i < 16; i++) {
+            solver.UpdateVariable("v" + std::to_string(i),
+                                  exp_solver::Value(exp_solver::Fraction(i + 3, i + 2)));
+        }
+        solver.SetCache(std::make_shared<exp_solver::ExpressionCache>(2 * tail));
+        if (tiered) solver.SetTiering(compiler);
+        double sum    = 0;
+        auto   tailUs = TimeUs([&]() {
+            for (int run = 0; run < 2; run++) {
+                for (const auto &text : tailTexts) sum += solver.SolveExp(text).GetValueDouble();
+            }
+        });
+        auto hotUs = TimeUs([&]() {
+            for (size_t i = 0; i < hotRuns; i++) {
+                for (const auto &text : hotTexts) sum += solver.SolveExp(text).GetValueDouble();
+            }
+        });
+        std::cout << std::setw(12) << (tiered ? "tiered" : "optimized") << std::setw(10)
+                  << std::fixed << std::setprecision(0) << tailUs << std::setw(10) << hotUs
+                  << (sum == sum ? "" : " failed") << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+int main() {
+    BenchBrackets("nested brackets", NestedBrackets, 1000000);
+    BenchBrackets("sibling brackets", SiblingBrackets, 100000);
+    BenchVariables(2000);
+    BenchFractions(10000);
+    BenchReadmeExamples(1000000);
+    BenchBackends(20000000);
+    BenchTiering(20000, 20000);
+    BenchNumericModes(1000000);
+    BenchTypedEvaluators(1000000);
+    BenchJit(10000000, 1000000);
+    BenchAot(10000000);
+    BenchBatch(1000000);
+    BenchSimd(10000000);
+    BenchParallel(10000000);
+    return 0;
+}
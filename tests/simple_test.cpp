@@ -46,5 +46,12 @@ int main() {
               << duration_cast<milliseconds>(steady_clock::now() - now).count() << "ms"
               << std::endl;
 
+    auto program = s.Compile("1+((2-3*4)/5)**6%4");
+    now          = steady_clock::now();
+    for (size_t i = 0; i < 10000; i++) { s.Evaluate(program); }
+    std::cout << "10000 time compiled calculate time used: "
+              << duration_cast<microseconds>(steady_clock::now() - now).count() << "us"
+              << std::endl;
+
     return 0;
 }
\ No newline at end of file
@@ -1,8 +1,81 @@
 #define CATCH_CONFIG_MAIN
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+#include <new>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <sstream>
 
 #include "catch.hpp"
 #include "exp_solver.h"
+// aot_rules.txt generated over Value by exp_codegen
+#include "aot_rules_value.h"
+
+// Count heap allocations of this thread while counting is set
+static thread_local bool   counting_allocations = false;
+static thread_local size_t allocations          = 0;
+
+// Every replaceable form of new and delete is replaced with malloc and free, so a
+// pointer from any form of new is freed by the matching delete. They are not inlined,
+// or the compiler sees free of a pointer from new once delete is inlined at its caller
+#if defined(__GNUC__)
+#    define EXP_TEST_NOINLINE __attribute__((noinline))
+#else
+#    define EXP_TEST_NOINLINE
+#endif
+EXP_TEST_NOINLINE static void *Allocate(size_t size) noexcept {
+    if (counting_allocations) allocations++;
+    return std::malloc(size ? size : 1);
+}
+EXP_TEST_NOINLINE static void Release(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void *operator new(size_t size) {
+    if (void *ptr = Allocate(size)) return ptr;
+    throw std::bad_alloc();
+}
+void *operator new[](size_t size) {
+    if (void *ptr = Allocate(size)) return ptr;
+    throw std::bad_alloc();
+}
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    return Allocate(size);
+}
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    return Allocate(size);
+}
+void operator delete(void *ptr) noexcept {
+    Release(ptr);
+}
+void operator delete[](void *ptr) noexcept {
+    Release(ptr);
+}
+void operator delete(void *ptr, size_t) noexcept {
+    Release(ptr);
+}
+void operator delete[](void *ptr, size_t) noexcept {
+    Release(ptr);
+}
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+    Release(ptr);
+}
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+    Release(ptr);
+}
+
+// Heap allocations made by func
+template <typename Func>
+static size_t CountAllocations(Func &&func) {
+    allocations          = 0;
+    counting_allocations = true;
+    func();
+    counting_allocations = false;
+    return allocations;
+}
 
 
 TEST_CASE("Simple expression") {
@@ -52,7 +125,6 @@ TEST_CASE("Wrong expression") {
 
     // wrong symbol
     CHECK(!exp.SolveExp("1++1").IsCalculable());
-    CHECK(!exp.SolveExp("1---1").IsCalculable());
     CHECK(!exp.SolveExp("1<>1").IsCalculable());
     CHECK(!exp.SolveExp("-1=1").IsCalculable());
     CHECK(!exp.SolveExp("1///1").IsCalculable());
@@ -65,7 +137,7 @@ TEST_CASE("Wrong expression") {
     CHECK(!exp.SolveExp("1ii").IsCalculable());
 
     /// wrong rules
-    CHECK(!exp.SolveExp("-1**-0.1").IsCalculable());
+    CHECK(!exp.SolveExp("(-1)**-0.1").IsCalculable());
     CHECK(!exp.SolveExp("1.1&1").IsCalculable());
     CHECK(!exp.SolveExp("1.1|1").IsCalculable());
     CHECK(!exp.SolveExp("1.1^1").IsCalculable());
@@ -105,6 +177,15 @@ TEST_CASE("Complex expression") {
 
     exp.UpdateVariable("a1", 6);
     CHECK(exp.SolveExp("a1 + 1").GetValueDouble() == 7);
+
+    // deep brackets are compiled without recursion
+    const size_t depth = 200000;
+    std::string  deep  = std::string(depth, '(') + "1";
+    for (size_t i = 0; i < depth; i++) deep += "+1)";
+    CHECK(exp.SolveExp(deep).GetValueDouble() == depth + 1);
+    CHECK(exp.SolveExp("sqrt(" + deep + "-1)").GetValueDouble() == Approx(std::sqrt(depth)));
+    CHECK(exp.SolveExp(deep.substr(1)).GetValueStr().empty());
+    CHECK(exp.SolveExp("(" + deep).GetValueStr().empty());
 }
 
 TEST_CASE("Priority expression") {
@@ -113,6 +194,20 @@ TEST_CASE("Priority expression") {
     CHECK(exp.SolveExp("~2**3").GetValueDouble() == -9);
     CHECK(exp.SolveExp("-2**3").GetValueDouble() == -8);
 
+    CHECK(exp.SolveExp("-2**4").GetValueDouble() == -16);
+    CHECK(exp.SolveExp("2**-1").GetValueDouble() == 0.5);
+    CHECK(exp.SolveExp("2**~1").GetValueDouble() == 0.25);
+    CHECK(exp.SolveExp("-3**-2").GetValueDouble() == Approx(-1.0 / 9));
+    CHECK(exp.SolveExp("2*-3**2").GetValueDouble() == -18);
+
+    // repeated negative sign
+    CHECK(exp.SolveExp("--1+1").GetValueDouble() == 2);
+    CHECK(exp.SolveExp("1---1").GetValueDouble() == 0);
+    CHECK(exp.SolveExp("-~1").GetValueDouble() == 2);
+    CHECK(exp.SolveExp("3*-(1+2)").GetValueDouble() == -9);
+    exp.UpdateVariable("x", 2);
+    CHECK(exp.SolveExp("-x*-x").GetValueDouble() == 4);
+
     // '~' '-' and '*' '/' '//' '%'
     CHECK(exp.SolveExp("3*-2").GetValueDouble() == -6);
     CHECK(exp.SolveExp("3*~2").GetValueDouble() == -9);
@@ -138,3 +233,1340 @@ TEST_CASE("Priority expression") {
     // combine, from low to high
     CHECK(exp.SolveExp("5|2^3<<2+2*2**2").GetValueDouble() == 3079);
 }
+
+TEST_CASE("Compiled expression") {
+    exp_solver::ExpSolver exp;
+
+    auto program = exp.Compile("1+((2-3*4)/5)**6%4");
+    REQUIRE(program.IsValid());
+    CHECK(exp.Evaluate(program).GetValueDouble() == 1);
+    // evaluate again
+    CHECK(exp.Evaluate(program).GetValueDouble() == 1);
+
+    program = exp.Compile("floor(ln(exp(e))+cos(2*pi))");
+    CHECK(exp.Evaluate(program).GetValueDouble() == 3);
+    program = exp.Compile("5|2^3<<2+2*2**2");
+    CHECK(exp.Evaluate(program).GetValueDouble() == 3079);
+    program = exp.Compile("3-2*4-1/8+9%2+1");
+    CHECK(exp.Evaluate(program).GetValueDouble() == Approx(-3.125));
+    program = exp.Compile("~2**3");
+    CHECK(exp.Evaluate(program).GetValueDouble() == -9);
+    program = exp.Compile("-2**-1--3");
+    CHECK(exp.Evaluate(program).GetValueDouble() == 2.5);
+
+    // variables are read on every evaluation
+    exp.UpdateVariable("x", 3);
+    exp.UpdateVariable("y", 4);
+    program = exp.Compile("(x+y)*x+y");
+    CHECK(exp.Evaluate(program).GetValueDouble() == 25);
+    exp.UpdateVariable("x", 5);
+    exp.UpdateVariable("y", 6);
+    CHECK(exp.Evaluate(program).GetValueDouble() == 61);
+    // compile also set current expression
+    CHECK(exp.ResolveExp().GetValueDouble() == 61);
+
+    // compile errors
+    CHECK(!exp.Compile("").IsValid());
+    CHECK(!exp.Compile("1++1").IsValid());
+    CHECK(!exp.Compile("undefined").IsValid());
+    CHECK(!exp.Compile("exp()").IsValid());
+    CHECK(!exp.Compile("sqrt+3").IsValid());
+    CHECK(!exp.Compile("(1+1").IsValid());
+    CHECK(!exp.Evaluate(exp_solver::CompiledExpression()).IsCalculable());
+
+    // evaluate errors
+    program = exp.Compile("sqrt(x-10)");
+    REQUIRE(program.IsValid());
+    CHECK(!exp.Evaluate(program).IsCalculable());
+    exp.UpdateVariable("x", 19);
+    CHECK(exp.Evaluate(program).GetValueDouble() == 3);
+    program = exp.Compile("10/(floor(pi)-3)");
+    CHECK(!exp.Evaluate(program).IsCalculable());
+}
+
+TEST_CASE("Many variables") {
+    exp_solver::ExpSolver exp;
+    for (int i = 0; i < 3000; i++) { exp.UpdateVariable("v" + std::to_string(i), i); }
+    CHECK(exp.SolveExp("v0+v1234+v2999").GetValueDouble() == 4233);
+    exp.UpdateVariable("v1234", -1);
+    CHECK(exp.ResolveExp().GetValueDouble() == 2998);
+    // prefix or suffix of a name is not the name
+    CHECK(!exp.SolveExp("v3000").IsCalculable());
+    CHECK(!exp.SolveExp("v").IsCalculable());
+    // constants and functions are still found
+    CHECK(exp.SolveExp("floor(pi)+v3").GetValueDouble() == 6);
+}
+
+TEST_CASE("Variable handle") {
+    exp_solver::ExpSolver exp;
+    CHECK(exp.GetVariableHandle("x") == -1);
+    exp.UpdateVariable("x", 1);
+    exp.UpdateVariable("y", 2);
+    auto x = exp.GetVariableHandle("x");
+    auto y = exp.GetVariableHandle("y");
+    REQUIRE(x >= 0);
+    REQUIRE(y >= 0);
+    CHECK(x != y);
+
+    auto program = exp.Compile("x*10+y");
+    CHECK(exp.Evaluate(program).GetValueDouble() == 12);
+    CHECK(exp.UpdateVariable(x, 3));
+    CHECK(exp.UpdateVariable(y, exp_solver::Value(0.5)));
+    CHECK(exp.Evaluate(program).GetValueDouble() == 30.5);
+    CHECK(exp.ResolveExp().GetValueDouble() == 30.5);
+
+    // handle is stable after adding other variables
+    for (int i = 0; i < 100; i++) { exp.UpdateVariable("v" + std::to_string(i), i); }
+    CHECK(exp.GetVariableHandle("x") == x);
+    CHECK(exp.UpdateVariable("x", 4));
+    CHECK(exp.Evaluate(program).GetValueDouble() == 40.5);
+
+    // invalid handle or value
+    CHECK(!exp.UpdateVariable(-1, 1));
+    CHECK(!exp.UpdateVariable(1000, 1));
+    CHECK(!exp.UpdateVariable(x, exp_solver::Value()));
+    CHECK(exp.Evaluate(program).GetValueDouble() == 40.5);
+}
+
+TEST_CASE("Batch evaluation") {
+    exp_solver::ExpSolver exp;
+    exp.UpdateVariable("x", 0);
+    exp.UpdateVariable("y", 2);
+    auto x = exp.GetVariableHandle("x");
+
+    // more rows than one chunk
+    const size_t        rows = 1000;
+    std::vector<double> xs(rows), output(rows);
+    for (size_t i = 0; i < rows; i++) xs[i] = static_cast<double>(i) - 500;
+    std::vector<const double *> columns(x + 1);
+    columns[x] = xs.data();
+
+    auto program = exp.Compile("(x*y+1)**2/4-sqrt(abs(x))+x%7-(x<<1)+~x//3");
+    REQUIRE(exp.EvaluateBatch(program, columns, rows, output.data()));
+    for (size_t i = 0; i < rows; i++) {
+        exp.UpdateVariable(x, static_cast<int>(xs[i]));
+        CHECK(output[i] == Approx(exp.Evaluate(program).GetValueDouble()));
+    }
+
+    // row fails to calculate get NaN
+    program = exp.Compile("sqrt(x)+(1&x)");
+    xs      = { 4, -4, 0.5 };
+    REQUIRE(exp.EvaluateBatch(program, columns, 3, output.data()));
+    CHECK(output[0] == 2);
+    CHECK(std::isnan(output[1]));
+    CHECK(std::isnan(output[2]));
+
+    // unbound variable use current value
+    program = exp.Compile("x*y");
+    exp.UpdateVariable("y", 3);
+    REQUIRE(exp.EvaluateBatch(program, columns, 3, output.data()));
+    CHECK(output[0] == 12);
+    CHECK(output[2] == 1.5);
+
+    CHECK(!exp.EvaluateBatch(exp_solver::CompiledExpression(), columns, 3, output.data()));
+
+    // rows agree with Evaluate in double, rows it rejects get NaN, not inf
+    exp_solver::ExpSolver fast(exp_solver::NumericMode::Double);
+    fast.UpdateVariable("x", 0);
+    xs = { 1, -3, 0, 2.5 };
+    for (const std::string &text : std::vector<std::string>{
+             "x << 63", "x << 64", "x >> 70", "1 / (x - x)", "(x - x) ** -1", "x // (x - x)",
+             "x ** 0.5", "x % (x - x)", "~x & 6 ^ x | 1" }) {
+        INFO(text);
+        program = fast.Compile(text);
+        REQUIRE(fast.EvaluateBatch(program, columns, xs.size(), output.data()));
+        for (size_t i = 0; i < xs.size(); i++) {
+            fast.UpdateVariable(x, exp_solver::Value(xs[i]));
+            auto expected = fast.Evaluate(program);
+            if (expected.IsCalculable()) {
+                CHECK(output[i] == expected.GetValueDouble());
+            } else {
+                CHECK(std::isnan(output[i]));
+            }
+        }
+    }
+}
+
+TEST_CASE("Batch SIMD kernels") {
+    using exp_solver::SimdLevel;
+    exp_solver::ExpSolver exp;
+    exp.UpdateVariable("x", 0);
+    exp.UpdateVariable("y", 0);
+    auto x       = exp.GetVariableHandle("x");
+    auto y       = exp.GetVariableHandle("y");
+    auto program = exp.Compile(
+        "round(x)+floor(x)*ceil(y)-abs(x)/sqrt(abs(y)+1)+(x+y)//(y-2.25)-round(-y)+(-x)");
+    REQUIRE(program.IsValid());
+
+    // odd row count to cover rest rows of every register width
+    const size_t        rows = 1003;
+    std::vector<double> xs(rows), ys(rows);
+    for (size_t i = 0; i < rows; i++) {
+        xs[i] = (static_cast<double>(i) - 500) / 4;
+        ys[i] = (static_cast<double>(i % 37) - 18) * 0.5;
+    }
+    std::vector<const double *> columns(std::max(x, y) + 1);
+    columns[x] = xs.data();
+    columns[y] = ys.data();
+
+    std::vector<double> expected(rows);
+    exp_solver::BatchEvaluator(program, columns, {},
+                               *exp_solver::GetBatchKernels(SimdLevel::Scalar))
+        .Run(0, rows, expected.data());
+    for (size_t i = 0; i < rows; i++) {
+        exp.UpdateVariable(x, exp_solver::Value(xs[i]));
+        exp.UpdateVariable(y, exp_solver::Value(ys[i]));
+        CHECK(expected[i] == Approx(exp.Evaluate(program).GetValueDouble()));
+    }
+
+    for (auto level : { SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512 }) {
+        auto kernels = exp_solver::GetBatchKernels(level);
+        if (!kernels) continue;
+        INFO(exp_solver::SimdLevelName(level));
+        std::vector<double> output(rows);
+        exp_solver::BatchEvaluator(program, columns, {}, *kernels).Run(0, rows, output.data());
+        // same IEEE operations, results are exactly the same
+        CHECK(output == expected);
+    }
+}
+
+TEST_CASE("Constant folding") {
+    exp_solver::ExpSolver exp;
+    exp.UpdateVariable("x", 2);
+
+    // constant only expression is one literal
+    auto program = exp.Compile("(3<<2)+1");
+    CHECK(program.GetCodeSize() == 1);
+    CHECK(exp.Evaluate(program).GetValueDouble() == 13);
+    program = exp.Compile("ln(e)*floor(2*pi)");
+    CHECK(program.GetCodeSize() == 1);
+    CHECK(exp.Evaluate(program).GetValueDouble() == 6);
+
+    // constant subtree next to variable
+    program = exp.Compile("x*(2*pi)+ln(e)");
+    CHECK(program.GetCodeSize() == 5);
+    CHECK(exp.Evaluate(program).GetValueDouble() == Approx(4 * M_PI + 1));
+
+    // fractions stay exact
+    program = exp.Compile("x+1/3+1/6");
+    CHECK(program.GetCodeSize() == 5);
+    exp.UpdateVariable("x", exp_solver::Value(exp_solver::Fraction(1, 2)));
+    auto result = exp.Evaluate(program);
+    CHECK(!result.IsDecimal());
+    CHECK(result.GetValueDouble() == 1);
+    program = exp.Compile("x+(1/3+1/6)");
+    CHECK(program.GetCodeSize() == 3);
+    CHECK(exp.Evaluate(program).GetFracValue().up == 1);
+    CHECK(exp.Evaluate(program).GetFracValue().down == 1);
+
+    // failed constant is still reported by evaluation
+    program = exp.Compile("x+sqrt(-1)");
+    REQUIRE(program.IsValid());
+    CHECK(!exp.Evaluate(program).IsCalculable());
+    program = exp.Compile("x+1/(floor(pi)-3)");
+    REQUIRE(program.IsValid());
+    CHECK(!exp.Evaluate(program).IsCalculable());
+}
+
+TEST_CASE("Common subexpression") {
+    exp_solver::ExpSolver exp;
+    exp.UpdateVariable("x", 3);
+    exp.UpdateVariable("y", 4);
+
+    auto program = exp.Compile("sqrt(x*x+y*y)+sqrt(x*x+y*y)/sqrt(x*x+y*y)");
+    REQUIRE(program.IsValid());
+    // *, *, +, sqrt for two repeats
+    CHECK(program.GetStats().dedupedNodes == 8);
+    CHECK(exp.Evaluate(program).GetValueDouble() == 6);
+    exp.UpdateVariable("x", 6);
+    exp.UpdateVariable("y", 8);
+    CHECK(exp.Evaluate(program).GetValueDouble() == 11);
+
+    // equal literal and constant share too
+    program = exp.Compile("(x+2.0)*(x+2)+pi*x-pi*x");
+    CHECK(program.GetStats().dedupedNodes == 2);
+    CHECK(exp.Evaluate(program).GetValueDouble() == Approx(64));
+
+    // different operator order is not the same
+    program = exp.Compile("x-y+(y-x)");
+    CHECK(program.GetStats().dedupedNodes == 0);
+    CHECK(exp.Evaluate(program).GetValueDouble() == 0);
+
+    // batch evaluation of shared subexpression
+    std::vector<double>         xs{ 3, 5, 8 }, output(3);
+    std::vector<const double *> columns(exp.GetVariableHandle("x") + 1);
+    columns[exp.GetVariableHandle("x")] = xs.data();
+    program                             = exp.Compile("(x*x-1)*(x*x-1)+(x*x-1)");
+    CHECK(program.GetStats().dedupedNodes == 4);
+    REQUIRE(exp.EvaluateBatch(program, columns, 3, output.data()));
+    CHECK(output == std::vector<double>{ 72, 600, 4032 });
+
+    // fold count
+    program = exp.Compile("x*(2*pi)");
+    CHECK(program.GetStats().nodes == 5);
+    CHECK(program.GetStats().foldedNodes == 1);
+}
+
+TEST_CASE("Expression cache") {
+    auto cache = std::make_shared<exp_solver::ExpressionCache>(4, 1);
+
+    exp_solver::ExpSolver exp;
+    exp.UpdateVariable("x", 2);
+    exp.SetCache(cache);
+    CHECK(exp.SolveExp("x*3+1").GetValueDouble() == 7);
+    CHECK(exp.SolveExp("x*3+1").GetValueDouble() == 7);
+    exp.UpdateVariable("x", 3);
+    CHECK(exp.ResolveExp().GetValueDouble() == 10);
+    auto stats = cache->GetStats();
+    CHECK(stats.hits == 1);
+    CHECK(stats.misses == 1);
+    CHECK(stats.size == 1);
+
+    // invalid expression is not cached
+    CHECK(!exp.SolveExp("x*").IsCalculable());
+    CHECK(!exp.GetErrorMessages().empty());
+    CHECK(cache->GetStats().size == 1);
+
+    // new variable changes version, so unknown name is compiled again
+    CHECK(!exp.SolveExp("x+y").IsCalculable());
+    auto version = exp.GetSymbolVersion();
+    exp.UpdateVariable("y", 1);
+    CHECK(exp.GetSymbolVersion() != version);
+    CHECK(exp.SolveExp("x+y").GetValueDouble() == 4);
+
+    // solvers with the same variables share programs
+    exp_solver::ExpSolver other;
+    other.UpdateVariable("x", 10);
+    other.UpdateVariable("y", 20);
+    other.SetCache(cache);
+    CHECK(other.GetSymbolVersion() == exp.GetSymbolVersion());
+    auto hits = cache->GetStats().hits;
+    CHECK(other.SolveExp("x+y").GetValueDouble() == 30);
+    CHECK(cache->GetStats().hits == hits + 1);
+    CHECK(other.CompileCached("x+y") == exp.CompileCached("x+y"));
+
+    // least recently used is evicted
+    for (auto text : { "x+1", "x+2", "x+3", "x+4" }) other.SolveExp(text);
+    stats = cache->GetStats();
+    CHECK(stats.size == 4);
+    CHECK(stats.evictions == 2);
+    cache->Clear();
+    CHECK(cache->GetStats().size == 0);
+
+    // many threads with own solver share one cache
+    cache = std::make_shared<exp_solver::ExpressionCache>(64);
+    std::vector<std::thread> threads;
+    std::vector<int>         failures(4, 0);
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t] {
+            exp_solver::ExpSolver solver;
+            solver.UpdateVariable("x", t);
+            solver.SetCache(cache);
+            for (int i = 0; i < 1000; i++) {
+                auto text = "x*" + std::to_string(i % 100);
+                if (solver.SolveExp(text).GetValueDouble() != t * (i % 100)) failures[t]++;
+            }
+        });
+    }
+    for (auto &thread : threads) thread.join();
+    CHECK(failures == std::vector<int>(4, 0));
+    stats = cache->GetStats();
+    CHECK(stats.hits + stats.misses == 4000);
+    CHECK(stats.misses >= 100);
+    CHECK(stats.size <= 64);
+}
+
+TEST_CASE("Evaluation context") {
+    exp_solver::ExpSolver exp;
+    exp.UpdateVariable("x", 1);
+    exp.UpdateVariable("y", 2);
+    const auto program = exp.Compile("(x+y)*(x+y)-sqrt(y)+pi");
+    REQUIRE(program.IsValid());
+    auto x = exp.GetVariableHandle("x");
+    auto y = exp.GetVariableHandle("y");
+
+    auto context = exp.CreateContext();
+    CHECK(context.GetVariableCount() == 2);
+    CHECK(context.Evaluate(program).GetValueDouble() == Approx(9 - std::sqrt(2.0) + M_PI));
+    // context keeps its own values
+    CHECK(context.SetVariable(x, 2));
+    CHECK(context.Evaluate(program).GetValueDouble() == Approx(16 - std::sqrt(2.0) + M_PI));
+    CHECK(exp.Evaluate(program).GetValueDouble() == Approx(9 - std::sqrt(2.0) + M_PI));
+
+    // errors are kept in context
+    CHECK(context.SetVariable(y, -1));
+    CHECK(!context.Evaluate(program).IsCalculable());
+    CHECK(!context.GetErrorMessages().empty());
+    CHECK(exp.GetErrorMessages().empty());
+    CHECK(!context.SetVariable(5, 1));
+
+    // context older than program misses variables
+    auto oldContext = exp.CreateContext();
+    exp.UpdateVariable("z", 1);
+    auto newProgram = exp.Compile("z+1");
+    CHECK(!oldContext.Evaluate(newProgram).IsCalculable());
+    CHECK(exp.CreateContext().Evaluate(newProgram).GetValueDouble() == 2);
+
+    // many threads evaluate the same program
+    std::vector<std::thread> threads;
+    std::vector<int>         failures(64, 0);
+    for (int t = 0; t < 64; t++) {
+        threads.emplace_back([&, t] {
+            auto local = exp.CreateContext();
+            local.SetVariable(y, 0);
+            for (int i = 0; i < 200; i++) {
+                local.SetVariable(x, t + i);
+                auto expected = (t + i) * (t + i) + M_PI;
+                if (local.Evaluate(program).GetValueDouble() != Approx(expected)) failures[t]++;
+            }
+        });
+    }
+    for (auto &thread : threads) thread.join();
+    CHECK(failures == std::vector<int>(64, 0));
+}
+
+TEST_CASE("Parallel batch evaluation") {
+    exp_solver::ExpSolver exp;
+    exp.UpdateVariable("x", 0);
+    exp.UpdateVariable("y", 0);
+    auto x       = exp.GetVariableHandle("x");
+    auto y       = exp.GetVariableHandle("y");
+    auto program = exp.Compile("(x*0.75+y)*(x-y)/(1+x*x)-sqrt(abs(y))+floor(x/3)");
+
+    const size_t        rows = 100000;
+    std::vector<double> xs(rows), ys(rows), serial(rows), parallel(rows);
+    for (size_t i = 0; i < rows; i++) {
+        xs[i] = static_cast<double>(i % 1000) * 0.5;
+        ys[i] = static_cast<double>(i % 77) - 30.25;
+    }
+    std::vector<const double *> columns(std::max(x, y) + 1);
+    columns[x] = xs.data();
+    columns[y] = ys.data();
+    REQUIRE(exp.EvaluateBatch(program, columns, rows, serial.data()));
+
+    for (size_t threads : { 1, 3, 8 }) {
+        exp_solver::ThreadPool pool(threads);
+        CHECK(pool.GetThreadCount() == threads);
+        // odd grain leaves a short last range
+        for (size_t grain : { 1000, 777, 100000 }) {
+            std::fill(parallel.begin(), parallel.end(), 0);
+            REQUIRE(exp.EvaluateBatch(program, columns, rows, parallel.data(), pool, grain));
+            CHECK(parallel == serial);
+        }
+    }
+
+    // every item runs exactly once, pool is reused between loops
+    exp_solver::ThreadPool pool(4);
+    std::atomic<int>       badWorkers{ 0 };
+    for (int round = 0; round < 20; round++) {
+        std::vector<int> hits(1001, 0);
+        pool.ParallelFor(hits.size(), 7, [&](size_t begin, size_t end, size_t worker) {
+            if (worker >= pool.GetThreadCount()) badWorkers++;
+            for (size_t i = begin; i < end; i++) hits[i]++;
+        });
+        CHECK(hits == std::vector<int>(1001, 1));
+    }
+    CHECK(badWorkers == 0);
+    bool ran = false;
+    pool.ParallelFor(0, 7, [&](size_t, size_t, size_t) { ran = true; });
+    CHECK(!ran);
+
+    exp_solver::CompiledExpression invalid;
+    CHECK(!exp.EvaluateBatch(invalid, columns, rows, parallel.data(), pool));
+}
+
+TEST_CASE("Zero allocation evaluation") {
+    const int             iterations = 1000000;
+    exp_solver::ExpSolver exp;
+    exp.UpdateVariable("x", 1);
+    auto x = exp.GetVariableHandle("x");
+
+    const std::string text    = "1+((2-3*4)/5)**6%4*x+(x*x-1)*(x*x-1)";
+    auto              program = exp.Compile(text);
+    REQUIRE(program.IsValid());
+    auto context = exp.CreateContext();
+
+    // warm up buffers
+    exp.Evaluate(program);
+    context.Evaluate(program);
+    exp.SolveExp(text);
+
+    double sum   = 0;
+    auto   count = CountAllocations([&] {
+        for (int i = 0; i < iterations; i++) {
+            exp.UpdateVariable(x, i % 100);
+            sum += exp.Evaluate(program).GetValueDouble();
+            context.SetVariable(x, i % 7);
+            sum += context.Evaluate(program).GetValueDouble();
+        }
+    });
+    CHECK(count == 0);
+    CHECK(sum > 0);
+
+    // solving the same text again reuses the lexer and stack buffers
+    count = CountAllocations([&] {
+        for (int i = 0; i < iterations / 10; i++) sum += exp.SolveExp(text).GetValueDouble();
+    });
+    CHECK(count == 0);
+
+    // cache hits neither compile nor copy the text
+    exp.SetCache(std::make_shared<exp_solver::ExpressionCache>(16));
+    exp.SolveExp(text);
+    count = CountAllocations([&] {
+        for (int i = 0; i < iterations / 10; i++) sum += exp.SolveExp(text).GetValueDouble();
+    });
+    CHECK(count == 0);
+}
+
+TEST_CASE("Compact value") {
+    using exp_solver::Value;
+    using exp_solver::ValueError;
+    STATIC_REQUIRE(sizeof(Value) <= 24);
+    STATIC_REQUIRE(std::is_trivially_copyable<Value>::value);
+
+    // values copy by memcpy
+    Value values[3] = { Value(std::string("1.25")), Value(0.1), Value(7) };
+    Value copies[3];
+    std::memcpy(copies, values, sizeof(values));
+    CHECK(copies[0].GetFracValue().up == 5);
+    CHECK(copies[0].GetFracValue().down == 4);
+    CHECK(copies[1].IsDecimal());
+    CHECK(copies[1].GetValueDouble() == 0.1);
+    CHECK(copies[2].GetValueDouble() == 7);
+
+    CHECK(Value(3).GetError() == ValueError::None);
+    CHECK(Value(std::string("1234567890123456.5")).GetError() == ValueError::NumberTooLarge);
+    CHECK((Value(1) % Value(0.5)).GetError() == ValueError::ModFloat);
+    CHECK(powv(Value(-1), Value(0.5)).GetError() == ValueError::NegativePower);
+    // error of operand is kept through operators
+    auto failed = Value(exp_solver::Fraction(1, 0));
+    CHECK(failed.GetError() == ValueError::DenominatorZero);
+    CHECK((Value(2) * failed + Value(1)).GetError() == ValueError::DenominatorZero);
+    CHECK(std::string(exp_solver::GetValueErrorText(ValueError::DenominatorZero)).find("zero") != std::string::npos);
+
+    exp_solver::ExpSolver exp;
+    CHECK(!exp.SolveExp("(1/0)+1").IsCalculable());
+    CHECK(exp.GetErrorMessages().find("Denominator is zero") != std::string::npos);
+}
+
+TEST_CASE("Error codes") {
+    using exp_solver::ErrorCode;
+    exp_solver::ExpSolver exp;
+    exp.UpdateVariable("x", 2);
+
+    CHECK(!exp.SolveExp("1 + foo * 2").IsCalculable());
+    REQUIRE(!exp.GetErrors().empty());
+    auto error = exp.GetErrors()[0];
+    CHECK(error.code == ErrorCode::UnknownName);
+    // offset in expression without spaces
+    CHECK(error.offset == 2);
+    CHECK(error.length == 3);
+    CHECK(exp.GetErrorMessages().find("String \"foo\" not recognized!") != std::string::npos);
+
+    CHECK(!exp.SolveExp("(1+2))").IsCalculable());
+    CHECK(exp.GetErrors()[0].code == ErrorCode::BracketsNotPaired);
+    CHECK(exp.GetErrors()[0].offset == 5);
+
+    CHECK(!exp.SolveExp("1/(x-2)").IsCalculable());
+    CHECK(exp.GetErrors().back().code == ErrorCode::CalculationAborted);
+    CHECK(exp.GetErrors().back().valueError == exp_solver::ValueError::DenominatorZero);
+
+    CHECK(exp.SolveExp("x+1").GetValueDouble() == 3);
+    CHECK(exp.GetErrors().empty());
+    CHECK(exp.GetErrorMessages().empty());
+
+    auto program = exp.Compile("sqrt(x-3)");
+    CHECK(!exp.Evaluate(program).IsCalculable());
+    CHECK(exp.GetErrors()[0].code == ErrorCode::NegativeSqrt);
+    auto context = exp.CreateContext();
+    CHECK(!context.Evaluate(program).IsCalculable());
+    CHECK(context.GetErrors()[0].code == ErrorCode::NegativeSqrt);
+    CHECK(context.GetErrorMessages().find("square root") != std::string::npos);
+
+    // failing again records codes without making text
+    const std::string invalid = "1/(x-2)+foo";
+    exp.SolveExp(invalid);
+    auto count = CountAllocations([&] {
+        for (int i = 0; i < 10000; i++) exp.SolveExp(invalid);
+        for (int i = 0; i < 10000; i++) exp.Evaluate(program);
+    });
+    CHECK(count == 0);
+    CHECK(exp.GetErrors()[0].code == ErrorCode::NegativeSqrt);
+}
+
+TEST_CASE("Overflow checked arithmetic") {
+    exp_solver::ExpSolver exp;
+    auto                  solve = [&](const std::string &text) {
+        auto value    = exp.SolveExp(text);
+        auto compiled = exp.Evaluate(exp.Compile(text));
+        CHECK(value.IsCalculable() == compiled.IsCalculable());
+        CHECK(value.GetValueStr() == compiled.GetValueStr());
+        return value;
+    };
+
+    // exact while the result fits int64
+    auto value = solve("10**18");
+    CHECK(!value.IsDecimal());
+    CHECK(value.GetFracValue().up == 1000000000000000000);
+    // overflowed products are reduced in 128 bits and stay exact
+    value = solve("(2**62)*4/8");
+    CHECK(!value.IsDecimal());
+    CHECK(value.GetFracValue().up == 2305843009213693952);
+    value = solve("123456789*987654321/987654321");
+    CHECK(value.GetFracValue().up == 123456789);
+    value = solve("1/9223372036854775807*9223372036854775807");
+    CHECK(value.GetFracValue().up == 1);
+    value = solve("(4611686018427387904/3)*(3/4611686018427387903)");
+    CHECK(value.GetFracValue().up == 4611686018427387904);
+    CHECK(value.GetFracValue().down == 4611686018427387903);
+
+    // too large for int64 becomes double instead of wrapping around
+    value = solve("10**19");
+    CHECK(value.IsDecimal());
+    CHECK(value.GetValueDouble() == 1e19);
+    CHECK(solve("3037000500*3037000500").GetValueDouble() == Approx(9.223372037e18));
+    CHECK(solve("9223372036854775807+1").GetValueDouble() == Approx(9.223372036854775808e18));
+    CHECK(solve("(1/3)**40").GetValueDouble() == Approx(std::pow(1.0 / 3, 40)));
+    CHECK(solve("1<<70").GetValueDouble() == std::ldexp(1.0, 70));
+    CHECK(solve("-1<<3").GetValueDouble() == -8);
+    CHECK(solve("1>>70").GetValueDouble() == 0);
+
+    // division and modulo by zero are errors, not crashes
+    CHECK(!solve("0/0").IsCalculable());
+    CHECK(!solve("0//0").IsCalculable());
+    CHECK(!solve("0**-1").IsCalculable());
+    CHECK(!solve("1%0").IsCalculable());
+    CHECK(exp.GetErrors().back().valueError == exp_solver::ValueError::ModZero);
+}
+
+TEST_CASE("Lazy fraction reduction") {
+    using exp_solver::Fraction;
+    using exp_solver::Value;
+
+    // results read out are reduced, even if reducing was skipped in between
+    auto value = Value(Fraction(1, 6)) + Value(Fraction(1, 3));
+    CHECK(value.GetFracValue().up == 1);
+    CHECK(value.GetFracValue().down == 2);
+    value = Value(Fraction(3, 4)) - Value(Fraction(3, 4));
+    CHECK(value.GetFracValue().up == 0);
+    CHECK(value.GetFracValue().down == 1);
+    CHECK(value.GetValueStr() == "0");
+
+    // unreduced integers still work with integer operators
+    value = Value(Fraction(1, 4)) * Value(Fraction(8, 1));
+    CHECK(value.GetValueStr() == "2");
+    CHECK((value << Value(Fraction(3, 1))).GetValueDouble() == 16);
+    CHECK((value % Value(Fraction(3, 1))).GetValueDouble() == 2);
+    CHECK((~value).GetValueStr() == "-3");
+    CHECK(!(Value(Fraction(1, 4)) * Value(Fraction(2, 1)) & Value(Fraction(1, 1))).IsCalculable());
+
+    // power of an unreduced fraction stays exact
+    value = powv(Value(Fraction(2, 3)) * Value(Fraction(3, 4)), Value(Fraction(40, 1)));
+    CHECK(!value.IsDecimal());
+    CHECK(value.GetFracValue().up == 1);
+    CHECK(value.GetFracValue().down == 1099511627776);
+
+    // long chain gives the same exact result as reducing every step
+    Value    acc(Fraction(0, 1));
+    Fraction expected(0, 1);
+    for (int64_t i = 1; i <= 1000; i++) {
+        acc = acc + Value(Fraction(i % 7, 100));
+        acc = acc * Value(Fraction(i % 5 + 1, i % 3 + 1));
+        acc = acc / Value(Fraction(i % 5 + 1, i % 3 + 1));
+        expected = Fraction(expected.up * 100 + (i % 7) * expected.down, expected.down * 100);
+    }
+    CHECK(!acc.IsDecimal());
+    CHECK(acc.GetFracValue().up == expected.up);
+    CHECK(acc.GetFracValue().down == expected.down);
+}
+
+TEST_CASE("Exact big rational mode") {
+    using exp_solver::BigInt;
+    using exp_solver::BigRational;
+
+    // small values stay inline, large ones spill to limbs and come back
+    BigInt big;
+    REQUIRE(BigInt::Parse("123456789012345678901234567890", 30, big));
+    CHECK(!big.IsSmall());
+    CHECK(big.ToString() == "123456789012345678901234567890");
+    auto back = big - (big - BigInt(42));
+    CHECK(back.IsSmall());
+    CHECK(back.GetSmall() == 42);
+    BigInt quotient, remainder;
+    BigInt::DivMod(big * big + BigInt(5), big, quotient, remainder);
+    CHECK(BigInt::Compare(quotient, big) == 0);
+    CHECK(remainder.GetSmall() == 5);
+    CHECK(BigInt(INT64_MIN).ToString() == "-9223372036854775808");
+
+    exp_solver::ExpSolver exp;
+    exp.UpdateVariable("x", exp_solver::Value(exp_solver::Fraction(1, 3)));
+    auto solve = [&](const std::string &text) {
+        auto value = exp.SolveExact(text);
+        if (!value.IsCalculable()) return std::string("fail");
+        return value.GetValueStr();
+    };
+
+    // beyond int64 and beyond 15 digits, no double on the way
+    CHECK(solve("123456789012345678901234567890.25 * 4") == "493827156049382715604938271561");
+    CHECK(solve("10**30/3 + x") == "1000000000000000000000000000001/3");
+    CHECK(solve("12345678901234567.5 - 12345678901234567") == "1/2");
+    CHECK(solve("2**64 // 3") == "6148914691236517205");
+    CHECK(solve("-7 // 2") == "-4");
+    CHECK(solve("(2**100 + 1) % 7") == "3");
+    CHECK(solve("1 << 100 >> 98") == "4");
+    CHECK(solve("~(2**70)") == "-1180591620717411303425");
+    CHECK(solve("(1/3)**-3") == "27");
+    CHECK(solve("0.1 + 0.2") == "3/10");
+    CHECK(exp.SolveExact("10**20/3").GetDecimalStr(2) == "33333333333333333333.33");
+    CHECK(exp.SolveExact("-2/3").GetDecimalStr(3) == "-0.667");
+
+    // functions and constants are computed in double
+    CHECK(exp.SolveExact("2**70").IsExact());
+    CHECK(!exp.SolveExact("sqrt(2)").IsExact());
+    CHECK(exp.SolveExact("pi").GetValueDouble() == Approx(3.14159265358979));
+
+    // errors are reported like Value
+    CHECK(solve("1/0") == "fail");
+    CHECK(exp.GetErrors().back().valueError == exp_solver::ValueError::DenominatorZero);
+    CHECK(solve("(2**70) & 1") == "fail");
+    CHECK(exp.GetErrors().back().valueError == exp_solver::ValueError::NumberTooLarge);
+    CHECK(solve("1.5 % 1") == "fail");
+    CHECK(solve("1..5") == "fail");
+
+    // exact program still runs in Value, with literals rounded to double
+    auto program = exp.CompileExact("10**20 + 1 - x");
+    CHECK(program.IsExact());
+    CHECK(exp.EvaluateExact(program).GetValueStr() == "300000000000000000002/3");
+    CHECK(exp.Evaluate(program).GetValueDouble() == Approx(1e20));
+    // plain program evaluates exactly too, from its Value literals
+    CHECK(exp.EvaluateExact(exp.Compile("2**62 * 4")).GetValueStr() == "18446744073709551616");
+}
+
+TEST_CASE("Double numeric mode", "[ExpSolver]") {
+    using exp_solver::NumericMode;
+    using exp_solver::ValueError;
+
+    exp_solver::ExpSolver rational;
+    exp_solver::ExpSolver fast(NumericMode::Double);
+    CHECK(rational.GetNumericMode() == NumericMode::Rational);
+    CHECK(fast.GetNumericMode() == NumericMode::Double);
+    for (auto *solver : { &rational, &fast }) {
+        solver->UpdateVariable("x", 3);
+        solver->UpdateVariable("y", exp_solver::Value(exp_solver::Fraction(1, 4)));
+    }
+
+    // same results as fractions, up to rounding
+    for (const char *text : { "(x*0.75+y)*(x-y)/(1+x*x)", "x**3 - y/3", "7 // 2 + 7 % 4",
+                              "1 << 4 >> 2", "(5 & 3) | (6 ^ 1)", "~x", "-x**2", "sqrt(x)*pi" }) {
+        auto expected = rational.SolveExp(text).GetValueDouble();
+        CHECK(fast.SolveExp(text).GetValueDouble() == Approx(expected));
+        auto program = fast.Compile(text);
+        CHECK(program.GetNumericMode() == NumericMode::Double);
+        CHECK(fast.Evaluate(program).GetValueDouble() == Approx(expected));
+        CHECK(fast.CreateContext().Evaluate(program).GetValueDouble() == Approx(expected));
+    }
+    CHECK(fast.SolveExp("1/3 + 1/3").IsDecimal());
+
+    // solving the same text again reuses the program, variables are read each time
+    CHECK(fast.SolveExp("x * 2").GetValueDouble() == 6);
+    fast.UpdateVariable("x", 5);
+    CHECK(fast.SolveExp("x * 2").GetValueDouble() == 10);
+    fast.UpdateVariable("z", 1);
+    CHECK(fast.SolveExp("x * 2 + z").GetValueDouble() == 11);
+    fast.SetExp("x + 1");
+    CHECK(fast.ResolveExp().GetValueDouble() == 6);
+
+    // errors are reported like Value
+    auto error = [&](const std::string &text) {
+        CHECK(!fast.SolveExp(text).IsCalculable());
+        REQUIRE(!fast.GetErrors().empty());
+        return fast.GetErrors().back().valueError;
+    };
+    CHECK(error("1/0") == ValueError::DenominatorZero);
+    CHECK(error("x/(x-5)") == ValueError::DenominatorZero);
+    CHECK(error("1.5 % 1") == ValueError::ModFloat);
+    CHECK(error("x % 0") == ValueError::ModZero);
+    CHECK(error("1 << 0.5") == ValueError::LeftShiftFloat);
+    CHECK(error("~0.5") == ValueError::InvertFloat);
+    CHECK(error("(-2) ** 0.5") == ValueError::NegativePower);
+    CHECK(error("0 ** -1") == ValueError::DenominatorZero);
+    CHECK(!fast.SolveExp("sqrt(-1)").IsCalculable());
+
+    // a shared cache keeps programs of both modes apart
+    auto cache = std::make_shared<exp_solver::ExpressionCache>(16);
+    exp_solver::ExpSolver first;
+    exp_solver::ExpSolver second(NumericMode::Double);
+    first.SetCache(cache);
+    second.SetCache(cache);
+    CHECK(!first.SolveExp("1/3").IsDecimal());
+    CHECK(second.SolveExp("1/3").IsDecimal());
+    CHECK(!first.SolveExp("1/3").IsDecimal());
+    CHECK(cache->GetStats().hits == 1);
+}
+
+// Integers modulo 1000000007, a number type of user for TypedEvaluator
+struct Modular {
+    int64_t value;
+};
+
+struct ModularPolicy {
+    static constexpr int64_t modulus = 1000000007;
+
+    static Modular FromValue(const exp_solver::Value &value, exp_solver::ValueError &error) {
+        auto fraction = value.GetFracValue();
+        if (value.IsDecimal() || fraction.down != 1) error = exp_solver::ValueError::ConvertFail;
+        return { (fraction.up % modulus + modulus) % modulus };
+    }
+    static exp_solver::Value ToValue(Modular a) { return exp_solver::Value(a.value); }
+    static Modular Apply(exp_solver::OpCode code, Modular a, Modular b,
+                         exp_solver::ValueError &error) {
+        switch (code) {
+            case exp_solver::OpCode::Add: return { (a.value + b.value) % modulus };
+            case exp_solver::OpCode::Sub: return { (a.value - b.value + modulus) % modulus };
+            case exp_solver::OpCode::Mul: return { a.value * b.value % modulus };
+            default:
+                error = exp_solver::ValueError::InvalidOperator;
+                return a;
+        }
+    }
+    static Modular Negate(Modular a, exp_solver::ValueError &) {
+        return { (modulus - a.value) % modulus };
+    }
+    static Modular Invert(Modular a, exp_solver::ValueError &error) {
+        error = exp_solver::ValueError::InvertFloat;
+        return a;
+    }
+    static Modular Call(double (*)(double), Modular a, exp_solver::ValueError &error) {
+        error = exp_solver::ValueError::ConvertFail;
+        return a;
+    }
+    static bool                   IsNegative(Modular) { return false; }
+    static exp_solver::ValueError ErrorOf(Modular) { return exp_solver::ValueError::None; }
+};
+
+TEST_CASE("Typed evaluator", "[ExpSolver]") {
+    using exp_solver::ErrorCode;
+    using exp_solver::TypedEvaluator;
+    using exp_solver::ValueError;
+
+    exp_solver::ExpSolver exp;
+    exp.UpdateVariable("x", 0);
+    exp.UpdateVariable("y", 0);
+    auto x = exp.GetVariableHandle("x");
+    auto y = exp.GetVariableHandle("y");
+
+    // same program in every number type
+    auto program = exp.Compile("(x + y) * 3 - x // 2");
+    {
+        TypedEvaluator<double> evaluator(program);
+        REQUIRE(evaluator.IsValid());
+        CHECK(evaluator.GetVariableCount() == 2);
+        std::vector<double> values(2);
+        values[x]     = 7.5;
+        values[y]     = 1;
+        double result = 0;
+        REQUIRE(evaluator.Evaluate(values, result));
+        CHECK(result == 22.5);
+    }
+    {
+        TypedEvaluator<float> evaluator(program);
+        std::vector<float> values{ 7.5f, 1.0f };
+        float              result = 0;
+        REQUIRE(evaluator.Evaluate(values, result));
+        CHECK(result == 22.5f);
+    }
+    {
+        TypedEvaluator<exp_solver::Value> evaluator(program);
+        std::vector<exp_solver::Value> values{ exp_solver::Value(exp_solver::Fraction(1, 3)),
+                                               exp_solver::Value(exp_solver::Fraction(1, 6)) };
+        exp_solver::Value result;
+        REQUIRE(evaluator.Evaluate(values, result));
+        CHECK(result.GetValueDouble() == 1.5);
+    }
+    {
+        TypedEvaluator<int64_t> evaluator(program);
+        std::vector<int64_t> values{ -7, 1 };
+        int64_t              result = 0;
+        REQUIRE(evaluator.Evaluate(values, result));
+        CHECK(result == -14);
+    }
+
+    // integer rules of bit operators
+    auto integer = [&](const std::string &text, std::vector<int64_t> values, int64_t &result) {
+        auto                    rule = exp.Compile(text);
+        TypedEvaluator<int64_t> evaluator(rule);
+        return evaluator.Evaluate(values, result) ? ValueError::None
+                                                  : evaluator.GetErrors().back().valueError;
+    };
+    int64_t result = 0;
+    CHECK(integer("(x & 255) << 8 | y >> 2", { 0x1234, 0xf0 }, result) == ValueError::None);
+    CHECK(result == 0x343c);
+    CHECK(integer("~x ^ y % 5", { 0, 13 }, result) == ValueError::None);
+    CHECK(result == -4);
+    CHECK(integer("x / y", { -7, 2 }, result) == ValueError::None);
+    CHECK(result == -4);
+    CHECK(integer("x ** 62 + y", { 2, 0 }, result) == ValueError::None);
+    CHECK(result == 4611686018427387904);
+    CHECK(integer("x ** -1", { -2, 0 }, result) == ValueError::None);
+    CHECK(result == -1);
+    CHECK(integer("abs(x)", { -9, 0 }, result) == ValueError::None);
+    CHECK(result == 9);
+    CHECK(integer("x ** 63", { 2, 0 }, result) == ValueError::NumberTooLarge);
+    CHECK(integer("x * y", { 3037000500, 3037000500 }, result) == ValueError::NumberTooLarge);
+    CHECK(integer("x << 62", { 2, 0 }, result) == ValueError::NumberTooLarge);
+    CHECK(integer("x % y", { 5, 0 }, result) == ValueError::ModZero);
+    CHECK(integer("x // y", { 5, 0 }, result) == ValueError::DenominatorZero);
+    CHECK(integer("sqrt(x)", { 2, 0 }, result) == ValueError::ConvertFail);
+
+    // literal not representable, like a folded fraction
+    auto                    halfProgram = exp.Compile("x + 1/2");
+    TypedEvaluator<int64_t> half(halfProgram);
+    CHECK(!half.IsValid());
+    CHECK(half.GetErrors().back().valueError == ValueError::ConvertFail);
+    auto                    invalidProgram = exp.Compile("x +");
+    TypedEvaluator<int64_t> invalid(invalidProgram);
+    CHECK(!invalid.IsValid());
+    std::vector<int64_t> one{ 1 };
+    TypedEvaluator<int64_t> missing(program);
+    CHECK(!missing.Evaluate(one, result));
+    CHECK(missing.GetErrors().back().code == ErrorCode::ContextMissesVariables);
+
+    // number type of user
+    auto                                   cube = exp.Compile("x * x * x - y");
+    TypedEvaluator<Modular, ModularPolicy> modular(cube);
+    REQUIRE(modular.IsValid());
+    Modular big{ 0 };
+    REQUIRE(modular.Evaluate({ { 123456789 }, { 5 } }, big));
+    CHECK(big.value == 123456789ll * 123456789 % 1000000007 * 123456789 % 1000000007 - 5);
+    auto                                   quotient = exp.Compile("x / y");
+    TypedEvaluator<Modular, ModularPolicy> division(quotient);
+    CHECK(!division.Evaluate({ { 1 }, { 1 } }, big));
+    CHECK(division.GetErrors().back().valueError == ValueError::InvalidOperator);
+}
+
+TEST_CASE("Bytecode VM", "[ExpSolver]") {
+    using exp_solver::ErrorCode;
+
+    exp_solver::ExpSolver exp;
+    exp.UpdateVariable("x", 10);
+    exp.UpdateVariable("y", 20);
+    exp.UpdateVariable("old_value", 50);
+
+    // one-shot programs are not optimized, results match optimized ones
+    for (const char *text :
+         { "1+1", "1+((2-3*4)/5)**6%4", "0.5+1/3", "floor(ln(exp(e))+cos(2*pi))", "x+y",
+           "x * 2 + 1", "old_value - 10", "10 - 2 - 3", "64 / 4 / 2", "2 ** 3 ** 2", "-3 - -2",
+           "~1 + 2", "(x+y)*(x+y)-x", "1 << 4 >> 2 | 3 & 6 ^ 1", "7 // 2 + 7 % 4" }) {
+        auto program = exp.Compile(text);
+        auto solved  = exp.SolveExp(text);
+        REQUIRE(solved.IsCalculable());
+        CHECK(exp.Evaluate(program).GetValueStr() == solved.GetValueStr());
+    }
+    CHECK(exp.SolveExp("10 - 2 - 3").GetValueDouble() == 5);
+    CHECK(exp.SolveExp("64 / 4 / 2").GetValueDouble() == 8);
+
+    // operators are resolved while lexing, unknown ones fail before running
+    for (const char *text : { "1 +* 2", "1 ** * 2", "3 <<< 1" }) {
+        CHECK(!exp.SolveExp(text).IsCalculable());
+        REQUIRE(!exp.GetErrors().empty());
+        CHECK(exp.GetErrors().front().code == ErrorCode::InvalidOperator);
+        CHECK(!exp.Compile(text).IsValid());
+    }
+
+    // program of the latest text is reused, variables are read each time
+    CHECK(exp.SolveExp("x * y").GetValueDouble() == 200);
+    exp.UpdateVariable("x", 3);
+    CHECK(exp.SolveExp("x * y").GetValueDouble() == 60);
+    CHECK(exp.ResolveExp().GetValueDouble() == 60);
+    exp.SetExp("x - y");
+    CHECK(exp.ResolveExp().GetValueDouble() == -17);
+    exp.UpdateVariable("y", 1);
+    CHECK(exp.ResolveExp().GetValueDouble() == 2);
+    CHECK(!exp.SolveExp("sqrt(-x)").IsCalculable());
+    CHECK(exp.SolveExp("x * y").GetValueDouble() == 3);
+}
+
+TEST_CASE("Register backend", "[ExpSolver]") {
+    using exp_solver::Backend;
+    using exp_solver::ErrorCode;
+    using exp_solver::TypedEvaluator;
+    using exp_solver::ValueError;
+
+    exp_solver::ExpSolver stack, registers;
+    stack.SetBackend(Backend::Stack);
+    registers.SetBackend(Backend::Register);
+    for (auto *solver : { &stack, &registers }) {
+        solver->UpdateVariable("x", 3);
+        solver->UpdateVariable("y", exp_solver::Value(exp_solver::Fraction(1, 4)));
+    }
+
+    // same results as stack programs, shared subexpressions keep their slots
+    for (const char *text :
+         { "x", "7", "x + y", "(x+y)*(x+y)-x", "sqrt(x*x)+sqrt(x*x)", "-x ** 2 + ~3",
+           "((x-y)*(x+y))/((x-y)*(x+y)+1) - (x-y)*(x+y)", "x * x * x * x - y / x + 2",
+           "floor(x/y) << 2 | 5 & 6 ^ 1", "x * 2 + 1 - y * (x + 1) * (x - 2)" }) {
+        auto stackProgram    = stack.Compile(text);
+        auto registerProgram = registers.Compile(text);
+        CHECK(stackProgram.GetBackend() == Backend::Stack);
+        REQUIRE(registerProgram.GetBackend() == Backend::Register);
+        CHECK(registerProgram.GetRegisterCodeSize() < registerProgram.GetCodeSize());
+        auto expected = stack.Evaluate(stackProgram);
+        REQUIRE(expected.IsCalculable());
+        CHECK(registers.Evaluate(registerProgram).GetValueStr() == expected.GetValueStr());
+        CHECK(registers.CreateContext().Evaluate(registerProgram).GetValueStr() ==
+              expected.GetValueStr());
+        double                 value = 0;
+        TypedEvaluator<double> typed(registerProgram);
+        REQUIRE(typed.Evaluate({ 3, 0.25 }, value));
+        CHECK(value == Approx(expected.GetValueDouble()));
+    }
+
+    // errors are found in register programs too
+    auto error = [&](const std::string &text) {
+        auto program = registers.Compile(text);
+        CHECK(program.GetBackend() == Backend::Register);
+        CHECK(!registers.Evaluate(program).IsCalculable());
+        REQUIRE(!registers.GetErrors().empty());
+        return registers.GetErrors().back();
+    };
+    CHECK(error("y / (y - y) + x").valueError == ValueError::DenominatorZero);
+    CHECK(error("sqrt(y - x) + 1").code == ErrorCode::NegativeSqrt);
+    auto                    program = registers.Compile("x + y");
+    TypedEvaluator<int64_t> integer(program);
+    int64_t                 result = 0;
+    CHECK(integer.Evaluate({ 1, 2 }, result));
+    CHECK(result == 3);
+
+    // values of variables are read when evaluated
+    registers.UpdateVariable("x", 5);
+    CHECK(registers.Evaluate(registers.Compile("x * x - x")).GetValueDouble() == 20);
+
+    // large programs get registers by default, small and exact ones keep the stack
+    exp_solver::ExpSolver automatic;
+    automatic.UpdateVariable("x", 2);
+    std::string large = "x";
+    for (size_t i = 0; i < exp_solver::ExpSolver::register_threshold; i++) {
+        large += i % 2 ? "+x*" + std::to_string(i) : "-x";
+    }
+    CHECK(automatic.GetBackend() == Backend::Auto);
+    CHECK(automatic.Compile("x + 1").GetBackend() == Backend::Stack);
+    auto largeProgram = automatic.Compile(large);
+    CHECK(largeProgram.GetBackend() == Backend::Register);
+    CHECK(automatic.CompileExact(large).GetBackend() == Backend::Stack);
+    stack.UpdateVariable("x", 2);
+    auto expected = stack.Evaluate(stack.Compile(large)).GetValueStr();
+    CHECK(automatic.Evaluate(largeProgram).GetValueStr() == expected);
+    CHECK(automatic.SolveExp(large).GetValueStr() == expected);
+}
+
+TEST_CASE("JIT", "[ExpSolver]") {
+    using exp_solver::ErrorCode;
+    using exp_solver::JitFunction;
+    using exp_solver::SimdLevel;
+    using exp_solver::TypedEvaluator;
+    using exp_solver::ValueError;
+
+    exp_solver::ExpSolver exp(exp_solver::NumericMode::Double);
+    exp.UpdateVariable("x", 3);
+    exp.UpdateVariable("y", exp_solver::Value(exp_solver::Fraction(1, 4)));
+
+    // many terms alive at once are spilled out of xmm registers
+    std::string spilled = "sin(x)";
+    for (int i = 1; i < 24; i++) spilled = "(" + spilled + ")+sin(x*" + std::to_string(i) + "+y)";
+
+    // same results and errors as the interpreter, for inlined and called operators
+    for (const std::string &text : std::vector<std::string>{
+             "x", "7", "(x+y)*(x+y)-x/y", "-x ** 2 + ~3", "sqrt(x*x)+abs(-y)-ln(x)",
+             "floor(x/y) << 2 | 5 & 6 ^ 1", "x % 2 + x // y", "y / (y - y) + x", "sqrt(y - x) + 1",
+             "(x - 3) ** -1", "~y", spilled }) {
+        INFO(text);
+        auto program = exp.Compile(text);
+        REQUIRE(program.IsValid());
+        TypedEvaluator<double> interpreter(program);
+        JitFunction            jit(program);
+        CHECK(jit.IsNative() == (jit.GetCodeSize() > 0));
+        for (const std::vector<double> &values :
+             { std::vector<double>{ 3, 0.25 }, std::vector<double>{ 1.5, -2 } }) {
+            double expected = 0, result = 0;
+            bool   succeeded = interpreter.Evaluate(values, expected);
+            REQUIRE(jit.Evaluate(values, result) == succeeded);
+            if (succeeded) {
+                CHECK(result == Approx(expected));
+            } else {
+                REQUIRE(jit.GetErrors().size() == 1);
+                CHECK(jit.GetErrors()[0].code == interpreter.GetErrors()[0].code);
+                CHECK(jit.GetErrors()[0].valueError == interpreter.GetErrors()[0].valueError);
+            }
+        }
+    }
+    auto        program = exp.Compile("y / (y - y) + x");
+    JitFunction division(program);
+    double      result = 0;
+    CHECK(!division.Evaluate({ 3, 0.25 }, result));
+    CHECK(division.GetErrors()[0].valueError == ValueError::DenominatorZero);
+    CHECK(!division.Evaluate({ 3 }, result));
+    CHECK(division.GetErrors()[0].code == ErrorCode::ContextMissesVariables);
+
+    // batch rows are the rows of EvaluateBatch, a row count off the width covers the tail
+    auto                x    = exp.GetVariableHandle("x");
+    auto                y    = exp.GetVariableHandle("y");
+    const size_t        rows = 1003;
+    std::vector<double> xs(rows);
+    for (size_t i = 0; i < rows; i++) xs[i] = (static_cast<double>(i) - 500) / 4;
+    std::vector<const double *> columns(x + 1);
+    columns[x] = xs.data();
+    std::vector<double> scalars(std::max(x, y) + 1);
+    scalars[y] = 0.25;
+    for (const std::string &text : std::vector<std::string>{
+             "(x+y)*(x-y)/x - abs(x) + sqrt(x)", "x ** 2 - sin(x) * y", "x // 2 + x % 3",
+             spilled }) {
+        INFO(text);
+        program = exp.Compile(text);
+        std::vector<double> expected(rows);
+        REQUIRE(exp.EvaluateBatch(program, columns, rows, expected.data()));
+        for (auto level : { SimdLevel::Scalar, SimdLevel::SSE2, exp_solver::DetectSimdLevel() }) {
+            INFO(exp_solver::SimdLevelName(level));
+            JitFunction         jit(program, level);
+            std::vector<double> output(rows);
+            jit.EvaluateBatch(columns, scalars, rows, output.data());
+            for (size_t i = 0; i < rows; i++) {
+                if (std::isnan(expected[i])) {
+                    CHECK(std::isnan(output[i]));
+                } else {
+                    CHECK(output[i] == Approx(expected[i]));
+                }
+            }
+            // integer operators of batches are left to the interpreter
+            if (text == "x // 2 + x % 3" || level == SimdLevel::Scalar) {
+                CHECK(!jit.IsBatchNative());
+            }
+        }
+    }
+}
+
+TEST_CASE("Tiered execution", "[ExpSolver]") {
+    using exp_solver::Tier;
+
+    auto compiler = std::make_shared<exp_solver::BackgroundCompiler>();
+    exp_solver::ExpSolver exp;
+    exp.UpdateVariable("x", 3);
+    exp.UpdateVariable("y", exp_solver::Value(exp_solver::Fraction(1, 4)));
+    exp.SetTiering(compiler, 4);
+
+    // cheap program first, optimized one from the next run after threshold runs
+    const std::string text = "x * (2 + 3) + x * (2 + 3) - 1";
+    CHECK(exp.SolveExp(text).GetValueDouble() == 29);
+    CHECK(exp.GetTier() == Tier::Interpreted);
+    for (int i = 0; i < 3; i++) CHECK(exp.SolveExp(text).GetValueDouble() == 29);
+    compiler->Wait();
+    CHECK(compiler->GetCompletedCount() == 1);
+    exp.UpdateVariable("x", 4);
+    CHECK(exp.SolveExp(text).GetValueDouble() == 39);
+    CHECK(exp.GetTier() == Tier::Optimized);
+    CHECK(exp.ResolveExp().GetValueDouble() == 39);
+
+    // errors are the same in both tiers
+    for (int i = 0; i < 6; i++) {
+        CHECK(!exp.SolveExp("y / (y - y) + x").IsCalculable());
+        REQUIRE(!exp.GetErrors().empty());
+        CHECK(exp.GetErrors().back().valueError == exp_solver::ValueError::DenominatorZero);
+        compiler->Wait();
+    }
+    CHECK(exp.GetTier() == Tier::Optimized);
+
+    // ResolveExp is tiered too
+    exp.SetExp("x + 1");
+    CHECK(exp.ResolveExp().GetValueDouble() == 5);
+    CHECK(exp.GetTier() == Tier::Interpreted);
+    for (int i = 0; i < 4; i++) exp.ResolveExp();
+    compiler->Wait();
+    CHECK(exp.ResolveExp().GetValueDouble() == 5);
+    CHECK(exp.GetTier() == Tier::Optimized);
+
+    // a run past threshold still promotes when the variables change at threshold
+    exp_solver::ExpSolver growing;
+    growing.UpdateVariable("x", 3);
+    growing.SetTiering(compiler, 4);
+    growing.SetExp("x * (2 + 3)");
+    CHECK(growing.ResolveExp().GetValueDouble() == 15);
+    growing.UpdateVariable("y", 1);
+    for (int i = 0; i < 8; i++) CHECK(growing.ResolveExp().GetValueDouble() == 15);
+    compiler->Wait();
+    CHECK(growing.ResolveExp().GetValueDouble() == 15);
+    CHECK(growing.GetTier() == Tier::Optimized);
+
+    // solvers sharing a cache share counts, the optimized program replaces the cheap one
+    auto                  cache = std::make_shared<exp_solver::ExpressionCache>(64);
+    exp_solver::ExpSolver first, second;
+    for (auto *solver : { &first, &second }) {
+        solver->UpdateVariable("x", 2);
+        solver->SetCache(cache);
+        solver->SetTiering(compiler, 5);
+    }
+    for (int i = 0; i < 2; i++) CHECK(first.SolveExp("x ** 2 + x").GetValueDouble() == 6);
+    for (int i = 0; i < 2; i++) CHECK(second.SolveExp("x ** 2 + x").GetValueDouble() == 6);
+    auto cheap = first.CompileCached("x ** 2 + x");
+    CHECK(cheap->GetTier() == Tier::Interpreted);
+    CHECK(cheap->GetExecutionCount() == 4);
+    CHECK(second.SolveExp("x ** 2 + x").GetValueDouble() == 6);
+    compiler->Wait();
+    auto optimized = first.CompileCached("x ** 2 + x");
+    CHECK(optimized->GetTier() == Tier::Optimized);
+    CHECK(first.SolveExp("x ** 2 + x").GetValueDouble() == 6);
+    CHECK(first.GetTier() == Tier::Optimized);
+
+    // without tiering SolveExp compiles as before
+    first.SetTiering(nullptr);
+    CHECK(first.SolveExp("x - 1").GetValueDouble() == 1);
+    CHECK(first.CompileCached("x - 1")->GetTier() == Tier::Optimized);
+    exp_solver::ExpSolver plain;
+    CHECK(plain.SolveExp("1 + 1").GetValueDouble() == 2);
+    CHECK(plain.GetTier() == Tier::Interpreted);
+
+    // jobs run in order, pending ones are dropped with the compiler
+    std::vector<int> order;
+    compiler->Submit([&] { order.push_back(1); });
+    compiler->Submit([&] { order.push_back(2); });
+    compiler->Wait();
+    CHECK(order == std::vector<int>{ 1, 2 });
+}
+
+TEST_CASE("Ahead of time code", "[ExpSolver]") {
+    using exp_solver::AotLibrary;
+    using exp_solver::AotState;
+    using exp_solver::ErrorCode;
+    using exp_solver::ExpressionSet;
+    using exp_solver::Value;
+
+    std::ifstream     file(EXP_AOT_RULES_PATH);
+    std::stringstream text;
+    text << file.rdbuf();
+    ExpressionSet set;
+    std::string   error;
+    REQUIRE(exp_solver::ParseExpressionSet(text.str(), set, error));
+    CHECK(set.variables == std::vector<std::string>{ "x", "y", "z" });
+    REQUIRE(set.expressions.size() == 8);
+    CHECK(set.expressions[0].name == "linear");
+    CHECK(set.expressions[0].expression == "x * 2 + y / 4 - 1 / 3");
+
+    // malformed sets fail with the line of the problem
+    ExpressionSet bad;
+    for (const std::string &lines : std::vector<std::string>{
+             "variables: x x\na = x", "a = 1\na = 2", "1a = 2", "a 1", "a =", "# empty",
+             "variables: x\nvariables: y\na = x", "variables: x-y\na = 1" }) {
+        INFO(lines);
+        CHECK(!exp_solver::ParseExpressionSet(lines, bad, error));
+    }
+    exp_solver::ParseExpressionSet("variables: x\n\na = x\na = 2", bad, error);
+    CHECK(error.find("line 4") == 0);
+    // reserved words of C++ can't be names
+    for (const std::string &lines : std::vector<std::string>{
+             "variables: x\nnew = x + 1", "variables: x\nand = x", "variables: class\na = 1",
+             "variables: x\n__a = x", "variables: x\n_A = x" }) {
+        INFO(lines);
+        CHECK(!exp_solver::ParseExpressionSet(lines, bad, error));
+    }
+    CHECK(error.find("line 2") == 0);
+    CHECK(exp_solver::ParseExpressionSet("variables: x\nnew_x = x + 1\n_a = x", bad, error));
+
+    // any edit of set changes its hash
+    auto hash   = exp_solver::HashExpressionSet(set);
+    auto edited = set;
+    edited.expressions[0].expression += " + 0";
+    CHECK(exp_solver::HashExpressionSet(edited) != hash);
+    edited = set;
+    std::swap(edited.variables[0], edited.variables[1]);
+    CHECK(exp_solver::HashExpressionSet(edited) != hash);
+
+    // native functions and the fallback give the results and errors of the interpreter
+    AotLibrary native(set, EXP_AOT_RULES_LIBRARY);
+    INFO(native.GetLoadError());
+    REQUIRE(native.GetState() == AotState::Native);
+    AotLibrary missing(set, "missing_aot_rules.so");
+    CHECK(missing.GetState() == AotState::Missing);
+    CHECK(!missing.GetLoadError().empty());
+    CHECK(native.GetVariableCount() == 3);
+    std::vector<exp_solver::CompiledExpression> programs;
+    REQUIRE(exp_solver::CompileExpressionSet(set, exp_solver::NumericMode::Double,
+                                             exp_solver::Backend::Stack, programs, error));
+    for (const std::vector<double> &values :
+         { std::vector<double>{ 3, 0.25, -4 }, std::vector<double>{ 7.5, 2, 9 },
+           std::vector<double>{ -1.5, -6, 0 } }) {
+        for (size_t i = 0; i < programs.size(); i++) {
+            INFO(set.expressions[i].expression);
+            exp_solver::TypedEvaluator<double> interpreter(programs[i]);
+            double expected = 0, result = 0;
+            bool   succeeded = interpreter.Evaluate(values, expected);
+            for (auto *library : { &native, &missing }) {
+                REQUIRE(library->Evaluate(static_cast<int>(i), values, result) == succeeded);
+                if (succeeded) {
+                    CHECK(result == expected);
+                } else {
+                    REQUIRE(library->GetErrors().size() == 1);
+                    CHECK(library->GetErrors()[0].code == interpreter.GetErrors()[0].code);
+                    CHECK(library->GetErrors()[0].valueError ==
+                          interpreter.GetErrors()[0].valueError);
+                }
+            }
+        }
+    }
+    double result = 0;
+    CHECK(native.Find("nothing") == -1);
+    CHECK(!native.Evaluate(native.Find("nothing"), { 1, 2, 3 }, result));
+    CHECK(native.GetErrors()[0].code == ErrorCode::InvalidHandle);
+    CHECK(!native.Evaluate(native.Find("fails"), { 1, 2, 3 }, result));
+    CHECK(native.GetErrors()[0].valueError == exp_solver::ValueError::DenominatorZero);
+    CHECK(!native.Evaluate(native.Find("root"), { 1, 2, 3 }, result));
+    CHECK(native.GetErrors()[0].code == ErrorCode::NegativeSqrt);
+    CHECK(!native.Evaluate(native.Find("linear"), { 1 }, result));
+    CHECK(native.GetErrors()[0].code == ErrorCode::ContextMissesVariables);
+
+    // library of an edited set is stale, the edited expression is interpreted
+    edited                           = set;
+    edited.expressions[0].expression = "x * 3";
+    AotLibrary stale(edited, EXP_AOT_RULES_LIBRARY);
+    CHECK(stale.GetState() == AotState::Stale);
+    REQUIRE(stale.Evaluate(stale.Find("linear"), { 2, 0, 0 }, result));
+    CHECK(result == 6);
+    edited.expressions[0].expression = "x +* w";
+    AotLibrary invalid(edited, EXP_AOT_RULES_LIBRARY);
+    CHECK(invalid.GetState() == AotState::Invalid);
+    CHECK(!invalid.Evaluate(0, { 1, 2, 3 }, result));
+    CHECK(invalid.GetErrors()[0].code == ErrorCode::InvalidExpression);
+
+    // generator rejects sets it can't compile
+    exp_solver::CppGenerator generator;
+    std::ostringstream       source;
+    CHECK(!generator.Generate(edited, source));
+    CHECK(generator.GetError().find("linear") == 0);
+    CHECK(source.str().empty());
+    exp_solver::CppGenerator unnamed(exp_solver::CppGenerator::Signature::Double, "a b");
+    CHECK(!unnamed.Generate(set, source));
+    exp_solver::CppGenerator keyword(exp_solver::CppGenerator::Signature::Double, "class");
+    CHECK(!keyword.Generate(set, source));
+    CHECK(keyword.GetError() == "\"class\" is not a namespace name");
+
+    // functions over Value give the results of ExpSolver
+    using ValueFunction = Value (*)(const Value *, exp_solver::AotStatus &);
+    const ValueFunction functions[] = { exp_aot_value::linear,   exp_aot_value::bits,
+                                        exp_aot_value::trig,     exp_aot_value::shared,
+                                        exp_aot_value::fraction, exp_aot_value::constant,
+                                        exp_aot_value::fails,    exp_aot_value::root };
+    exp_solver::ExpSolver exp;
+    for (const std::vector<Value> &values :
+         { std::vector<Value>{ Value(3), Value(exp_solver::Fraction(1, 4)), Value(-4) },
+           std::vector<Value>{ Value(exp_solver::Fraction(15, 2)), Value(2), Value(9) },
+           std::vector<Value>{ Value(6), Value(exp_solver::Fraction(-7, 3)), Value(0.5) } }) {
+        for (size_t i = 0; i < set.variables.size(); i++) {
+            exp.UpdateVariable(set.variables[i], values[i]);
+        }
+        for (size_t i = 0; i < set.expressions.size(); i++) {
+            INFO(set.expressions[i].expression);
+            auto                  expected = exp.SolveExp(set.expressions[i].expression);
+            exp_solver::AotStatus status;
+            auto                  output = functions[i](values.data(), status);
+            REQUIRE(status.failed == !expected.IsCalculable());
+            if (!status.failed) CHECK(output.GetValueStr() == expected.GetValueStr());
+        }
+    }
+}
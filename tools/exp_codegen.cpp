@@ -0,0 +1,75 @@
+/*
+
+exp_codegen.cpp
+
+Author: SplitGemini
+Date Created: 10/16/26
+
+Description: Command line generator of C++ source
+from a file of named expressions, see CppGenerator.
+
+*/
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "exp_solver.h"
+
+using namespace std;
+
+static int Usage() {
+    cerr << "usage: exp_codegen [--value] [--namespace name] input output" << endl
+         << "  --value      functions over exp_solver::Value, built into a binary" << endl
+         << "               linking libexp_solver, default is double for AotLibrary" << endl
+         << "  --namespace  namespace of generated functions, default exp_aot" << endl;
+    return 2;
+}
+
+int main(int argc, char *argv[]) {
+    auto   signature = exp_solver::CppGenerator::Signature::Double;
+    string space     = "exp_aot", input, output;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--value") {
+            signature = exp_solver::CppGenerator::Signature::Value;
+        } else if (arg == "--namespace" && i + 1 < argc) {
+            space = argv[++i];
+        } else if (input.empty() && arg[0] != '-') {
+            input = arg;
+        } else if (output.empty() && arg[0] != '-') {
+            output = arg;
+        } else {
+            return Usage();
+        }
+    }
+    if (output.empty()) return Usage();
+
+    ifstream in(input);
+    if (!in) {
+        cerr << "exp_codegen: can't read " << input << endl;
+        return 1;
+    }
+    stringstream text;
+    text << in.rdbuf();
+    exp_solver::ExpressionSet set;
+    string                    error;
+    if (!exp_solver::ParseExpressionSet(text.str(), set, error)) {
+        cerr << input << ": " << error << endl;
+        return 1;
+    }
+
+    // generated in memory, so a failed run leaves no partial output
+    exp_solver::CppGenerator generator(signature, space);
+    stringstream             source;
+    if (!generator.Generate(set, source)) {
+        cerr << input << ": " << generator.GetError() << endl;
+        return 1;
+    }
+    ofstream out(output);
+    if (!(out << source.str())) {
+        cerr << "exp_codegen: can't write " << output << endl;
+        return 1;
+    }
+    return 0;
+}